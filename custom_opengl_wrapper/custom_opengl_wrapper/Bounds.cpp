@@ -0,0 +1,139 @@
+#include "Bounds.h"
+
+using gfx::engine::Bounds;
+
+// Bounds of the vertex positions, empty vertex data gives a point at the origin
+gfx::engine::Bounds_T Bounds::compute(std::vector<gfx::Vertex_T> * d)
+{
+	if (d->empty())
+		return from_box(glm::vec3(0.0f), glm::vec3(0.0f));
+
+	glm::vec3
+		min = (*d)[0].position,
+		max = (*d)[0].position;
+	for (gfx::Vertex_T & v : *d)
+	{
+		min = glm::min(min, v.position);
+		max = glm::max(max, v.position);
+	}
+
+	Bounds_T bounds = from_box(min, max);
+
+	// the sphere through the box corners is loose for round meshes, so shrink it to the furthest vertex from its center
+	float radius_sq = 0.0f;
+	for (gfx::Vertex_T & v : *d)
+	{
+		glm::vec3 offset = v.position - bounds.sphere.center;
+		radius_sq = glm::max(radius_sq, glm::dot(offset, offset));
+	}
+	bounds.sphere.radius = glm::sqrt(radius_sq);
+	return bounds;
+}
+
+// Bounds of a box, the sphere is the one through its corners
+gfx::engine::Bounds_T Bounds::from_box(glm::vec3 min, glm::vec3 max)
+{
+	Bounds_T bounds;
+	bounds.box.min = min;
+	bounds.box.max = max;
+	bounds.sphere.center = (min + max) * 0.5f;
+	bounds.sphere.radius = glm::length(max - min) * 0.5f;
+	return bounds;
+}
+
+// Bounds after a transform, the box is refitted around the transformed box so it stays axis aligned
+gfx::engine::Bounds_T Bounds::transform(Bounds_T bounds, glm::mat4 mat)
+{
+	// transform the center and add up the absolute contribution of each half extent (Arvo)
+	glm::vec3 center = (bounds.box.min + bounds.box.max) * 0.5f;
+	glm::vec3 extent = (bounds.box.max - bounds.box.min) * 0.5f;
+	glm::vec3 new_center = glm::vec3(mat * glm::vec4(center, 1.0f));
+	glm::vec3 new_extent =
+		glm::abs(glm::vec3(mat[0])) * extent.x +
+		glm::abs(glm::vec3(mat[1])) * extent.y +
+		glm::abs(glm::vec3(mat[2])) * extent.z;
+
+	Bounds_T result;
+	result.box.min = new_center - new_extent;
+	result.box.max = new_center + new_extent;
+
+	// the radius grows by the largest scale of any axis
+	float scale = glm::max(glm::length(glm::vec3(mat[0])), glm::max(glm::length(glm::vec3(mat[1])), glm::length(glm::vec3(mat[2]))));
+	result.sphere.center = glm::vec3(mat * glm::vec4(bounds.sphere.center, 1.0f));
+	result.sphere.radius = bounds.sphere.radius * scale;
+	return result;
+}
+
+// Bounds around both
+gfx::engine::Bounds_T Bounds::merge(Bounds_T a, Bounds_T b)
+{
+	Bounds_T result;
+	result.box.min = glm::min(a.box.min, b.box.min);
+	result.box.max = glm::max(a.box.max, b.box.max);
+
+	// smallest sphere around both spheres
+	glm::vec3 offset = b.sphere.center - a.sphere.center;
+	float distance = glm::length(offset);
+	if (distance + b.sphere.radius <= a.sphere.radius)
+	{
+		result.sphere = a.sphere;
+	}
+	else if (distance + a.sphere.radius <= b.sphere.radius)
+	{
+		result.sphere = b.sphere;
+	}
+	else
+	{
+		result.sphere.radius = (distance + a.sphere.radius + b.sphere.radius) * 0.5f;
+		result.sphere.center = a.sphere.center + offset * ((result.sphere.radius - a.sphere.radius) / distance);
+	}
+	return result;
+}
+
+// Frustum of a projection * view matrix, works for perspective and orthographic projections alike
+gfx::engine::Frustum_T Bounds::extract_frustum(glm::mat4 view_proj)
+{
+	// each plane is the w row plus or minus one of the other rows (Gribb & Hartmann), glm stores columns
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; ++i)
+		rows[i] = glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+
+	Frustum_T frustum;
+	frustum.planes[FRUSTUM_LEFT] = rows[3] + rows[0];
+	frustum.planes[FRUSTUM_RIGHT] = rows[3] - rows[0];
+	frustum.planes[FRUSTUM_BOTTOM] = rows[3] + rows[1];
+	frustum.planes[FRUSTUM_TOP] = rows[3] - rows[1];
+	frustum.planes[FRUSTUM_NEAR] = rows[3] + rows[2];
+	frustum.planes[FRUSTUM_FAR] = rows[3] - rows[2];
+
+	// normalised so distances to the planes are in world units, which the sphere test needs
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i)
+		frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+	return frustum;
+}
+
+// Whether any of the box may be inside the frustum, boxes near a corner can pass when they are just outside
+bool Bounds::is_visible(Frustum_T * frustum, AABB_T box)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i)
+	{
+		glm::vec3 normal = glm::vec3(frustum->planes[i]);
+		// distance of the box's center and of the corner furthest along the normal
+		float distance = glm::dot(normal, center) + frustum->planes[i].w;
+		float radius = glm::dot(glm::abs(normal), extent);
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+// Whether any of the sphere may be inside the frustum
+bool Bounds::is_visible(Frustum_T * frustum, BoundingSphere_T sphere)
+{
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i)
+		if (glm::dot(glm::vec3(frustum->planes[i]), sphere.center) + frustum->planes[i].w < -sphere.radius)
+			return false;
+	return true;
+}
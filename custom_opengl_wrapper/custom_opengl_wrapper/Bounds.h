@@ -0,0 +1,72 @@
+#pragma once
+
+#include "glm.h"
+#include "Types.h"
+#include <vector>
+
+// order of the planes in a Frustum_T
+#define FRUSTUM_LEFT 0
+#define FRUSTUM_RIGHT 1
+#define FRUSTUM_BOTTOM 2
+#define FRUSTUM_TOP 3
+#define FRUSTUM_NEAR 4
+#define FRUSTUM_FAR 5
+#define FRUSTUM_PLANE_COUNT 6
+
+namespace gfx
+{
+	namespace engine
+	{
+		struct AABB_T
+		{
+			glm::vec3 min;
+			glm::vec3 max;
+		};
+
+		struct BoundingSphere_T
+		{
+			glm::vec3 center;
+			float radius;
+		};
+
+		// Box and sphere around the same geometry, the sphere is the cheaper test and the box the tighter one
+		struct Bounds_T
+		{
+			AABB_T box;
+			BoundingSphere_T sphere;
+		};
+
+		// Planes as (normal, distance) with normals facing into the frustum,
+		// a point p is inside a plane when dot(normal, p) + distance >= 0
+		struct Frustum_T
+		{
+			glm::vec4 planes[FRUSTUM_PLANE_COUNT];
+		};
+
+		// Building, transforming and testing bounds
+		class Bounds
+		{
+		public:
+			// Bounds of the vertex positions, empty vertex data gives a point at the origin
+			static Bounds_T compute(std::vector<gfx::Vertex_T> * d);
+
+			// Bounds of a box, the sphere is the one through its corners
+			static Bounds_T from_box(glm::vec3 min, glm::vec3 max);
+
+			// Bounds after a transform, the box is refitted around the transformed box so it stays axis aligned
+			static Bounds_T transform(Bounds_T bounds, glm::mat4 mat);
+
+			// Bounds around both
+			static Bounds_T merge(Bounds_T a, Bounds_T b);
+
+			// Frustum of a projection * view matrix, works for perspective and orthographic projections alike
+			static Frustum_T extract_frustum(glm::mat4 view_proj);
+
+			// Whether any of the box may be inside the frustum, boxes near a corner can pass when they are just outside
+			static bool is_visible(Frustum_T * frustum, AABB_T box);
+
+			// Whether any of the sphere may be inside the frustum
+			static bool is_visible(Frustum_T * frustum, BoundingSphere_T sphere);
+		};
+	}
+}
@@ -3,6 +3,7 @@
 #include "VarHandle.h"
 #include "CLog.h"
 #include "StringFormat.h"
+#include "GLStateCache.h"
 
 using gfx::engine::FBO;
 
@@ -16,7 +17,9 @@ void FBO::get_frame_buffer(GLuint * FramebufferName, GLuint * colorTexture, GLui
 	CINFO("creating fbo...");
 
 	glGenFramebuffersEXT(1, FramebufferName);
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, *FramebufferName);
+	gfx::engine::GLStateCache::bindFramebuffer(*FramebufferName);
+	// the attachments are bound on whatever unit is active
+	gfx::engine::GLStateCache::invalidateTextures();
 
 	//RGBA8 2D texture, 24 bit depth texture
 	glGenTextures(1, colorTexture);
@@ -42,13 +45,12 @@ void FBO::get_frame_buffer(GLuint * FramebufferName, GLuint * colorTexture, GLui
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, m_width, m_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT, *depthTexture, 0);
 
-	GLuint depthBuffer;
 	// The depth buffer
-	glGenRenderbuffers(1, &depthBuffer);
-	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glGenRenderbuffers(1, &m_depth_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depth_buffer);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, m_width, m_height);
 	//Attach depth buffer to FBO
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth_buffer);
 	//Does the GPU support current FBO configuration?
 	GLenum status;
 	status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
@@ -65,6 +67,32 @@ void FBO::get_frame_buffer(GLuint * FramebufferName, GLuint * colorTexture, GLui
 	CINFO(alib::StringFormat("    FBO created: Tex %0 -> FBO %1").arg(m_tex).arg(m_id).str());
 }
 
+// Deletes the frame buffer and its attachments
+void FBO::release()
+{
+	// unbind first so the state shadow doesn't hold names that may be reused
+	unbind();
+	gfx::engine::GLStateCache::invalidateTextures();
+
+	glDeleteFramebuffers(1, &m_id);
+	glDeleteTextures(1, &m_tex);
+	glDeleteTextures(1, &m_depth);
+	glDeleteRenderbuffers(1, &m_depth_buffer);
+	m_id = m_tex = m_depth = m_depth_buffer = 0;
+
+	CINFO("    FBO released");
+}
+
+int FBO::get_width()
+{
+	return m_width;
+}
+
+int FBO::get_height()
+{
+	return m_height;
+}
+
 FBO::FBO() {};
 
 // Frame size
@@ -89,18 +117,13 @@ void FBO::set_render_mesh(gfx::engine::Mesh * mesh)
 // Binds FBO for render
 void FBO::bind()
 {
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_id);
+	gfx::engine::GLStateCache::bindFramebuffer(m_id);
 	//glClearDepth(1.0f);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
-	glBlendEquation(GL_FUNC_ADD);
-	glViewport(0, 0, m_width, m_height);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0.0, m_width, 0.0, m_height, -1.0, 1.0);
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	gfx::engine::GLStateCache::blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+	gfx::engine::GLStateCache::blendEquation(GL_FUNC_ADD);
+	gfx::engine::GLStateCache::viewport(0, 0, m_width, m_height);
 
 	//glDisable(GL_TEXTURE_2D);
 	//glDisable(GL_BLEND);
@@ -110,7 +133,7 @@ void FBO::bind()
 // Unbinds all FBOs
 void FBO::unbind()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gfx::engine::GLStateCache::bindFramebuffer(0);
 }
 
 // Gets texture for this FBO
@@ -158,21 +181,19 @@ void FBO::binding_draw_meshes(gfx::engine::MeshHandle_T handles)
 void FBO::activate_texture(gfx::engine::VarHandle * handle)
 {
 	handle->load(m_tex);
-	glActiveTexture(GL_TEXTURE0 + m_tex);
-	glBindTexture(GL_TEXTURE_2D, m_tex);
+	gfx::engine::GLStateCache::bindTexture(GL_TEXTURE0 + m_tex, GL_TEXTURE_2D, m_tex);
 }
 
 // Unload this FBOs texture from the shader
 void FBO::deactivate_texture()
 {
-	glActiveTexture(GL_TEXTURE0 + m_tex);
-	glBindTexture(GL_TEXTURE_2D, GL_TEXTURE0);
+	gfx::engine::GLStateCache::bindTexture(GL_TEXTURE0 + m_tex, GL_TEXTURE_2D, 0);
 }
 
 // Draw the texture on the render mesh (make sure ortho is used)
 void FBO::draw_render_mesh(gfx::engine::MeshHandle_T handles)
 {
+	// the texture stays bound to its own unit, so there is nothing to undo afterwards
 	activate_texture(handles.textureHandle);
 	m_render_mesh->draw(0, handles);
-	deactivate_texture();
 }
\ No newline at end of file
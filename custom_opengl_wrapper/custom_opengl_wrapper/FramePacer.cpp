@@ -0,0 +1,113 @@
+#include "FramePacer.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <chrono>
+
+using gfx::engine::FramePacer;
+
+namespace
+{
+	const char * CLASSNAME = "FramePacer";
+
+	// time slice to block for before re-checking the fence, in nanoseconds
+	const GLuint64 WAIT_TIMEOUT = 1000000;
+}
+
+// constructor
+FramePacer::FramePacer() {}
+
+FramePacer::FramePacer(int frames_in_flight)
+{
+	setFramesInFlight(frames_in_flight);
+}
+
+// Waits on the fence of the frame that is about to be reused
+void FramePacer::beginFrame()
+{
+	m_waitTime = 0.0f;
+
+	if (m_fences[m_index] == NULL)
+		return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	waitFence(m_index);
+	auto finish = std::chrono::high_resolution_clock::now();
+	m_waitTime = std::chrono::duration<float, std::milli>(finish - start).count();
+}
+
+// Blocks until the GPU has passed a fence then deletes it
+void FramePacer::waitFence(int index)
+{
+	GLsync fence = m_fences[index];
+	if (fence == NULL)
+		return;
+
+	// flush on the first wait so the fence is guaranteed to signal
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	GLenum result;
+	do
+	{
+		result = glClientWaitSync(fence, flags, WAIT_TIMEOUT);
+		flags = 0;
+	} while (result == GL_TIMEOUT_EXPIRED);
+
+	if (result == GL_WAIT_FAILED)
+	{
+		CERROR("glClientWaitSync failed", __FILE__, __LINE__, CLASSNAME, "waitFence");
+	}
+
+	glDeleteSync(fence);
+	m_fences[index] = NULL;
+}
+
+// Inserts a fence after the frame's commands have been submitted
+void FramePacer::endFrame()
+{
+	m_fences[m_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_index = (m_index + 1) % m_framesInFlight;
+}
+
+// Sets the number of frames allowed in flight (1-3)
+void FramePacer::setFramesInFlight(int frames)
+{
+	if (frames < 1 || frames > GFX_MAX_FRAMES_IN_FLIGHT)
+	{
+		CERROR(alib::StringFormat("frames in flight must be between 1 and %0, got %1")
+			.arg(GFX_MAX_FRAMES_IN_FLIGHT).arg(frames).str(), __FILE__, __LINE__, CLASSNAME, "setFramesInFlight");
+		frames = frames < 1 ? 1 : GFX_MAX_FRAMES_IN_FLIGHT;
+	}
+
+	// the ring is about to be resized and its slots renumbered, so let the GPU finish every frame still
+	// in flight first, otherwise the CPU could start writing into buffers those frames are still reading
+	for (int i = 0; i < GFX_MAX_FRAMES_IN_FLIGHT; ++i)
+		waitFence(i);
+	release();
+	m_framesInFlight = frames;
+	CINFO(alib::StringFormat("    frames in flight set to %0").arg(m_framesInFlight).str());
+}
+
+// Gets the number of frames allowed in flight
+int FramePacer::getFramesInFlight()
+{
+	return m_framesInFlight;
+}
+
+// Gets the time the CPU spent blocked on the last fence in milliseconds
+float FramePacer::getWaitTime()
+{
+	return m_waitTime;
+}
+
+// Deletes all outstanding fences
+void FramePacer::release()
+{
+	for (int i = 0; i < GFX_MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		if (m_fences[i] != NULL)
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+	m_index = 0;
+}
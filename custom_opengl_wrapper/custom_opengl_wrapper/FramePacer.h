@@ -0,0 +1,56 @@
+#pragma once
+
+#include "opengl.h"
+
+#define GFX_MAX_FRAMES_IN_FLIGHT 3
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Limits how many frames the CPU can queue ahead of the GPU using fence syncs
+		class FramePacer
+		{
+		public:
+			// Waits on the fence of the frame that is about to be reused
+			void beginFrame();
+
+			// Inserts a fence after the frame's commands have been submitted
+			void endFrame();
+
+			// Sets the number of frames allowed in flight (1-3)
+			void setFramesInFlight(int frames);
+
+			// Gets the number of frames allowed in flight
+			int getFramesInFlight();
+
+			// Gets the time the CPU spent blocked on the last fence in milliseconds
+			float getWaitTime();
+
+			// Deletes all outstanding fences
+			void release();
+
+
+			// constructor
+
+			FramePacer();
+
+			FramePacer(int frames_in_flight);
+
+		private:
+			// Blocks until the GPU has passed a fence then deletes it
+			void waitFence(int index);
+
+			// member variables 
+
+			GLsync m_fences[GFX_MAX_FRAMES_IN_FLIGHT] = {};
+
+			int
+				m_framesInFlight = 2,
+				m_index = 0;
+
+			float m_waitTime = 0.0f;
+
+		};
+	}
+}
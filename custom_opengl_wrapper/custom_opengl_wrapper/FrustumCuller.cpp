@@ -0,0 +1,144 @@
+#include "FrustumCuller.h"
+
+#if FRUSTUM_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+using gfx::engine::FrustumCuller;
+
+// constructor
+FrustumCuller::FrustumCuller() {}
+
+// Adds a box and returns its index, the index is what cull reports back
+int FrustumCuller::add(Bounds_T world_bounds)
+{
+	return add(world_bounds.box);
+}
+int FrustumCuller::add(AABB_T box)
+{
+	int index = m_count++;
+	int padded = (m_count + 3) & ~3;
+	if (padded > (int)m_center_x.size())
+	{
+		// padding boxes are empty and never reported
+		m_center_x.resize(padded, 0.0f);
+		m_center_y.resize(padded, 0.0f);
+		m_center_z.resize(padded, 0.0f);
+		m_extent_x.resize(padded, 0.0f);
+		m_extent_y.resize(padded, 0.0f);
+		m_extent_z.resize(padded, 0.0f);
+	}
+	set(index, box);
+	return index;
+}
+
+// Replaces the box at an index, for objects that have moved
+void FrustumCuller::set(int index, AABB_T box)
+{
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	m_center_x[index] = center.x;
+	m_center_y[index] = center.y;
+	m_center_z[index] = center.z;
+	m_extent_x[index] = extent.x;
+	m_extent_y[index] = extent.y;
+	m_extent_z[index] = extent.z;
+}
+
+// Removes every box
+void FrustumCuller::clear()
+{
+	// the arrays keep their capacity so refilling every frame doesn't allocate
+	m_center_x.clear();
+	m_center_y.clear();
+	m_center_z.clear();
+	m_extent_x.clear();
+	m_extent_y.clear();
+	m_extent_z.clear();
+	m_count = 0;
+}
+
+// Gets the number of boxes
+int FrustumCuller::size()
+{
+	return m_count;
+}
+
+// Gets how many boxes passed the last cull
+int FrustumCuller::get_visible_count()
+{
+	return m_visible_count;
+}
+
+// Appends the index of every box that may be in the frustum to visible, in index order
+void FrustumCuller::cull(Frustum_T * frustum, std::vector<int> * visible)
+{
+	int start = visible->size();
+	int i = 0;
+
+#if FRUSTUM_CULLER_SSE
+	__m128 plane_x[FRUSTUM_PLANE_COUNT], plane_y[FRUSTUM_PLANE_COUNT], plane_z[FRUSTUM_PLANE_COUNT], plane_w[FRUSTUM_PLANE_COUNT];
+	__m128 abs_x[FRUSTUM_PLANE_COUNT], abs_y[FRUSTUM_PLANE_COUNT], abs_z[FRUSTUM_PLANE_COUNT];
+	for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+	{
+		glm::vec4 plane = frustum->planes[p];
+		plane_x[p] = _mm_set1_ps(plane.x);
+		plane_y[p] = _mm_set1_ps(plane.y);
+		plane_z[p] = _mm_set1_ps(plane.z);
+		plane_w[p] = _mm_set1_ps(plane.w);
+		abs_x[p] = _mm_set1_ps(glm::abs(plane.x));
+		abs_y[p] = _mm_set1_ps(glm::abs(plane.y));
+		abs_z[p] = _mm_set1_ps(glm::abs(plane.z));
+	}
+	__m128 zero = _mm_setzero_ps();
+
+	// four boxes at a time, a box is out when the corner furthest along a plane's normal is behind it
+	for (; i + 4 <= m_count; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&m_center_x[i]);
+		__m128 cy = _mm_loadu_ps(&m_center_y[i]);
+		__m128 cz = _mm_loadu_ps(&m_center_z[i]);
+		__m128 ex = _mm_loadu_ps(&m_extent_x[i]);
+		__m128 ey = _mm_loadu_ps(&m_extent_y[i]);
+		__m128 ez = _mm_loadu_ps(&m_extent_z[i]);
+
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], cx), _mm_mul_ps(plane_y[p], cy)), _mm_add_ps(_mm_mul_ps(plane_z[p], cz), plane_w[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_x[p], ex), _mm_mul_ps(abs_y[p], ey)), _mm_mul_ps(abs_z[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int mask = ~_mm_movemask_ps(outside) & 0xF;
+		while (mask != 0)
+		{
+			int lane = 0;
+			while (!(mask & (1 << lane)))
+				++lane;
+			visible->push_back(i + lane);
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; i < m_count; ++i)
+		if (is_visible(frustum, i))
+			visible->push_back(i);
+
+	m_visible_count = visible->size() - start;
+}
+
+// scalar test used for the tail and when SSE isn't available
+bool FrustumCuller::is_visible(Frustum_T * frustum, int index)
+{
+	for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+	{
+		glm::vec4 plane = frustum->planes[p];
+		float distance = plane.x * m_center_x[index] + plane.y * m_center_y[index] + plane.z * m_center_z[index] + plane.w;
+		float radius = glm::abs(plane.x) * m_extent_x[index] + glm::abs(plane.y) * m_extent_y[index] + glm::abs(plane.z) * m_extent_z[index];
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
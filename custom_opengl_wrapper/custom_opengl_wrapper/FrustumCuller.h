@@ -0,0 +1,58 @@
+#pragma once
+
+#include "glm.h"
+#include "Bounds.h"
+#include <vector>
+
+// SSE is there on every x64 target, 32 bit builds need /arch:SSE or better
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define FRUSTUM_CULLER_SSE 1
+#else
+#define FRUSTUM_CULLER_SSE 0
+#endif
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Tests a batch of world space boxes against a frustum.
+		// Boxes are kept as separate center and extent arrays so four are tested against a plane
+		// with a handful of SSE instructions, which keeps thousands of boxes well under a millisecond.
+		class FrustumCuller
+		{
+		public:
+			// Adds a box and returns its index, the index is what cull reports back
+			int add(Bounds_T world_bounds);
+			int add(AABB_T box);
+
+			// Replaces the box at an index, for objects that have moved
+			void set(int index, AABB_T box);
+
+			// Removes every box
+			void clear();
+
+			// Gets the number of boxes
+			int size();
+
+			// Appends the index of every box that may be in the frustum to visible, in index order
+			void cull(Frustum_T * frustum, std::vector<int> * visible);
+
+			// Gets how many boxes passed the last cull
+			int get_visible_count();
+
+			FrustumCuller();
+
+		private:
+			// scalar test used for the tail and when SSE isn't available
+			bool is_visible(Frustum_T * frustum, int index);
+
+			// one entry per box, padded to a multiple of four so the SSE loop never reads past the end
+			std::vector<float>
+				m_center_x, m_center_y, m_center_z,
+				m_extent_x, m_extent_y, m_extent_z;
+
+			int m_count = 0;
+			int m_visible_count = 0;
+		};
+	}
+}
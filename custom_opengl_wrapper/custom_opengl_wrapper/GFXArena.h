@@ -0,0 +1,205 @@
+#pragma once
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// bytes per arena block, objects bigger than this get a block of their own
+#define GFX_ARENA_BLOCK_SIZE 65536
+// objects per pool block
+#define GFX_POOL_BLOCK_SIZE 64
+
+namespace gfx
+{
+	namespace gui
+	{
+		// Bump allocator that owns what it creates.
+		// Objects are packed into large blocks and never freed one by one, release() runs every
+		// destructor in reverse order of creation and frees the blocks in one go.
+		class GFXArena
+		{
+		public:
+			template <typename T, typename... Args>
+			T * create(Args&&... args)
+			{
+				T * object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+				if (!std::is_trivially_destructible<T>::value)
+					m_destructors.push_back({ object, &destroy<T> });
+				m_objects++;
+				return object;
+			}
+
+			// Raw aligned memory that lives until the arena is released
+			void * allocate(size_t size, size_t align)
+			{
+				uintptr_t top = (uintptr_t)m_top;
+				uintptr_t aligned = (top + align - 1) & ~(uintptr_t)(align - 1);
+				if (m_top == NULL || aligned + size > (uintptr_t)m_end)
+				{
+					size_t blockSize = size + align > GFX_ARENA_BLOCK_SIZE ? size + align : GFX_ARENA_BLOCK_SIZE;
+					char * block = new char[blockSize];
+					m_blocks.push_back(block);
+					m_top = block;
+					m_end = block + blockSize;
+					aligned = ((uintptr_t)m_top + align - 1) & ~(uintptr_t)(align - 1);
+				}
+				m_top = (char*)(aligned + size);
+				m_bytes += size;
+				return (void*)aligned;
+			}
+
+			// Destroys everything created in the arena and frees its memory
+			void release()
+			{
+				for (int ix = m_destructors.size() - 1; ix >= 0; --ix)
+					m_destructors[ix].destroy(m_destructors[ix].object);
+				m_destructors.clear();
+				for (char * block : m_blocks)
+					delete[] block;
+				m_blocks.clear();
+				m_top = m_end = NULL;
+				m_bytes = 0;
+				m_objects = 0;
+			}
+
+			// Frees the memory without running any destructor, for when what they'd clean up is already gone
+			void abandon()
+			{
+				m_destructors.clear();
+				release();
+			}
+
+			int getBlockCount()
+			{
+				return m_blocks.size();
+			}
+			size_t getBytesUsed()
+			{
+				return m_bytes;
+			}
+			int getObjectCount()
+			{
+				return m_objects;
+			}
+
+			GFXArena()
+			{
+			}
+			~GFXArena()
+			{
+				release();
+			}
+			GFXArena(const GFXArena &) = delete;
+			GFXArena & operator=(const GFXArena &) = delete;
+
+		private:
+			struct Destructor_T
+			{
+				void * object;
+				void(*destroy)(void *);
+			};
+
+			template <typename T>
+			static void destroy(void * object)
+			{
+				static_cast<T*>(object)->~T();
+			}
+
+			std::vector<char*> m_blocks;
+			std::vector<Destructor_T> m_destructors;
+			char
+				* m_top = NULL,
+				* m_end = NULL;
+			size_t m_bytes = 0;
+			int m_objects = 0;
+		};
+
+		// Fixed size slots for one type, allocated a block at a time.
+		// Unlike the arena, single objects can be destroyed and their slot is reused by the next create.
+		template <typename T>
+		class GFXPool
+		{
+		public:
+			template <typename... Args>
+			T * create(Args&&... args)
+			{
+				Slot_T * slot = m_free;
+				if (slot != NULL)
+				{
+					m_free = slot->next;
+				}
+				else
+				{
+					if (m_blocks.empty() || m_used == GFX_POOL_BLOCK_SIZE)
+					{
+						m_blocks.push_back(new Slot_T[GFX_POOL_BLOCK_SIZE]);
+						m_used = 0;
+					}
+					slot = &m_blocks.back()[m_used++];
+				}
+				slot->live = true;
+				m_count++;
+				return new (slot->storage) T(std::forward<Args>(args)...);
+			}
+
+			void destroy(T * object)
+			{
+				// the storage is the slot's first member so the object's address is the slot's
+				Slot_T * slot = reinterpret_cast<Slot_T*>(object);
+				object->~T();
+				slot->live = false;
+				slot->next = m_free;
+				m_free = slot;
+				m_count--;
+			}
+
+			// Destroys every live object and frees the blocks
+			void release()
+			{
+				for (int ib = 0; ib < m_blocks.size(); ++ib)
+				{
+					int used = ib + 1 == m_blocks.size() ? m_used : GFX_POOL_BLOCK_SIZE;
+					for (int is = 0; is < used; ++is)
+						if (m_blocks[ib][is].live)
+							reinterpret_cast<T*>(m_blocks[ib][is].storage)->~T();
+					delete[] m_blocks[ib];
+				}
+				m_blocks.clear();
+				m_free = NULL;
+				m_used = 0;
+				m_count = 0;
+			}
+
+			int size()
+			{
+				return m_count;
+			}
+
+			GFXPool()
+			{
+			}
+			~GFXPool()
+			{
+				release();
+			}
+			GFXPool(const GFXPool &) = delete;
+			GFXPool & operator=(const GFXPool &) = delete;
+
+		private:
+			struct Slot_T
+			{
+				alignas(T) unsigned char storage[sizeof(T)];
+				Slot_T * next = NULL;
+				bool live = false;
+			};
+
+			std::vector<Slot_T*> m_blocks;
+			Slot_T * m_free = NULL;
+			int m_used = 0;
+			int m_count = 0;
+		};
+	}
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "glm.h"
+#include "opengl.h"
+#include "GLSLProgram.h"
+#include "GLStateCache.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <vector>
+#include <cstddef>
+
+// how a batched vertex is shaded, matches the modes in gui_batch.frag
+#define GFX_GUI_SHADER_BLOCK 0
+#define GFX_GUI_SHADER_FONT 1
+#define GFX_GUI_SHADER_TEXTURE 2
+// a premultiplied window layer being composited
+#define GFX_GUI_SHADER_LAYER 3
+
+#define GFX_BATCH_VERT_SHADER "shaders/gui_batch.vert"
+#define GFX_BATCH_FRAG_SHADER "shaders/gui_batch.frag"
+#define GFX_BATCH_INITIAL_VERTICES 6144
+
+// attribute locations of the batch vertex
+#define GFX_BATCH_ATTRIB_POSITION 0
+#define GFX_BATCH_ATTRIB_COLOR 1
+#define GFX_BATCH_ATTRIB_MODE 2
+#define GFX_BATCH_ATTRIB_UV 3
+
+namespace gfx
+{
+	namespace gui
+	{
+		// A pre-transformed GUI vertex as laid out in the stream buffer
+		struct GFXBatchVertex_T
+		{
+			glm::vec2 pos;
+			glm::vec2 uv;
+			GLubyte color[4];
+			GLfloat mode;
+		};
+
+		// Counts for the last frame drawn through a batch
+		struct GFXBatchStats_T
+		{
+			int draws, vertices;
+		};
+
+		// Collects the GUI's triangles into one streaming vertex buffer per frame.
+		// Vertices are transformed on the CPU and carry their own colour and shader mode,
+		// so a draw call is only issued when the texture or scissor changes (or at the end of the frame).
+		class GFXBatch
+		{
+		public:
+			// Starts a frame, the window size is needed to turn scissor rects into GL's bottom-up coordinates
+			void begin(glm::vec2 windowSize)
+			{
+				init();
+				m_windowSize = windowSize;
+				m_vertices.clear();
+				m_tex = GL_TEXTURE0;
+				m_scissors.clear();
+				m_stats = { 0, 0 };
+
+				// fresh storage each frame so writing never waits on last frame's draws
+				m_cursor = 0;
+				gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(GFXBatchVertex_T), NULL, GL_STREAM_DRAW);
+			}
+
+			// Appends a triangle list of (x, y, u, v) vertices transformed by the model matrix
+			void add(const glm::vec4 * verts, int count, glm::mat4 modelMat, glm::vec4 color, int mode, GLuint tex = GL_TEXTURE0)
+			{
+				// untextured vertices don't sample, so they can join whatever texture is pending
+				if (mode != GFX_GUI_SHADER_BLOCK)
+				{
+					if (tex != m_tex && m_tex != GL_TEXTURE0 && !m_vertices.empty())
+						flush();
+					m_tex = tex;
+				}
+
+				GFXBatchVertex_T v;
+				v.color[0] = toByte(color.r);
+				v.color[1] = toByte(color.g);
+				v.color[2] = toByte(color.b);
+				v.color[3] = toByte(color.a);
+				v.mode = mode;
+				for (int i = 0; i < count; ++i)
+				{
+					v.pos = glm::vec2(modelMat * glm::vec4(verts[i].x, verts[i].y, 0.0f, 1.0f));
+					v.uv = glm::vec2(verts[i].z, verts[i].w);
+					m_vertices.push_back(v);
+				}
+			}
+
+			// Clips everything added after this to a rect (x, y, w, h) in window coordinates
+			void setScissor(glm::vec4 rect)
+			{
+				if (m_scissorEnabled && rect == m_scissor)
+					return;
+				flush();
+				m_scissor = rect;
+				m_scissorEnabled = true;
+			}
+			void clearScissor()
+			{
+				if (!m_scissorEnabled)
+					return;
+				flush();
+				m_scissorEnabled = false;
+			}
+
+			// Clips everything added until the matching popScissor to the rect between two corners in a component's
+			// own space, mapped to the window by modelMat and kept inside any clip already pushed
+			void pushScissor(glm::mat4 modelMat, glm::vec2 from, glm::vec2 to)
+			{
+				glm::vec2 a = glm::vec2(modelMat * glm::vec4(from, 0.0f, 1.0f));
+				glm::vec2 b = glm::vec2(modelMat * glm::vec4(to, 0.0f, 1.0f));
+				glm::vec2 low = glm::min(a, b), high = glm::max(a, b);
+				if (!m_scissors.empty())
+				{
+					glm::vec4 outer = m_scissors.back();
+					low = glm::max(low, glm::vec2(outer.x, outer.y));
+					high = glm::max(low, glm::min(high, glm::vec2(outer.x + outer.z, outer.y + outer.w)));
+				}
+				m_scissors.push_back(glm::vec4(low, high - low));
+				setScissor(m_scissors.back());
+			}
+			// Goes back to the clip that was in place before the matching pushScissor
+			void popScissor()
+			{
+				if (m_scissors.empty())
+					return;
+				m_scissors.pop_back();
+				if (m_scissors.empty())
+					clearScissor();
+				else
+					setScissor(m_scissors.back());
+			}
+
+			// Draws what has been added since the last flush
+			void flush()
+			{
+				if (m_vertices.empty())
+					return;
+
+				int count = m_vertices.size();
+				gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				if (m_cursor + count > m_capacity)
+				{
+					// orphan into a bigger buffer, draws already issued keep the old storage
+					while (m_cursor + count > m_capacity)
+						m_capacity *= 2;
+					glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(GFXBatchVertex_T), NULL, GL_STREAM_DRAW);
+					m_cursor = 0;
+					CINFO(alib::StringFormat("    GUI batch buffer resized to %0 vertices").arg(m_capacity).str());
+				}
+				glBufferSubData(GL_ARRAY_BUFFER, m_cursor * sizeof(GFXBatchVertex_T), count * sizeof(GFXBatchVertex_T), m_vertices.data());
+
+				gfx::engine::GLStateCache::useProgram(m_program.getId());
+				if (m_tex != GL_TEXTURE0)
+				{
+					m_program.getTexHandle()->load(m_tex);
+					gfx::engine::GLStateCache::bindTexture(GL_TEXTURE0 + m_tex, GL_TEXTURE_2D, m_tex);
+				}
+				if (m_scissorEnabled)
+				{
+					gfx::engine::GLStateCache::enable(GL_SCISSOR_TEST);
+					glScissor(m_scissor.x, m_windowSize.y - m_scissor.y - m_scissor.w, m_scissor.z, m_scissor.w);
+				}
+				else
+				{
+					gfx::engine::GLStateCache::disable(GL_SCISSOR_TEST);
+				}
+
+				gfx::engine::GLStateCache::bindVertexArray(m_vao);
+				glDrawArrays(GL_TRIANGLES, m_cursor, count);
+
+				m_cursor += count;
+				m_stats.draws++;
+				m_stats.vertices += count;
+				m_vertices.clear();
+			}
+
+			// Flushes the rest of the frame and leaves the scissor test off
+			void end()
+			{
+				flush();
+				m_scissors.clear();
+				m_scissorEnabled = false;
+				gfx::engine::GLStateCache::disable(GL_SCISSOR_TEST);
+			}
+
+			GFXBatchStats_T getStats()
+			{
+				return m_stats;
+			}
+
+			GFXBatch()
+			{
+			}
+
+		private:
+			// Creates the program, buffer and VAO, deferred until first use as they need a context
+			void init()
+			{
+				if (m_vao != 0)
+					return;
+
+				CINFO("Initialising GUI batch...");
+				m_program = gfx::engine::GLSLProgram(GFX_BATCH_VERT_SHADER, GFX_BATCH_FRAG_SHADER);
+				m_program.setTexHandle();
+
+				m_capacity = GFX_BATCH_INITIAL_VERTICES;
+				glGenVertexArrays(1, &m_vao);
+				gfx::engine::GLStateCache::bindVertexArray(m_vao);
+				glGenBuffers(1, &m_buffer);
+				gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(GFXBatchVertex_T), NULL, GL_STREAM_DRAW);
+
+				GLsizei stride = sizeof(GFXBatchVertex_T);
+				glEnableVertexAttribArray(GFX_BATCH_ATTRIB_POSITION);
+				glVertexAttribPointer(GFX_BATCH_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GFXBatchVertex_T, pos));
+				glEnableVertexAttribArray(GFX_BATCH_ATTRIB_UV);
+				glVertexAttribPointer(GFX_BATCH_ATTRIB_UV, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GFXBatchVertex_T, uv));
+				glEnableVertexAttribArray(GFX_BATCH_ATTRIB_COLOR);
+				glVertexAttribPointer(GFX_BATCH_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(GFXBatchVertex_T, color));
+				glEnableVertexAttribArray(GFX_BATCH_ATTRIB_MODE);
+				glVertexAttribPointer(GFX_BATCH_ATTRIB_MODE, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GFXBatchVertex_T, mode));
+				gfx::engine::GLStateCache::bindVertexArray(0);
+
+				CINFO(alib::StringFormat("    buffered into VAO %0").arg(m_vao).str());
+			}
+
+			static GLubyte toByte(float f)
+			{
+				return (GLubyte)(glm::clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+
+			gfx::engine::GLSLProgram m_program;
+
+			std::vector<GFXBatchVertex_T> m_vertices;
+
+			GLuint
+				m_vao = 0,
+				m_buffer = 0,
+				m_tex = GL_TEXTURE0;
+
+			int
+				m_capacity = 0,
+				m_cursor = 0;
+
+			glm::vec2 m_windowSize;
+			glm::vec4 m_scissor;
+			bool m_scissorEnabled = false;
+			// clips pushed by the components being drawn, innermost last
+			std::vector<glm::vec4> m_scissors;
+
+			GFXBatchStats_T m_stats = { 0, 0 };
+		};
+	}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "glm.h"
+#include "opengl.h"
+#include "PrimativeGenerator.h"
+#include "GLStateCache.h"
+#include "ImageLoader.h"
+#include "TextureAtlas.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include "colors.h"
+#include <map>
+#include <string>
+
+// glyphs in a font sheet, one 16x16 grid of the first 256 characters
+#define GFX_FONT_GLYPH_COUNT 256
+// each glyph is a quad of two triangles
+#define GFX_FONT_GLYPH_VERTICES 6
+
+namespace gfx
+{
+	namespace gui
+	{
+		// A font sheet: the texture and one (x, y, u, v) quad per glyph for the GUI batch.
+		// Shared by every size of the same font file.
+		struct GFXGlyphAtlas_T
+		{
+			std::string file;
+			GLuint tex = GL_TEXTURE0;
+			std::vector<glm::vec4> glyphs;
+			int refs = 0;
+			// the texture belongs to a packed atlas and is shared with other fonts
+			bool packed = false;
+		};
+
+		// Per-size layout of a monospaced font in pixels
+		struct GFXFontMetrics_T
+		{
+			float
+				size,
+				advance,
+				lineHeight;
+		};
+
+		// A font at a size, what a GFXFont holds on to
+		struct GFXFontFace_T
+		{
+			GFXGlyphAtlas_T * atlas;
+			GFXFontMetrics_T metrics;
+			int refs = 0;
+		};
+
+		// Reference counted cache of fonts keyed by file and size.
+		// The texture and glyph quads are loaded once per file no matter how many widgets or sizes use it,
+		// and are deleted when the last face using them is released.
+		class GFXFontCache
+		{
+		public:
+			// Gets a face for a font file at a size, loading the atlas on first use
+			static GFXFontFace_T * acquire(const char * fontfile, int size)
+			{
+				FaceMap & faces = getFaces();
+				FaceKey key(fontfile, size);
+				FaceMap::iterator it = faces.find(key);
+				if (it == faces.end())
+				{
+					GFXFontFace_T face;
+					face.atlas = acquireAtlas(fontfile);
+					face.metrics.size = size;
+					face.metrics.advance = size / 2.0f;
+					face.metrics.lineHeight = size;
+					it = faces.insert({ key, face }).first;
+				}
+				it->second.refs++;
+				return &it->second;
+			}
+
+			// Releases a face, deleting it (and its atlas if nothing else uses it) once unreferenced
+			static void release(GFXFontFace_T * face)
+			{
+				if (face == NULL)
+					return;
+				FaceMap & faces = getFaces();
+				for (FaceMap::iterator it = faces.begin(); it != faces.end(); ++it)
+				{
+					if (&it->second != face)
+						continue;
+					if (--it->second.refs <= 0)
+					{
+						releaseAtlas(it->second.atlas);
+						faces.erase(it);
+					}
+					return;
+				}
+			}
+
+			// Number of font files currently loaded on the GPU
+			static int getAtlasCount()
+			{
+				return getAtlases().size();
+			}
+
+			// Fonts whose sheet was packed into this atlas take its texture and remap their glyphs into it,
+			// so labels in different fonts don't split the GUI batch. Set it before the fonts are first used.
+			static void setPackedAtlas(gfx::engine::TextureAtlas * atlas)
+			{
+				getPackedAtlas() = atlas;
+			}
+
+			// Number of font file and size pairs in use
+			static int getFaceCount()
+			{
+				return getFaces().size();
+			}
+
+		private:
+			typedef std::pair<std::string, int> FaceKey;
+			typedef std::map<FaceKey, GFXFontFace_T> FaceMap;
+			typedef std::map<std::string, GFXGlyphAtlas_T> AtlasMap;
+
+			// map nodes don't move, so pointers into them stay valid while other fonts come and go.
+			// The maps are never destroyed so fonts owned by a global GFXManager can still be released at exit.
+			static FaceMap & getFaces()
+			{
+				static FaceMap * faces = new FaceMap;
+				return *faces;
+			}
+			static AtlasMap & getAtlases()
+			{
+				static AtlasMap * atlases = new AtlasMap;
+				return *atlases;
+			}
+
+			// The atlas given to setPackedAtlas, owned by the caller
+			static gfx::engine::TextureAtlas *& getPackedAtlas()
+			{
+				static gfx::engine::TextureAtlas * packed = NULL;
+				return packed;
+			}
+
+			static GFXGlyphAtlas_T * acquireAtlas(const char * fontfile)
+			{
+				AtlasMap & atlases = getAtlases();
+				AtlasMap::iterator it = atlases.find(fontfile);
+				if (it == atlases.end())
+				{
+					CINFO(alib::StringFormat("Loading font atlas %0...").arg(fontfile).str());
+					GFXGlyphAtlas_T atlas;
+					atlas.file = fontfile;
+					loadTexture(&atlas);
+					loadGlyphs(&atlas);
+					it = atlases.insert({ atlas.file, atlas }).first;
+				}
+				it->second.refs++;
+				return &it->second;
+			}
+
+			static void releaseAtlas(GFXGlyphAtlas_T * atlas)
+			{
+				if (--atlas->refs > 0)
+					return;
+				CINFO(alib::StringFormat("Releasing font atlas %0").arg(atlas->file).str());
+				if (atlas->tex != GL_TEXTURE0 && !atlas->packed)
+				{
+					glDeleteTextures(1, &atlas->tex);
+					gfx::engine::GLStateCache::invalidateTextures();
+				}
+				getAtlases().erase(atlas->file);
+			}
+
+			// Loads image file into a texture
+			static void loadTexture(GFXGlyphAtlas_T * atlas)
+			{
+				// the batch samples a sampler2D, so only a GL_TEXTURE_2D atlas can be used
+				gfx::engine::TextureAtlas * packed = getPackedAtlas();
+				if (packed != NULL && packed->get_target() == GL_TEXTURE_2D && packed->find(atlas->file.c_str()) >= 0)
+				{
+					atlas->tex = packed->get_region(packed->find(atlas->file.c_str())).tex;
+					atlas->packed = true;
+					CINFO(alib::StringFormat("    %0 -> packed Texture ID %1").arg(atlas->file).arg(atlas->tex).str());
+				}
+				else if (!atlas->file.empty())
+				{
+					atlas->tex = alib::ImageLoader::loadTextureFromImage(atlas->file.c_str());
+					gfx::engine::GLStateCache::invalidateTextures();
+					CINFO(alib::StringFormat("    %0 -> Texture ID %1").arg(atlas->file).arg(atlas->tex).str());
+				}
+				else
+				{
+					CINFO("    no texture file loaded");
+				}
+			}
+
+			// Builds one quad per glyph
+			static void loadGlyphs(GFXGlyphAtlas_T * atlas)
+			{
+				std::vector<glm::vec3> v = gfx::PrimativeGenerator::generate_square_meshes(GFX_FONT_GLYPH_COUNT);
+				gfx::VertexData d = gfx::PrimativeGenerator::pack_object(&v, GEN_SQUAREUVS, gfx::WHITE);
+				if (atlas->packed)
+				{
+					gfx::engine::TextureAtlas * packed = getPackedAtlas();
+					gfx::engine::TextureAtlas::remap_uvs(&d, packed->get_region(packed->find(atlas->file.c_str())));
+				}
+				atlas->glyphs.resize(d.size());
+				for (int i = 0; i < d.size(); ++i)
+					atlas->glyphs[i] = glm::vec4(d[i].position.x, d[i].position.y, d[i].uv.x, d[i].uv.y);
+			}
+		};
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "glm.h"
+#include <vector>
+
+namespace gfx
+{
+	namespace gui
+	{
+		// Which way a box layout stacks its children
+		enum GFXLayoutDirection_T
+		{
+			GFX_LAYOUT_NONE,
+			GFX_LAYOUT_ROW,
+			GFX_LAYOUT_COLUMN
+		};
+
+		// Where children sit across the stacking direction
+		enum GFXLayoutAlign_T
+		{
+			GFX_ALIGN_START,
+			GFX_ALIGN_CENTER,
+			GFX_ALIGN_END,
+			GFX_ALIGN_STRETCH
+		};
+
+		// How a component wants to be sized by its parent's layout
+		struct GFXLayoutParams_T
+		{
+			// preferred size, taken from the component's size the first time it's measured if left at 0
+			glm::vec2 size = glm::vec2(0.0f);
+			glm::vec2 minSize = glm::vec2(0.0f);
+			// share of the leftover space along the stacking direction
+			float grow = 0.0f;
+		};
+
+		// One child as the layout sees it, measured size in and placement out
+		struct GFXLayoutItem_T
+		{
+			glm::vec2 measured;
+			float grow;
+			glm::vec2 pos;
+			glm::vec2 size;
+		};
+
+		// Stacks items in a row or column with padding around and spacing between them.
+		// Space left along the stacking direction is shared out by grow factor, like a flex box.
+		class GFXBoxLayout
+		{
+		public:
+			// Size needed to fit every item at its measured size
+			glm::vec2 measure(const std::vector<GFXLayoutItem_T> & items)
+			{
+				int main = getMainAxis();
+				glm::vec2 size = glm::vec2(0.0f);
+				for (int ix = 0; ix < items.size(); ++ix)
+				{
+					size[main] += items[ix].measured[main];
+					size[1 - main] = glm::max(size[1 - main], items[ix].measured[1 - main]);
+				}
+				if (!items.empty())
+					size[main] += m_spacing * (items.size() - 1);
+				return size + glm::vec2(m_padding * 2.0f);
+			}
+
+			// Places the items inside a box of the given size with its top left at the origin
+			void arrange(std::vector<GFXLayoutItem_T> & items, glm::vec2 origin, glm::vec2 size)
+			{
+				if (items.empty())
+					return;
+				int main = getMainAxis();
+				int cross = 1 - main;
+				glm::vec2 inner = glm::max(size - glm::vec2(m_padding * 2.0f), glm::vec2());
+
+				float used = m_spacing * (items.size() - 1);
+				float grow = 0.0f;
+				for (GFXLayoutItem_T & item : items)
+				{
+					used += item.measured[main];
+					grow += item.grow;
+				}
+				float free = glm::max(inner[main] - used, 0.0f);
+
+				float cursor = m_padding;
+				for (GFXLayoutItem_T & item : items)
+				{
+					item.size[main] = item.measured[main] + (grow > 0.0f ? free * item.grow / grow : 0.0f);
+					item.size[cross] = m_align == GFX_ALIGN_STRETCH ? inner[cross] : glm::min(item.measured[cross], inner[cross]);
+					item.pos[main] = cursor;
+					item.pos[cross] = m_padding;
+					if (m_align == GFX_ALIGN_CENTER)
+						item.pos[cross] += (inner[cross] - item.size[cross]) / 2.0f;
+					else if (m_align == GFX_ALIGN_END)
+						item.pos[cross] += inner[cross] - item.size[cross];
+					item.pos += origin;
+					cursor += item.size[main] + m_spacing;
+				}
+			}
+
+			bool isEnabled()
+			{
+				return m_direction != GFX_LAYOUT_NONE;
+			}
+			GFXLayoutDirection_T getDirection()
+			{
+				return m_direction;
+			}
+
+			GFXBoxLayout()
+			{
+			}
+			GFXBoxLayout(GFXLayoutDirection_T direction, float spacing = 0.0f, float padding = 0.0f, GFXLayoutAlign_T align = GFX_ALIGN_STRETCH)
+			{
+				m_direction = direction;
+				m_spacing = spacing;
+				m_padding = padding;
+				m_align = align;
+			}
+
+		private:
+			int getMainAxis()
+			{
+				return m_direction == GFX_LAYOUT_COLUMN ? 1 : 0;
+			}
+
+			GFXLayoutDirection_T m_direction = GFX_LAYOUT_NONE;
+			GFXLayoutAlign_T m_align = GFX_ALIGN_STRETCH;
+			float
+				m_spacing = 0.0f,
+				m_padding = 0.0f;
+		};
+	}
+}
@@ -1,6 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <new>
+#include <cstring>
+#include <type_traits>
+
+// bytes a delegate can hold inline, enough for an object and a member function pointer or a lambda capturing a few pointers
+#define GFX_DELEGATE_BUFFER_SIZE 32
 
 namespace gfx
 {
@@ -19,80 +25,165 @@ namespace gfx
 		template<typename T>
 		using GFXMemberVar = typename GFXTemplateStruct<T>::GFXVarType;
 
-		class IGFXMetaAction
+		// Something to call when a trigger fires: a function, a member function on an object or a small lambda.
+		// The callable is stored inline so making, copying and calling a delegate never allocates,
+		// which limits it to trivially copyable callables that fit in GFX_DELEGATE_BUFFER_SIZE bytes.
+		class GFXDelegate
 		{
 		public:
-			virtual void callback() = 0;
+			void operator()() const
+			{
+				if (m_invoke != NULL)
+					m_invoke(m_storage);
+			}
+
+			bool isBound() const
+			{
+				return m_invoke != NULL;
+			}
+
+			GFXDelegate()
+			{
+			}
+			GFXDelegate(GFXFuncPtr func)
+			{
+				bind([func]() { func(); });
+			}
+			template<typename T>
+			GFXDelegate(T * object, GFXMemberFunc<T> func)
+			{
+				bind([object, func]() { (object->*func)(); });
+			}
+			template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, GFXDelegate>::value>::type>
+			GFXDelegate(F func)
+			{
+				bind(func);
+			}
+
+		private:
+			template<typename F>
+			void bind(F func)
+			{
+				static_assert(sizeof(F) <= GFX_DELEGATE_BUFFER_SIZE, "callable is too big for a GFXDelegate");
+				static_assert(alignof(F) <= alignof(void*), "callable is over aligned for a GFXDelegate");
+				static_assert(std::is_trivially_copyable<F>::value, "GFXDelegate only holds trivially copyable callables");
+				new (m_storage) F(func);
+				m_invoke = &invoke<F>;
+			}
+
+			template<typename F>
+			static void invoke(const void * storage)
+			{
+				(*static_cast<const F*>(storage))();
+			}
+
+			alignas(void*) unsigned char m_storage[GFX_DELEGATE_BUFFER_SIZE];
+			void(*m_invoke)(const void *) = NULL;
 		};
-		template<typename T>
-		class GFXAction : public IGFXMetaAction
+
+		// Every delegate listening to one trigger
+		class GFXSignal
 		{
 		public:
-			void callback()
+			// Adds a listener, the returned index can be passed to disconnect
+			int connect(GFXDelegate delegate)
+			{
+				for (int ix = 0; ix < m_slots.size(); ++ix)
+					if (!m_slots[ix].isBound())
+					{
+						m_slots[ix] = delegate;
+						return ix;
+					}
+				m_slots.push_back(delegate);
+				return m_slots.size() - 1;
+			}
+			// Removes a listener, other listeners keep their index
+			void disconnect(int index)
 			{
-				if (m_isStatic)
-					m_func();
-				else
-					(m_object->*m_memberFunc)();
+				if (index >= 0 && index < m_slots.size())
+					m_slots[index] = GFXDelegate();
+			}
+			void disconnectAll()
+			{
+				m_slots.clear();
 			}
 
-			GFXAction(GFXFuncPtr func)
+			void fire() const
 			{
-				m_func = func;
-				m_isStatic = true;
+				// by index so listeners connected while firing don't invalidate the loop, they first hear the next fire
+				int count = m_slots.size();
+				for (int ix = 0; ix < count; ++ix)
+					m_slots[ix]();
 			}
-			GFXAction(T * object, GFXMemberFunc<T> func)
+
+			bool isEmpty() const
 			{
-				m_object = object;
-				m_memberFunc = func;
-				m_isStatic = false;
+				return m_slots.empty();
 			}
-		protected:
-			bool m_isStatic;
-			GFXFuncPtr m_func;
-			GFXMemberFunc<T> m_memberFunc;
-			T * m_object;
+
+			GFXSignal() {}
+		private:
+			std::vector<GFXDelegate> m_slots;
 		};
-		typedef IGFXMetaAction* GFXMetaAction;
-		static GFXMetaAction ACTION(GFXFuncPtr func)
-		{
-			return new GFXAction<class GFXNULL>(func);
-		}
-		template<typename T>
-		static GFXMetaAction ACTION(T * object, GFXMemberFunc<T> func)
-		{
-			return new GFXAction<T>(object, func);
-		}
 
-		template<typename T>
-		struct GFXTriggerPtr
+		// Signals fired during event checking, held until the frame's events have all been checked.
+		// Listeners then run outside the component tree's traversal, so they can safely add, remove or close components.
+		class GFXEventQueue
 		{
-			typedef void (T::*GFXTriggerFunc)(gfx::engine::GLContent *);
+		public:
+			void post(const GFXSignal * signal)
+			{
+				m_pending.push_back(signal);
+			}
+
+			// Fires everything queued in order, including anything queued by the listeners themselves
+			void dispatch()
+			{
+				for (int ix = 0; ix < m_pending.size(); ++ix)
+					m_pending[ix]->fire();
+				// clear keeps the capacity so a steady stream of events stops allocating after the first frames
+				m_pending.clear();
+			}
+
+			void clear()
+			{
+				m_pending.clear();
+			}
+			int size()
+			{
+				return m_pending.size();
+			}
+
+			GFXEventQueue() {}
+		private:
+			std::vector<const GFXSignal*> m_pending;
 		};
-		template<typename T>
-		using GFXTrigger = typename GFXTriggerPtr<T>::GFXTriggerFunc;
 
-		template<typename T>
-		using GFXLink = std::pair<GFXTrigger<T>, GFXMetaAction>;
-		template<typename T>
+		// Gives a component one signal per trigger, E is the component's trigger enum and COUNT its number of triggers.
+		// Firing a trigger indexes straight to its own signal instead of searching every link.
+		template<typename T, typename E, E COUNT>
 		class GFXLinker
 		{
 		public:
-			void link(GFXTrigger<T> trigger, GFXMetaAction action)
+			int link(E trigger, GFXDelegate delegate)
+			{
+				return m_signals[trigger].connect(delegate);
+			}
+			void unlink(E trigger, int index)
 			{
-				m_links.push_back(std::make_pair(trigger, action));
+				m_signals[trigger].disconnect(index);
 			}
 
 			GFXLinker() {}
 		protected:
-			void callTrigger(GFXTrigger<T> trigger)
+			// Queues the trigger's listeners to run once the frame's events have been checked
+			void callTrigger(E trigger)
 			{
-				for (GFXLink<T>& link : m_links)
-					if (trigger == link.first)
-						link.second->callback();
+				if (!m_signals[trigger].isEmpty())
+					static_cast<T*>(this)->queueEvent(&m_signals[trigger]);
 			}
 
-			std::vector<GFXLink<T>> m_links;
+			GFXSignal m_signals[COUNT];
 		};
 	}
-}
\ No newline at end of file
+}
@@ -3,6 +3,9 @@
 #include "glm.h"
 #include "opengl.h"
 #include "PrimativeGenerator.h"
+#include "VertexLayout.h"
+#include "GLStateCache.h"
+#include "GFXBatch.h"
 #include "CLog.h"
 #include "StringFormat.h"
 #include "colors.h"
@@ -71,27 +74,20 @@ namespace gfx
 			void init(gfx::VertexData d)
 			{
 				m_dataSize = d.size();
+				// CPU copy of position and uv for batching
+				m_vertices.resize(d.size());
+				for (int i = 0; i < d.size(); ++i)
+					m_vertices[i] = glm::vec4(d[i].position.x, d[i].position.y, d[i].uv.x, d[i].uv.y);
 				glGenVertexArrays(1, &m_vao);
-				glBindVertexArray(m_vao);
+				gfx::engine::GLStateCache::bindVertexArray(m_vao);
 				glGenBuffers(1, &m_buffer);
-				glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-				glBufferData(GL_ARRAY_BUFFER, m_dataSize * sizeof(struct gfx::Vertex_T), d.data(), GL_STATIC_DRAW);
-				glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, position));
-				glEnableVertexAttribArray(0);
-				glVertexAttribPointer((GLuint)1, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, color));
-				glEnableVertexAttribArray(1);
-				glVertexAttribPointer((GLuint)2, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, normal));
-				glEnableVertexAttribArray(2);
-				glVertexAttribPointer((GLuint)3, 2, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, uv));
-				glEnableVertexAttribArray(3);
-				glVertexAttribPointer((GLuint)4, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, tangent));
-				glEnableVertexAttribArray(4);
-				glBindVertexArray(0);
+				gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+				// GUI quads only read position and uv
+				gfx::engine::VertexLayout layout = gfx::engine::VertexLayout::gui();
+				std::vector<unsigned char> packed = layout.pack(&d);
+				glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+				layout.apply();
+				gfx::engine::GLStateCache::bindVertexArray(0);
 				glFlush();
 
 				CINFO(alib::StringFormat("    buffered into VAO %0").arg(m_vao).str());
@@ -127,14 +123,18 @@ namespace gfx
 				drawArray();
 			}
 
+			// Appends the mesh to a batch instead of drawing it straight away
+			void drawMesh(glm::mat4 modelMat, GFXBatch * batch)
+			{
+				batch->add(m_vertices.data(), m_vertices.size(), modelMat * getModelMat(), m_color, GFX_GUI_SHADER_BLOCK);
+			}
+
 			// Draws just the VBO and activating the texture
 			void drawArray()
 			{
 				// draw the data
-				glBindVertexArray(m_vao);
+				gfx::engine::GLStateCache::bindVertexArray(m_vao);
 				glDrawArrays(GL_TRIANGLES, 0, m_dataSize);
-				glBindVertexArray(0);
-				glFinish();
 			}
 
 			GFXMesh()
@@ -192,6 +192,7 @@ namespace gfx
 				m_vao = miniMesh->m_vao;
 				m_buffer = miniMesh->m_buffer;
 				m_dataSize = miniMesh->m_dataSize;
+				m_vertices = miniMesh->m_vertices;
 				m_rotation = miniMesh->m_rotation;
 				m_theta = miniMesh->m_theta;
 				m_color = miniMesh->m_color;
@@ -204,6 +205,7 @@ namespace gfx
 			GLuint m_vao;
 			GLuint m_buffer;
 			int m_dataSize;
+			std::vector<glm::vec4> m_vertices;
 			glm::vec3 m_rotation;
 			GLfloat m_theta;
 			glm::vec4 m_color;
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "glm.h"
+#include <unordered_map>
+#include <vector>
+#include <cmath>
+
+// width and height of a grid cell in pixels, about the size of a small widget
+#define GFX_SPATIAL_GRID_CELL_SIZE 64
+
+namespace gfx
+{
+	namespace gui
+	{
+		class GFXComponent;
+
+		// Uniform grid of screen space rectangles (x, y, w, h) used to find the components under a point.
+		// Entries are moved between cells incrementally, only when the cells a rect covers change.
+		class GFXSpatialGrid
+		{
+		public:
+			// Adds or moves a component's rect
+			void update(GFXComponent * component, glm::vec4 rect)
+			{
+				glm::ivec4 cells = getCells(rect);
+				EntryMap::iterator it = m_entries.find(component);
+				if (it != m_entries.end())
+				{
+					it->second.rect = rect;
+					if (it->second.cells == cells)
+						return;
+					removeFromCells(component, it->second.cells);
+					it->second.cells = cells;
+				}
+				else
+				{
+					m_entries[component] = { rect, cells };
+				}
+				addToCells(component, cells);
+			}
+
+			// Stops tracking a component
+			void remove(GFXComponent * component)
+			{
+				EntryMap::iterator it = m_entries.find(component);
+				if (it == m_entries.end())
+					return;
+				removeFromCells(component, it->second.cells);
+				m_entries.erase(it);
+			}
+
+			// Appends every component whose rect contains the point
+			void query(glm::vec2 point, std::vector<GFXComponent*> * out)
+			{
+				CellMap::iterator cell = m_cells.find(getKey(getCell(point.x), getCell(point.y)));
+				if (cell == m_cells.end())
+					return;
+				for (GFXComponent * component : cell->second)
+				{
+					glm::vec4 & rect = m_entries[component].rect;
+					if (point.x >= rect.x && point.y >= rect.y && point.x <= rect.x + rect.z && point.y <= rect.y + rect.w)
+						out->push_back(component);
+				}
+			}
+
+			void clear()
+			{
+				m_entries.clear();
+				m_cells.clear();
+			}
+
+			int getEntryCount()
+			{
+				return m_entries.size();
+			}
+
+			int getCellCount()
+			{
+				return m_cells.size();
+			}
+
+			GFXSpatialGrid()
+			{
+			}
+
+		private:
+			struct Entry
+			{
+				glm::vec4 rect;
+				// first and last cell covered (x0, y0, x1, y1)
+				glm::ivec4 cells;
+			};
+			typedef std::unordered_map<GFXComponent*, Entry> EntryMap;
+			typedef std::unordered_map<long long, std::vector<GFXComponent*>> CellMap;
+
+			static int getCell(float f)
+			{
+				return (int)std::floor(f / GFX_SPATIAL_GRID_CELL_SIZE);
+			}
+			static long long getKey(int x, int y)
+			{
+				return ((long long)x << 32) ^ (unsigned int)y;
+			}
+			static glm::ivec4 getCells(glm::vec4 rect)
+			{
+				return glm::ivec4(getCell(rect.x), getCell(rect.y), getCell(rect.x + rect.z), getCell(rect.y + rect.w));
+			}
+
+			void addToCells(GFXComponent * component, glm::ivec4 cells)
+			{
+				for (int y = cells.y; y <= cells.w; ++y)
+					for (int x = cells.x; x <= cells.z; ++x)
+						m_cells[getKey(x, y)].push_back(component);
+			}
+			void removeFromCells(GFXComponent * component, glm::ivec4 cells)
+			{
+				for (int y = cells.y; y <= cells.w; ++y)
+					for (int x = cells.x; x <= cells.z; ++x)
+					{
+						CellMap::iterator cell = m_cells.find(getKey(x, y));
+						if (cell == m_cells.end())
+							continue;
+						std::vector<GFXComponent*> & list = cell->second;
+						for (int i = 0; i < list.size(); ++i)
+							if (list[i] == component)
+							{
+								list[i] = list.back();
+								list.pop_back();
+								break;
+							}
+						if (list.empty())
+							m_cells.erase(cell);
+					}
+			}
+
+			EntryMap m_entries;
+			CellMap m_cells;
+		};
+	}
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+
+// free space kept at the cursor when the buffer grows
+#define GFX_TEXT_BUFFER_MIN_GAP 256
+
+namespace gfx
+{
+	namespace gui
+	{
+		// Gap buffer text store with an index of where each line starts.
+		// Edits at the cursor only move the characters between the old and new edit position,
+		// and the line index keeps its own gap at the cursor line: starts after it are stored
+		// relative to one pending offset, so an edit shifts every later line by changing that
+		// offset instead of touching each of them. Typing into a large document costs the same
+		// as typing into a small one.
+		class GFXTextBuffer
+		{
+		public:
+			void insert(int pos, const char * text, int count)
+			{
+				if (count <= 0)
+					return;
+				pos = clampPos(pos);
+				moveGap(pos);
+				reserve(count);
+				memcpy(&m_data[m_gapStart], text, count);
+				m_gapStart += count;
+
+				// lines after the insert move along with the offset, then any new lines fill the gap before them
+				moveLineGap(getLine(pos) + 1);
+				m_lineDelta += count;
+				reserveLines(std::count(text, text + count, '\n'));
+				for (int i = 0; i < count; ++i)
+					if (text[i] == '\n')
+						m_lineStarts[m_lineGapStart++] = pos + i + 1;
+			}
+			void insert(int pos, const std::string & text)
+			{
+				insert(pos, text.data(), text.size());
+			}
+			void insert(int pos, char c)
+			{
+				insert(pos, &c, 1);
+			}
+
+			void erase(int pos, int count)
+			{
+				pos = clampPos(pos);
+				count = std::min(count, size() - pos);
+				if (count <= 0)
+					return;
+				moveGap(pos);
+				m_gapEnd += count;
+
+				// lines whose newline was erased are taken into the gap, the rest move back with the offset
+				moveLineGap(getLine(pos) + 1);
+				while (m_lineGapEnd < (int)m_lineStarts.size() && m_lineStarts[m_lineGapEnd] + m_lineDelta <= pos + count)
+					++m_lineGapEnd;
+				m_lineDelta -= count;
+			}
+
+			void clear()
+			{
+				m_gapStart = 0;
+				m_gapEnd = m_data.size();
+				m_lineStarts.assign(1, 0);
+				m_lineGapStart = m_lineGapEnd = 1;
+				m_lineDelta = 0;
+			}
+
+			char at(int pos)
+			{
+				return pos < m_gapStart ? m_data[pos] : m_data[pos + m_gapEnd - m_gapStart];
+			}
+
+			int size()
+			{
+				return m_data.size() - (m_gapEnd - m_gapStart);
+			}
+
+			std::string getText()
+			{
+				std::string text;
+				getRange(0, size(), &text);
+				return text;
+			}
+
+			// Copies the characters in [start, end) into out
+			void getRange(int start, int end, std::string * out)
+			{
+				start = clampPos(start);
+				end = clampPos(end);
+				out->clear();
+				if (end <= start)
+					return;
+				out->reserve(end - start);
+				if (start < m_gapStart)
+					out->append(&m_data[start], std::min(end, m_gapStart) - start);
+				if (end > m_gapStart)
+				{
+					int from = std::max(start, m_gapStart) + m_gapEnd - m_gapStart;
+					out->append(&m_data[from], end + m_gapEnd - m_gapStart - from);
+				}
+			}
+
+			int getLineCount()
+			{
+				return m_lineStarts.size() - (m_lineGapEnd - m_lineGapStart);
+			}
+
+			// Index of the first character of a line
+			int getLineStart(int line)
+			{
+				if (line >= getLineCount())
+					return size();
+				return lineAt(std::max(line, 0));
+			}
+
+			// Index of the newline ending a line, or the end of the text for the last one
+			int getLineEnd(int line)
+			{
+				if (line + 1 >= getLineCount())
+					return size();
+				return lineAt(std::max(line + 1, 1)) - 1;
+			}
+
+			// Index of the line the character at pos is on
+			int getLine(int pos)
+			{
+				// binary search for the first line starting after pos, lineAt skips over the gap
+				int low = 0, high = getLineCount();
+				while (low < high)
+				{
+					int mid = (low + high) / 2;
+					if (lineAt(mid) <= pos)
+						low = mid + 1;
+					else
+						high = mid;
+				}
+				return low - 1;
+			}
+
+			GFXTextBuffer()
+			{
+				m_lineStarts.push_back(0);
+			}
+			GFXTextBuffer(const std::string & text)
+			{
+				m_lineStarts.push_back(0);
+				insert(0, text);
+			}
+
+		private:
+			int clampPos(int pos)
+			{
+				return std::max(0, std::min(pos, size()));
+			}
+
+			// Moves the gap so it starts at pos
+			void moveGap(int pos)
+			{
+				if (pos < m_gapStart)
+				{
+					int count = m_gapStart - pos;
+					memmove(&m_data[m_gapEnd - count], &m_data[pos], count);
+					m_gapStart -= count;
+					m_gapEnd -= count;
+				}
+				else if (pos > m_gapStart)
+				{
+					int count = pos - m_gapStart;
+					memmove(&m_data[m_gapStart], &m_data[m_gapEnd], count);
+					m_gapStart += count;
+					m_gapEnd += count;
+				}
+			}
+
+			// Start of a line, the pending offset is applied to starts after the line gap
+			int lineAt(int line)
+			{
+				return line < m_lineGapStart ? m_lineStarts[line] : m_lineStarts[line + m_lineGapEnd - m_lineGapStart] + m_lineDelta;
+			}
+
+			// Moves the line gap so it starts at line, starts crossing it are made absolute or relative on the way
+			void moveLineGap(int line)
+			{
+				while (m_lineGapStart > line)
+					m_lineStarts[--m_lineGapEnd] = m_lineStarts[--m_lineGapStart] - m_lineDelta;
+				while (m_lineGapStart < line)
+					m_lineStarts[m_lineGapStart++] = m_lineStarts[m_lineGapEnd++] + m_lineDelta;
+				// nothing is relative to the offset any more so it can start again from zero
+				if (m_lineGapEnd == (int)m_lineStarts.size())
+					m_lineDelta = 0;
+			}
+
+			// Grows the line gap to fit count more line starts
+			void reserveLines(int count)
+			{
+				if (m_lineGapEnd - m_lineGapStart >= count)
+					return;
+				int capacity = std::max<int>(m_lineStarts.size() * 2, getLineCount() + count + GFX_TEXT_BUFFER_MIN_GAP);
+				std::vector<int> lineStarts(capacity);
+				int tail = m_lineStarts.size() - m_lineGapEnd;
+				std::copy(m_lineStarts.begin(), m_lineStarts.begin() + m_lineGapStart, lineStarts.begin());
+				std::copy(m_lineStarts.begin() + m_lineGapEnd, m_lineStarts.end(), lineStarts.end() - tail);
+				m_lineStarts.swap(lineStarts);
+				m_lineGapEnd = capacity - tail;
+			}
+
+			// Grows the gap to fit count more characters
+			void reserve(int count)
+			{
+				if (m_gapEnd - m_gapStart >= count)
+					return;
+				int used = size();
+				int capacity = std::max<int>(m_data.size() * 2, used + count + GFX_TEXT_BUFFER_MIN_GAP);
+				std::vector<char> data(capacity);
+				int tail = m_data.size() - m_gapEnd;
+				if (m_gapStart > 0)
+					memcpy(&data[0], &m_data[0], m_gapStart);
+				if (tail > 0)
+					memcpy(&data[capacity - tail], &m_data[m_gapEnd], tail);
+				m_data.swap(data);
+				m_gapEnd = capacity - tail;
+			}
+
+			std::vector<char> m_data;
+			int
+				m_gapStart = 0,
+				m_gapEnd = 0;
+
+			// line starts with a gap at the cursor line, the ones after it are relative to m_lineDelta
+			std::vector<int> m_lineStarts;
+			int
+				m_lineGapStart = 1,
+				m_lineGapEnd = 1,
+				m_lineDelta = 0;
+		};
+	}
+}
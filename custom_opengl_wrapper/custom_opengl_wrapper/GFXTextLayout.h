@@ -0,0 +1,169 @@
+#pragma once
+
+#include "glm.h"
+#include "GFXFontCache.h"
+#include "GFXBatch.h"
+#include <vector>
+#include <string>
+
+namespace gfx
+{
+	namespace gui
+	{
+		// Laid out text: the glyph quads in local space plus where each line starts and where the cursor
+		// sits before each character. Built once when the text, bounds or font change and then drawn
+		// with a single append to the batch.
+		class GFXTextLayout
+		{
+		public:
+			// Lays out the text, bounds of 0 mean unbounded on that axis.
+			// Text that doesn't fit is clipped, single line text clips instead of wrapping.
+			void build(const std::string & text, GFXFontFace_T * face, glm::vec2 bounds, bool multiline)
+			{
+				m_face = face;
+				m_bounds = bounds;
+				m_multiline = multiline;
+				m_vertices.clear();
+				m_lineStarts.assign(1, 0);
+				m_cursorOffsets.assign(text.size() + 1, glm::vec2());
+				m_visibleLength = text.size();
+				m_valid = true;
+				if (face == NULL)
+					return;
+
+				float advance = face->metrics.advance;
+				float lineHeight = face->metrics.lineHeight;
+				glm::vec2 glyphSize = glm::vec2(face->metrics.size);
+				bool boundedX = bounds.x > 0.0f;
+				bool boundedY = bounds.y > 0.0f;
+
+				float ix = 0.0f, iy = 0.0f;
+				int ic;
+				bool clipped = false;
+				glm::vec2 clipEnd;
+				for (ic = 0; ic < text.size(); ++ic)
+				{
+					unsigned char c = text[ic];
+					if (c == '\n')
+					{
+						m_cursorOffsets[ic] = glm::vec2(ix, iy);
+						ix = 0.0f;
+						iy += lineHeight;
+						m_lineStarts.push_back(ic + 1);
+						if (boundedY && iy + lineHeight > bounds.y)
+						{
+							clipped = true;
+							clipEnd = glm::vec2(boundedX ? bounds.x : 0.0f, iy - lineHeight);
+							ic++;
+							break;
+						}
+						continue;
+					}
+					if (boundedX && ix + advance > bounds.x)
+					{
+						if (!multiline || (boundedY && iy + lineHeight * 2.0f > bounds.y))
+						{
+							clipped = true;
+							clipEnd = glm::vec2(bounds.x, iy);
+							break;
+						}
+						ix = 0.0f;
+						iy += lineHeight;
+						m_lineStarts.push_back(ic);
+					}
+
+					m_cursorOffsets[ic] = glm::vec2(ix, iy);
+					const glm::vec4 * glyph = &face->atlas->glyphs[c * GFX_FONT_GLYPH_VERTICES];
+					for (int iv = 0; iv < GFX_FONT_GLYPH_VERTICES; ++iv)
+						m_vertices.push_back(glm::vec4(
+							glm::vec2(ix, iy) + glm::vec2(glyph[iv]) * glyphSize,
+							glyph[iv].z, glyph[iv].w));
+					ix += advance;
+				}
+
+				if (clipped)
+				{
+					// everything past the clip puts the cursor at the end of the last visible line
+					m_visibleLength = ic;
+					for (; ic <= text.size(); ++ic)
+						m_cursorOffsets[ic] = clipEnd;
+				}
+				else
+				{
+					m_cursorOffsets[text.size()] = glm::vec2(ix, iy);
+				}
+			}
+
+			// Appends all the glyphs to the batch in one go
+			void draw(glm::mat4 modelMat, glm::vec4 color, GFXBatch * batch)
+			{
+				if (m_face == NULL || m_vertices.empty())
+					return;
+				batch->add(m_vertices.data(), m_vertices.size(), modelMat, color, GFX_GUI_SHADER_FONT, m_face->atlas->tex);
+			}
+
+			// Marks the layout as stale, it's rebuilt on the next isValid check that fails
+			void invalidate()
+			{
+				m_valid = false;
+			}
+
+			// True if the layout was built with these settings and hasn't been invalidated since
+			bool isValid(GFXFontFace_T * face, glm::vec2 bounds, bool multiline)
+			{
+				return m_valid && m_face == face && m_bounds == bounds && m_multiline == multiline;
+			}
+
+			// Offset from the text origin of the cursor placed before the character at pos
+			glm::vec2 getCursorOffset(int pos)
+			{
+				if (m_cursorOffsets.empty())
+					return glm::vec2();
+				pos = glm::clamp(pos, 0, (int)m_cursorOffsets.size() - 1);
+				return m_cursorOffsets[pos];
+			}
+
+			// Index of the line the character at pos is on
+			int getLine(int pos)
+			{
+				int line = 0;
+				while (line + 1 < m_lineStarts.size() && m_lineStarts[line + 1] <= pos)
+					++line;
+				return line;
+			}
+
+			// Index of the first character of a line
+			int getLineStart(int line)
+			{
+				return m_lineStarts[glm::clamp(line, 0, (int)m_lineStarts.size() - 1)];
+			}
+
+			int getLineCount()
+			{
+				return m_lineStarts.size();
+			}
+
+			// Number of characters that fit in the bounds
+			int getVisibleLength()
+			{
+				return m_visibleLength;
+			}
+
+			GFXTextLayout()
+			{
+			}
+
+		private:
+			GFXFontFace_T * m_face = NULL;
+			glm::vec2 m_bounds;
+			bool
+				m_multiline = false,
+				m_valid = false;
+
+			std::vector<glm::vec4> m_vertices;
+			std::vector<int> m_lineStarts;
+			std::vector<glm::vec2> m_cursorOffsets;
+			int m_visibleLength = 0;
+		};
+	}
+}
@@ -3,6 +3,7 @@
 #include "StringFormat.h"
 #include "thread"
 #include "KeyboardEvents.h"
+#include "GLStateCache.h"
 
 using gfx::engine::GLContent;
 
@@ -12,64 +13,81 @@ namespace
 }
 
 void GLContent::run(gfx::engine::GLContentLoop graphics_loop, gfx::engine::GLContentInit init, GLFWkeyfun key_func, GLFWmousebuttonfun mouse_func)
+{
+	run(graphics_loop, init, key_func, mouse_func, NULL);
+}
+
+// Runs like run, calling release once the window closes while the context is still current,
+// anything holding GPU objects must free them there as run exits the program afterwards
+void GLContent::run(gfx::engine::GLContentLoop graphics_loop, gfx::engine::GLContentInit init, GLFWkeyfun key_func, GLFWmousebuttonfun mouse_func, gfx::engine::GLContentRelease release)
 {
 	std::thread(&alib::KeyboardEvents::run, m_keyboard).detach();
-	glLoop(graphics_loop, initWindow(init, key_func, mouse_func));
+	glLoop(graphics_loop, initWindow(init, key_func, mouse_func), release);
 }
 
 void GLContent::loadPerspective()
 {
 	// Enable depth test
-	glEnable(GL_DEPTH_TEST);
+	gfx::engine::GLStateCache::enable(GL_DEPTH_TEST);
 	// Cull triangles which normal is not towards the camera
-	glEnable(GL_CULL_FACE);
+	gfx::engine::GLStateCache::enable(GL_CULL_FACE);
 
 	m_view = getPerspectiveView();
 	m_projection = getPerspective();
+
+	loadCameraBlock(gfx::engine::CAMERA_SLOT_PERSPECTIVE);
 }
 
 void GLContent::loadExternalOrtho()
 {
 	// Enable depth test
-	glDisable(GL_DEPTH_TEST);
+	gfx::engine::GLStateCache::disable(GL_DEPTH_TEST);
 	// Cull triangles which normal is not towards the camera
-	glDisable(GL_CULL_FACE);
+	gfx::engine::GLStateCache::disable(GL_CULL_FACE);
 
 	m_view = getExternalOrthoView();
 	m_projection = getExternalOrtho();
+
+	loadCameraBlock(gfx::engine::CAMERA_SLOT_EXTERNAL_ORTHO);
 }
 
 void GLContent::loadOrtho()
 {
 	// Enable depth test
-	glDisable(GL_DEPTH_TEST);
+	gfx::engine::GLStateCache::disable(GL_DEPTH_TEST);
 	// Cull triangles which normal is not towards the camera
-	glDisable(GL_CULL_FACE);
+	gfx::engine::GLStateCache::disable(GL_CULL_FACE);
 
 	m_view = getOrthoView();
 	m_projection = getOrtho();
+
+	loadCameraBlock(gfx::engine::CAMERA_SLOT_ORTHO);
 }
 
 void GLContent::loadPseudoIsometric()
 {
 	// Enable depth test
-	glEnable(GL_DEPTH_TEST);
+	gfx::engine::GLStateCache::enable(GL_DEPTH_TEST);
 	// Cull triangles which normal is not towards the camera
-	glEnable(GL_CULL_FACE);
+	gfx::engine::GLStateCache::enable(GL_CULL_FACE);
 
 	m_view = getPseudoIsometricView();
 	m_projection = getPseudoIsometric();
+
+	loadCameraBlock(gfx::engine::CAMERA_SLOT_PSEUDO_ISOMETRIC);
 }
 
 void GLContent::loadHyperPerspective()
 {
 	// Enable depth test
-	glEnable(GL_DEPTH_TEST);
+	gfx::engine::GLStateCache::enable(GL_DEPTH_TEST);
 	// Cull triangles which normal is not towards the camera
-	glEnable(GL_CULL_FACE);
+	gfx::engine::GLStateCache::enable(GL_CULL_FACE);
 
 	m_view = getHyperPerspectiveView();
 	m_projection = getHyperPerspective();
+
+	loadCameraBlock(gfx::engine::CAMERA_SLOT_HYPER_PERSPECTIVE);
 }
 
 glm::vec3 * GLContent::getEyePos()
@@ -100,6 +118,12 @@ glm::mat4 * GLContent::getProjMat()
 	return &m_projection;
 }
 
+// Gets the frustum of the projection and view last loaded, whichever projection that was
+gfx::engine::Frustum_T * GLContent::getFrustum()
+{
+	return &m_frustum;
+}
+
 void GLContent::setClearColor(glm::vec3 color)
 {
 	m_clearColor = glm::vec4(color, 1.0f);
@@ -272,7 +296,7 @@ void GLContent::handleKeyEvent()
 }
 
 //GL graphics loop
-void			GLContent::glLoop(gfx::engine::GLContentLoop graphics_loop, GLFWwindow * window)
+void			GLContent::glLoop(gfx::engine::GLContentLoop graphics_loop, GLFWwindow * window, gfx::engine::GLContentRelease release)
 {
 	CINFO("Running GL loop...");
 	//Main Loop  
@@ -289,10 +313,15 @@ void			GLContent::glLoop(gfx::engine::GLContentLoop graphics_loop, GLFWwindow *
 		m_newMousePos = getMousePos();
 		m_keyboard.run();
 
+		// block only if the GPU is still busy with the frame that used this slot
+		m_framePacer.beginFrame();
+
 		graphics_loop();
 
 		//Swap buffers  
 		glfwSwapBuffers(window);
+		// mark the end of this frame's commands
+		m_framePacer.endFrame();
 		//Get and organize events, like keyboard and mouse input, window resizing, etc...  
 		m_keyDown = NULL;
 		glfwPollEvents();
@@ -309,6 +338,13 @@ void			GLContent::glLoop(gfx::engine::GLContentLoop graphics_loop, GLFWwindow *
 
 	CINFO("Window has closed. Application will now exit.");
 
+	if (release != NULL)
+		release();
+
+	m_framePacer.release();
+	m_cameraBlock.release();
+	m_lightBlock.release();
+
 	//Close OpenGL window and terminate GLFW  
 	glfwDestroyWindow(window);
 	//Finalize and clean up GLFW  
@@ -374,18 +410,21 @@ GLFWwindow *				GLContent::initWindow(gfx::engine::GLContentInit init, GLFWkeyfu
 	}
 	CINFO("    GLEW Initialised");
 
+	// new context, nothing in the state shadow is valid
+	gfx::engine::GLStateCache::reset();
+
 	// Enable depth test
-	glEnable(GL_DEPTH_TEST);
+	gfx::engine::GLStateCache::enable(GL_DEPTH_TEST);
 	// Accept fragment if it closer to the camera than the former one
-	glDepthFunc(GL_LESS);
+	gfx::engine::GLStateCache::depthFunc(GL_LESS);
 	// Cull triangles which normal is not towards the camera
-	glEnable(GL_CULL_FACE);
+	gfx::engine::GLStateCache::enable(GL_CULL_FACE);
 	// enable texturineg
-	glEnable(GL_TEXTURE_2D);
+	gfx::engine::GLStateCache::enable(GL_TEXTURE_2D);
 
-	glEnable(GL_BLEND);
+	gfx::engine::GLStateCache::enable(GL_BLEND);
 
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	gfx::engine::GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	glClearDepth(1.0f);
 	// init
@@ -394,6 +433,63 @@ GLFWwindow *				GLContent::initWindow(gfx::engine::GLContentInit init, GLFWkeyfu
 	return window;
 }
 
+// Sets how many frames the CPU may queue ahead of the GPU (1-3)
+void GLContent::setFramesInFlight(int frames)
+{
+	m_framePacer.setFramesInFlight(frames);
+}
+
+// Gets the time in milliseconds the CPU waited on the GPU at the start of the last frame
+float GLContent::getFrameWaitTime()
+{
+	return m_framePacer.getWaitTime();
+}
+
+// Re-uploads the camera block, for when the view or projection is changed through getViewMat/getProjMat
+void GLContent::updateCameraBlock()
+{
+	loadCameraBlock(m_cameraSlot);
+}
+
+// Uploads a light's view and projection to the shadow slot of the camera block and binds it,
+// load a projection again afterwards to go back to drawing from the camera
+void GLContent::loadShadowCamera(glm::mat4 view, glm::mat4 proj)
+{
+	gfx::engine::CameraBlock_T block;
+	block.view = view;
+	block.proj = proj;
+	block.eye_pos = glm::inverse(view)[3];
+	// m_cameraSlot is left alone so updateCameraBlock never writes the camera over the light
+	m_cameraBlock.load(gfx::engine::CAMERA_SLOT_SHADOW, &block);
+
+	m_frustum = gfx::engine::Bounds::extract_frustum(proj * view);
+}
+
+// Sets the light shared by every program through the Lighting block
+void GLContent::setLight(gfx::Light_T light, glm::vec3 ambient_color)
+{
+	gfx::engine::LightBlock_T block;
+	block.pos = glm::vec4(light.pos, 1.0f);
+	block.color = glm::vec4(light.color, 1.0f);
+	block.properties = glm::vec4(light.brightness_specscale_shinniness, 0.0f);
+	block.ambient = glm::vec4(ambient_color, 1.0f);
+	m_lightBlock.load(0, &block);
+}
+
+// Uploads the view and projection to a camera slot and binds it
+void GLContent::loadCameraBlock(int slot)
+{
+	gfx::engine::CameraBlock_T block;
+	block.view = m_view;
+	block.proj = m_projection;
+	// taken from the view rather than m_eyePos as the isometric view doesn't sit at m_eyePos
+	block.eye_pos = glm::inverse(m_view)[3];
+	m_cameraSlot = slot;
+	m_cameraBlock.load(slot, &block);
+
+	m_frustum = gfx::engine::Bounds::extract_frustum(m_projection * m_view);
+}
+
 GLContent::GLContent() {}
 
 GLContent::GLContent(glm::vec3 window_size, glm::vec3 eye_pos, glm::vec3 eye_look_pos, glm::vec3 up, float fov, float aspect_ratio, float near_z, float far_z)
@@ -1,6 +1,8 @@
 #include "GLSLProgram.h"
 #include "CLog.h"
 #include "StringFormat.h"
+#include "GLStateCache.h"
+#include "UniformBlock.h"
 
 using gfx::engine::GLSLProgram;
 
@@ -14,24 +16,33 @@ namespace
 	const char * VAR_NAME_TEX0      = "u_tex";
 	const char * VAR_NAME_TEX1		= "u_tex1";
 	const char * VAR_NAME_FLAG      = "u_flag";
+	const char * VAR_NAME_DEQUANT_SCALE  = "u_dequant_scale";
+	const char * VAR_NAME_DEQUANT_OFFSET = "u_dequant_offset";
 }
 
 GLSLProgram * GLSLProgram::addHandle(gfx::engine::VarHandle handle)
 {
 	handle.init(m_Id);
-	m_handles.insert({ handle.get_handle_id(), handle });
+	VarHandleID id = handle.get_handle_id();
+	if (id == gfx::engine::NULL_VAR_HANDLE_ID)
+		return this;
+	if (id >= m_handles.size())
+		m_handles.resize(id + 1);
+	m_handles[id] = handle;
 	return this;
 }
 
 void GLSLProgram::load()
 {
-	glUseProgram(m_Id);
-	for (auto& sm_pair : m_handles)
-		sm_pair.second.load();
+	gfx::engine::GLStateCache::useProgram(m_Id);
+	for (int i = 0; i < m_handles.size(); ++i)
+		m_handles[i].load();
 }
 
 gfx::engine::VarHandle * GLSLProgram::getHandle(gfx::engine::VarHandleID id)
 {
+	if (id >= m_handles.size())
+		return &m_nullHandle;
 	return &m_handles[id];
 }
 
@@ -102,6 +113,20 @@ GLSLProgram * GLSLProgram::setTex1Handle()
 	return this;
 }
 
+// Adds the position dequantise scale and offset uniforms, shaders without them ignore quantised layouts
+GLSLProgram * GLSLProgram::setDequantiseHandles()
+{
+	VarHandle handle = VarHandle(VAR_NAME_DEQUANT_SCALE);
+	handle.init(m_Id);
+	m_dequantScale = handle.get_handle_id();
+	addHandle(handle);
+	handle = VarHandle(VAR_NAME_DEQUANT_OFFSET);
+	handle.init(m_Id);
+	m_dequantOffset = handle.get_handle_id();
+	addHandle(handle);
+	return this;
+}
+
 gfx::engine::VarHandle * GLSLProgram::getModelMat4Handle()
 {
 	return getHandle(m_modelMat);
@@ -137,6 +162,16 @@ gfx::engine::VarHandle * GLSLProgram::getTex1Handle()
 	return getHandle(m_tex1);
 }
 
+gfx::engine::VarHandle * GLSLProgram::getDequantScaleHandle()
+{
+	return getHandle(m_dequantScale);
+}
+
+gfx::engine::VarHandle * GLSLProgram::getDequantOffsetHandle()
+{
+	return getHandle(m_dequantOffset);
+}
+
 //Loads shaders from their files into a shader program (from opengl-tutorials.org)
 GLSLProgram::GLSLProgram() {}
 
@@ -247,6 +282,14 @@ GLSLProgram::GLSLProgram(
 	glDeleteShader(m_vertexShaderID);
 	glDeleteShader(m_fragmentShaderID);
 
+	// point the shared blocks at their fixed bindings, #version 400 shaders can't set binding in layout()
+	GLuint blockIndex = glGetUniformBlockIndex(ProgramID, UBO_NAME_CAMERA);
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(ProgramID, blockIndex, UBO_BINDING_CAMERA);
+	blockIndex = glGetUniformBlockIndex(ProgramID, UBO_NAME_LIGHTING);
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(ProgramID, blockIndex, UBO_BINDING_LIGHTING);
+
 	this->m_Id = ProgramID;
 
 	CINFO(alib::StringFormat("    Loaded GLSLProgram -> Program ID %0").arg(ProgramID).str());
@@ -48,6 +48,7 @@ gfx::engine::GLSLProgramID GLSLProgramManager::addProgram(
 	program.setModelMat4Handle(model_data);
 	program.setViewMat4Handle(view_data);
 	program.setProjMat4Handle(proj_data);
+	program.setDequantiseHandles();
 	m_shaderPrograms.insert({ program.getId(), program });
 	return program.getId();
 }
@@ -0,0 +1,321 @@
+#include "GLStateCache.h"
+#include "CLog.h"
+#include "StringFormat.h"
+
+using gfx::engine::GLStateCache;
+
+namespace
+{
+	const char * CLASSNAME = "GLStateCache";
+
+	const GLint UNKNOWN = -1;
+
+	// capabilities that are shadowed, anything else always goes to the driver
+	const GLenum CAPS[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_TEXTURE_2D, GL_SCISSOR_TEST, GL_STENCIL_TEST };
+	const int CAP_COUNT = sizeof(CAPS) / sizeof(CAPS[0]);
+
+	struct State_T
+	{
+		GLint caps[CAP_COUNT];
+		GLint active_unit;
+		std::vector<GLint> textures;
+		GLint vao, array_buffer, uniform_buffer, program, fbo;
+		// indexed uniform buffer bindings, buffer and offset per binding point
+		std::vector<GLint> uniform_ranges;
+		std::vector<GLintptr> uniform_offsets;
+		GLint blend[4], blend_equation, depth_func;
+		GLint viewport[4];
+	};
+
+	State_T state;
+	gfx::engine::GLStateStats_T stats = {};
+	bool validation = false;
+	bool initialised = false;
+
+	int cap_index(GLenum cap)
+	{
+		for (int i = 0; i < CAP_COUNT; ++i)
+			if (CAPS[i] == cap)
+				return i;
+		return -1;
+	}
+
+	void init_if_needed()
+	{
+		if (!initialised)
+			GLStateCache::reset();
+	}
+
+	// counts a call and returns true if it has to reach the driver
+	bool changed(GLint & shadow, GLint value)
+	{
+		if (shadow == value)
+		{
+			stats.skipped++;
+			return false;
+		}
+		shadow = value;
+		stats.calls++;
+		return true;
+	}
+
+	void validate(GLint expected, GLint actual, const char * what)
+	{
+		if (expected != actual)
+		{
+			stats.mismatches++;
+			CERROR(alib::StringFormat("shadow of %0 is %1 but GL has %2").arg(what).arg((int)expected).arg((int)actual).str(),
+				__FILE__, __LINE__, CLASSNAME, "validate");
+		}
+	}
+
+	GLint get_integer(GLenum name)
+	{
+		GLint value = 0;
+		glGetIntegerv(name, &value);
+		return value;
+	}
+}
+
+// Forgets the shadow so the next call of every kind goes to the driver, call after context creation
+void GLStateCache::reset()
+{
+	for (int i = 0; i < CAP_COUNT; ++i)
+		state.caps[i] = UNKNOWN;
+	state.active_unit = UNKNOWN;
+	state.textures.clear();
+	state.uniform_ranges.clear();
+	state.uniform_offsets.clear();
+	state.vao = state.array_buffer = state.uniform_buffer = state.program = state.fbo = UNKNOWN;
+	for (int i = 0; i < 4; ++i)
+	{
+		state.blend[i] = UNKNOWN;
+		state.viewport[i] = UNKNOWN;
+	}
+	state.blend_equation = state.depth_func = UNKNOWN;
+	initialised = true;
+}
+
+// Marks the texture bindings as unknown, for code that binds textures directly (e.g. loading)
+void GLStateCache::invalidateTextures()
+{
+	state.textures.clear();
+}
+
+void GLStateCache::enable(GLenum cap)
+{
+	init_if_needed();
+	int i = cap_index(cap);
+	if (i < 0)
+	{
+		stats.calls++;
+		glEnable(cap);
+		return;
+	}
+	if (changed(state.caps[i], GL_TRUE))
+		glEnable(cap);
+	else if (validation)
+		validate(GL_TRUE, glIsEnabled(cap), "enable");
+}
+
+void GLStateCache::disable(GLenum cap)
+{
+	init_if_needed();
+	int i = cap_index(cap);
+	if (i < 0)
+	{
+		stats.calls++;
+		glDisable(cap);
+		return;
+	}
+	if (changed(state.caps[i], GL_FALSE))
+		glDisable(cap);
+	else if (validation)
+		validate(GL_FALSE, glIsEnabled(cap), "disable");
+}
+
+void GLStateCache::activeTexture(GLenum unit)
+{
+	init_if_needed();
+	if (changed(state.active_unit, unit))
+		glActiveTexture(unit);
+	else if (validation)
+		validate(unit, get_integer(GL_ACTIVE_TEXTURE), "active texture");
+}
+
+// Binds a texture to a unit, only switching the active unit if the binding changes
+void GLStateCache::bindTexture(GLenum unit, GLenum target, GLuint texture)
+{
+	init_if_needed();
+	int index = unit - GL_TEXTURE0;
+	if (index >= state.textures.size())
+		state.textures.resize(index + 1, UNKNOWN);
+
+	if (state.textures[index] == texture)
+	{
+		stats.skipped++;
+		if (validation)
+		{
+			activeTexture(unit);
+			validate(texture, get_integer(target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D), "texture binding");
+		}
+		return;
+	}
+
+	activeTexture(unit);
+	state.textures[index] = texture;
+	stats.calls++;
+	glBindTexture(target, texture);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+	init_if_needed();
+	if (changed(state.vao, vao))
+		glBindVertexArray(vao);
+	else if (validation)
+		validate(vao, get_integer(GL_VERTEX_ARRAY_BINDING), "vertex array");
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+	init_if_needed();
+	// element array bindings live in the VAO so they are never shadowed
+	GLint * shadow = target == GL_ARRAY_BUFFER ? &state.array_buffer :
+		(target == GL_UNIFORM_BUFFER ? &state.uniform_buffer : NULL);
+	if (shadow == NULL)
+	{
+		stats.calls++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (changed(*shadow, buffer))
+		glBindBuffer(target, buffer);
+	else if (validation)
+		validate(buffer, get_integer(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_UNIFORM_BUFFER_BINDING), "buffer");
+}
+
+// Binds a range of a buffer to an indexed binding point, only GL_UNIFORM_BUFFER bindings are shadowed
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	init_if_needed();
+	if (target != GL_UNIFORM_BUFFER)
+	{
+		stats.calls++;
+		glBindBufferRange(target, index, buffer, offset, size);
+		return;
+	}
+	if (index >= state.uniform_ranges.size())
+	{
+		state.uniform_ranges.resize(index + 1, UNKNOWN);
+		state.uniform_offsets.resize(index + 1, 0);
+	}
+	if (state.uniform_ranges[index] == buffer && state.uniform_offsets[index] == offset)
+	{
+		stats.skipped++;
+		return;
+	}
+	state.uniform_ranges[index] = buffer;
+	state.uniform_offsets[index] = offset;
+	// an indexed bind also replaces the generic binding
+	state.uniform_buffer = buffer;
+	stats.calls++;
+	glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+	init_if_needed();
+	if (changed(state.program, program))
+		glUseProgram(program);
+	else if (validation)
+		validate(program, get_integer(GL_CURRENT_PROGRAM), "program");
+}
+
+void GLStateCache::bindFramebuffer(GLuint fbo)
+{
+	init_if_needed();
+	if (changed(state.fbo, fbo))
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	else if (validation)
+		validate(fbo, get_integer(GL_FRAMEBUFFER_BINDING), "framebuffer");
+}
+
+void GLStateCache::blendFunc(GLenum src, GLenum dst)
+{
+	blendFuncSeparate(src, dst, src, dst);
+}
+
+void GLStateCache::blendFuncSeparate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha)
+{
+	init_if_needed();
+	if (state.blend[0] == src_rgb && state.blend[1] == dst_rgb && state.blend[2] == src_alpha && state.blend[3] == dst_alpha)
+	{
+		stats.skipped++;
+		if (validation)
+		{
+			validate(src_rgb, get_integer(GL_BLEND_SRC_RGB), "blend src rgb");
+			validate(dst_rgb, get_integer(GL_BLEND_DST_RGB), "blend dst rgb");
+			validate(src_alpha, get_integer(GL_BLEND_SRC_ALPHA), "blend src alpha");
+			validate(dst_alpha, get_integer(GL_BLEND_DST_ALPHA), "blend dst alpha");
+		}
+		return;
+	}
+	state.blend[0] = src_rgb; state.blend[1] = dst_rgb; state.blend[2] = src_alpha; state.blend[3] = dst_alpha;
+	stats.calls++;
+	glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+}
+
+void GLStateCache::blendEquation(GLenum mode)
+{
+	init_if_needed();
+	if (changed(state.blend_equation, mode))
+		glBlendEquation(mode);
+	else if (validation)
+		validate(mode, get_integer(GL_BLEND_EQUATION_RGB), "blend equation");
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+	init_if_needed();
+	if (changed(state.depth_func, func))
+		glDepthFunc(func);
+	else if (validation)
+		validate(func, get_integer(GL_DEPTH_FUNC), "depth func");
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei w, GLsizei h)
+{
+	init_if_needed();
+	if (state.viewport[0] == x && state.viewport[1] == y && state.viewport[2] == w && state.viewport[3] == h)
+	{
+		stats.skipped++;
+		if (validation)
+		{
+			GLint actual[4];
+			glGetIntegerv(GL_VIEWPORT, actual);
+			for (int i = 0; i < 4; ++i)
+				validate(state.viewport[i], actual[i], "viewport");
+		}
+		return;
+	}
+	state.viewport[0] = x; state.viewport[1] = y; state.viewport[2] = w; state.viewport[3] = h;
+	stats.calls++;
+	glViewport(x, y, w, h);
+}
+
+// Checks every skipped call against glGet and logs mismatches (slow, for debugging)
+void GLStateCache::setValidation(bool validate)
+{
+	validation = validate;
+}
+
+gfx::engine::GLStateStats_T GLStateCache::getStats()
+{
+	return stats;
+}
+
+void GLStateCache::resetStats()
+{
+	stats = {};
+}
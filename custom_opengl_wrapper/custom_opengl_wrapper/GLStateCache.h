@@ -0,0 +1,54 @@
+#pragma once
+
+#include "opengl.h"
+#include <vector>
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Counts of state calls that reached the driver and those skipped because nothing changed
+		struct GLStateStats_T
+		{
+			int calls, skipped, mismatches;
+		};
+
+		// Shadows the GL state the engine touches so calls that don't change anything skip the driver.
+		// Everything that binds or toggles this state must go through here or the shadow goes stale.
+		class GLStateCache
+		{
+		public:
+			// Forgets the shadow so the next call of every kind goes to the driver, call after context creation
+			static void reset();
+
+			// Marks the texture bindings as unknown, for code that binds textures directly (e.g. loading)
+			static void invalidateTextures();
+
+			static void enable(GLenum cap);
+			static void disable(GLenum cap);
+
+			static void activeTexture(GLenum unit);
+			// Binds a texture to a unit, only switching the active unit if the binding changes
+			static void bindTexture(GLenum unit, GLenum target, GLuint texture);
+
+			static void bindVertexArray(GLuint vao);
+			static void bindBuffer(GLenum target, GLuint buffer);
+			// Binds a range of a buffer to an indexed binding point, only GL_UNIFORM_BUFFER bindings are shadowed
+			static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+			static void useProgram(GLuint program);
+			static void bindFramebuffer(GLuint fbo);
+
+			static void blendFunc(GLenum src, GLenum dst);
+			static void blendFuncSeparate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha);
+			static void blendEquation(GLenum mode);
+			static void depthFunc(GLenum func);
+			static void viewport(GLint x, GLint y, GLsizei w, GLsizei h);
+
+			// Checks every skipped call against glGet and logs mismatches (slow, for debugging)
+			static void setValidation(bool validate);
+
+			static GLStateStats_T getStats();
+			static void resetStats();
+		};
+	}
+}
@@ -10,11 +10,22 @@
 #include "GLContent.h"
 #include "GFXLinker.h"
 #include "ImageLoader.h"
+#include "GFXFontCache.h"
+#include "GFXTextLayout.h"
+#include "GFXSpatialGrid.h"
+#include "GFXTextBuffer.h"
+#include "GFXLayout.h"
+#include "GFXArena.h"
 #include <map>
+#include <functional>
+#include <cstdint>
 
 #define GFX_NULLPTR NULL
-#define GFX_NULL_ID ""
-#define GFX_DEFAULT_ID "component"
+#define GFX_NULL_ID 0
+// component ids keep the slot index in the low bits and the slot's generation above them
+#define GFX_ID_INDEX_BITS 20
+#define GFX_ID_INDEX_MASK ((1u << GFX_ID_INDEX_BITS) - 1)
+#define GFX_ID_GENERATION_MASK ((1u << (32 - GFX_ID_INDEX_BITS)) - 1)
 #define GFX_NULL_INDEX -1
 #define GFX_NULL_COLORSTYLE NULL
 #define GFX_RESIZE_NULL 0
@@ -23,11 +34,12 @@
 #define GFX_RESIZE_RIGHT 3
 #define GFX_RESIZE_BOTTOM 4
 
-#define GFX_GUI_SHADER_BLOCK 0
-#define GFX_GUI_SHADER_FONT 1
-#define GFX_GUI_SHADER_TEXTURE 2
 #define GFX_GUI_DEFAULT_FONT_SIZE 20
 #define GFX_GUI_DEFAULT_PADDING 50
+// window layers are sized up to a multiple of this many pixels
+#define GFX_WINDOW_LAYER_STEP 64
+#define GFX_LIST_DEFAULT_ROW_HEIGHT 24
+#define GFX_LIST_SCROLLBAR_WIDTH 20
 
 namespace gfx
 {
@@ -38,7 +50,9 @@ namespace gfx
 		const char * GFX_Malgun_Gothic_FONT = "textures/Malgun_Gothic.png";
 
 		// TYPEDEFS
-		typedef std::string GFXID;
+		// Handle to a registered component, the low bits index the manager's slots and the high bits
+		// are the slot's generation so a handle kept after its component is removed doesn't resolve
+		typedef uint32_t GFXID;
 		struct GFXColorStyle_T
 		{
 			glm::vec4 colors[3];
@@ -48,92 +62,34 @@ namespace gfx
 		class GFXFont
 		{
 		public:
-			// Draws the mesh including linking the model matrix
-			void draw(unsigned char c, glm::mat4 modelMat, glm::vec2 pos, glm::vec2 scale, gfx::engine::MeshHandle_T handles)
+			// Appends a glyph quad to the batch
+			void draw(unsigned char c, glm::mat4 modelMat, glm::vec2 pos, glm::vec2 scale, GFXBatch * batch)
 			{
-				handles.modelMatHandle->load(modelMat * glm::translate(glm::mat4(1.), glm::vec3(pos, 0)) *
-					glm::scale(glm::mat4(1.), glm::vec3(scale, 0)));
-				handles.colorHandle->load(m_color);
-				handles.flagHandle->load(GFX_GUI_SHADER_FONT);
-				drawArray(c, handles.textureHandle);
+				if (m_face == GFX_NULLPTR)
+					return;
+				batch->add(&m_face->atlas->glyphs[c * GFX_FONT_GLYPH_VERTICES], GFX_FONT_GLYPH_VERTICES,
+					modelMat * glm::translate(glm::mat4(1.), glm::vec3(pos, 0)) * glm::scale(glm::mat4(1.), glm::vec3(scale, 0)),
+					m_color, GFX_GUI_SHADER_FONT, m_face->atlas->tex);
 			}
 
-			// Draws just the VBO and activating the texture
-			void drawArray(unsigned char c, gfx::engine::VarHandle *textureHandle)
+			// Gets the advance and line height of the font at its size
+			GFXFontMetrics_T getMetrics()
 			{
-				// load the textures
-				if (m_tex != GL_TEXTURE0)
-				{
-					loadTextureHandle(textureHandle);
-					glActiveTexture(GL_TEXTURE0 + m_tex);
-					glBindTexture(GL_TEXTURE_2D, m_tex);
-				}
-
-				// draw the data
-				glBindVertexArray(m_vao);
-				glDrawArrays(GL_TRIANGLES, c * 6, 6);
-				glBindVertexArray(0);
-
-				// unload the texture
-				if (m_tex != GL_TEXTURE0)
-				{
-					glActiveTexture(GL_TEXTURE0 + m_tex);
-					glBindTexture(GL_TEXTURE_2D, GL_TEXTURE0);
-				}
-				glActiveTexture(GL_TEXTURE0);
-				glFinish();
+				if (m_face == GFX_NULLPTR)
+					return { 0, 0, 0 };
+				return m_face->metrics;
 			}
 
-			// Override the texture handle seperately
-			void loadTextureHandle(gfx::engine::VarHandle * handle)
+			// Gets the shared face, used to lay out text ahead of drawing
+			GFXFontFace_T * getFace()
 			{
-				handle->load(m_tex);
+				return m_face;
 			}
 
-			// Loads image file into a texture
-			void loadTextures(const char *texfilename)
+			glm::vec4 getColor()
 			{
-				if (texfilename != "")
-				{
-					m_tex = alib::ImageLoader::loadTextureFromImage(texfilename);
-					CINFO(alib::StringFormat("    %0 -> Texture ID %1").arg(texfilename).arg(m_tex).str());
-				}
-				else
-				{
-					CINFO("    no texture file loaded");
-				}
-			}
-
-			// Buffers Vertex data into the VBO
-			void init(gfx::VertexData d)
-			{
-				m_dataSize = d.size();
-				glGenVertexArrays(1, &m_vao);
-				glBindVertexArray(m_vao);
-				glGenBuffers(1, &m_buffer);
-				glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-				glBufferData(GL_ARRAY_BUFFER, m_dataSize * sizeof(struct gfx::Vertex_T), d.data(), GL_STATIC_DRAW);
-				glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, position));
-				glEnableVertexAttribArray(0);
-				glVertexAttribPointer((GLuint)1, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, color));
-				glEnableVertexAttribArray(1);
-				glVertexAttribPointer((GLuint)2, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, normal));
-				glEnableVertexAttribArray(2);
-				glVertexAttribPointer((GLuint)3, 2, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, uv));
-				glEnableVertexAttribArray(3);
-				glVertexAttribPointer((GLuint)4, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-					(const GLvoid*)offsetof(struct gfx::Vertex_T, tangent));
-				glEnableVertexAttribArray(4);
-				glBindVertexArray(0);
-				glFlush();
-
-				CINFO(alib::StringFormat("    buffered into VAO %0").arg(m_vao).str());
+				return m_color;
 			}
-
 			void setColor(glm::vec4 color)
 			{
 				m_color = color;
@@ -146,22 +102,33 @@ namespace gfx
 			GFXFont()
 			{
 			}
-			GFXFont(const char *fontfile)
+			// Takes a reference to the shared atlas of the font file, only the first font of a file loads it
+			GFXFont(const char *fontfile, int size = GFX_GUI_DEFAULT_FONT_SIZE)
+			{
+				m_face = GFXFontCache::acquire(fontfile, size);
+			}
+			GFXFont(const GFXFont & other)
+			{
+				m_face = other.m_face;
+				m_color = other.m_color;
+				if (m_face != GFX_NULLPTR)
+					m_face->refs++;
+			}
+			GFXFont & operator=(const GFXFont & other)
+			{
+				if (other.m_face != GFX_NULLPTR)
+					other.m_face->refs++;
+				GFXFontCache::release(m_face);
+				m_face = other.m_face;
+				m_color = other.m_color;
+				return *this;
+			}
+			~GFXFont()
 			{
-				gfx::VertexData o = 
-					gfx::PrimativeGenerator::pack_object(
-						&gfx::PrimativeGenerator::generate_square_meshes(256),
-						GEN_SQUAREUVS, gfx::WHITE);
-				loadTextures(fontfile);
-				init(o);
+				GFXFontCache::release(m_face);
 			}
 		private:
-			GLuint
-				m_vao,
-				m_buffer,
-				m_tex = GL_TEXTURE0;
-			int
-				m_dataSize = 0;
+			GFXFontFace_T * m_face = GFX_NULLPTR;
 			glm::vec4 m_color = gfx::WHITE_A;
 		};
 
@@ -233,7 +200,7 @@ namespace gfx
 
 			GFXUnit()
 			{
-				m_id = GFX_DEFAULT_ID;
+				m_id = GFX_NULL_ID;
 				m_manager = GFX_NULLPTR;
 			}
 			GFXUnit(GFXID id, GFXManager * manager)
@@ -278,6 +245,83 @@ namespace gfx
 				return mousePos;
 			}
 
+			// Top left corner in screen space
+			glm::vec2 getWorldPos()
+			{
+				glm::vec2 pos = m_pos;
+				GFXComponent * parent = m_parent;
+				while (parent != GFX_NULLPTR && parent != this)
+				{
+					pos += parent->m_pos;
+					parent = parent->getParent();
+				}
+				return pos;
+			}
+
+			// Puts the component's current screen rect in the manager's spatial grid, call after it moves or resizes
+			void track();
+
+			// Holds a fired signal with the manager until the frame's events are checked, fires it at once without a manager
+			void queueEvent(const GFXSignal * signal);
+
+			// Flags the component and everything up to its layout root as needing layout, and queues the root
+			// with the manager. Only queued roots are validated on the next update, the rest of the GUI is left alone.
+			void requestLayout();
+			bool needsLayout()
+			{
+				return m_layoutDirty;
+			}
+			void clearLayout()
+			{
+				m_layoutDirty = false;
+			}
+			// Windows lay themselves out independently of whatever holds them
+			virtual bool isLayoutRoot()
+			{
+				return false;
+			}
+
+			GFXLayoutParams_T * getLayoutParams()
+			{
+				return &m_layoutParams;
+			}
+			// The size the component wants in its parent's layout, cached until requestLayout is called on it or below it
+			glm::vec2 getMeasuredSize()
+			{
+				if (!m_measured)
+				{
+					m_measuredSize = measure();
+					m_measured = true;
+				}
+				return m_measuredSize;
+			}
+			virtual glm::vec2 measure()
+			{
+				if (m_layoutParams.size == glm::vec2(0.0f))
+					m_layoutParams.size = m_size;
+				return glm::max(m_layoutParams.size, m_layoutParams.minSize);
+			}
+
+			// Marks the component and its parents to receive events this frame
+			void route(std::vector<GFXComponent*> * routed)
+			{
+				GFXComponent * component = this;
+				while (component != GFX_NULLPTR && !component->m_routed)
+				{
+					component->m_routed = true;
+					routed->push_back(component);
+					component = component->getParent();
+				}
+			}
+			void unroute()
+			{
+				m_routed = false;
+			}
+			bool isRouted()
+			{
+				return m_routed;
+			}
+
 			GFXComponent * getParent()
 			{
 				return m_parent;
@@ -291,16 +335,12 @@ namespace gfx
 			virtual void validate() = 0;
 			virtual void update(gfx::engine::GLContent * content) = 0;
 			virtual bool checkEvents(gfx::engine::GLContent * content) = 0;
-			virtual void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles) = 0;
+			virtual void draw(glm::mat4 modelMat, GFXBatch * batch) = 0;
 
+			// Shares a colour style, it isn't copied so it must outlive the component (see GFXManager::createColorStyle)
 			GFXComponent * setColorStyle(GFXColorStyle_T * colorStyle)
 			{
-				if (m_colorStyle != GFX_NULL_COLORSTYLE)
-					delete(m_colorStyle);
-				m_colorStyle = new GFXColorStyle_T;
-				m_colorStyle->colors[0] = colorStyle->colors[0];
-				m_colorStyle->colors[1] = colorStyle->colors[1];
-				m_colorStyle->colors[2] = colorStyle->colors[2];
+				m_colorStyle = colorStyle;
 				return this;
 			}
 			GFXColorStyle_T * getColorStyle()
@@ -334,13 +374,32 @@ namespace gfx
 			}
 			void invisible()
 			{
-				m_visible = true;
+				m_visible = false;
 			}
 			bool isVisible()
 			{
 				return m_visible;
 			}
 
+			// Marks this component as changed, and everything it sits in with it, so cached layers get redrawn
+			void invalidate()
+			{
+				m_dirty = true;
+				if (m_parent != GFX_NULLPTR && m_parent != this)
+					m_parent->invalidate();
+			}
+			bool isDirty()
+			{
+				return m_dirty;
+			}
+
+			// Redraws any cached layer the component keeps, called before the frame's batch begins.
+			// Returns true if a layer was redrawn, components without one have nothing to do.
+			virtual bool renderLayer(gfx::engine::GLContent *, GFXBatch *)
+			{
+				return false;
+			}
+
 			virtual std::string toString()
 			{
 				return alib::StringFormat("id = %0 pos = %1,%2 size = %3,%4").arg(getId()).arg(m_pos.x).arg(m_pos.y).arg(m_size.x).arg(m_size.y).str();
@@ -358,6 +417,13 @@ namespace gfx
 
 			bool m_enabled = true;
 			bool m_visible = true;
+			bool m_dirty = true;
+			bool m_routed = false;
+
+			GFXLayoutParams_T m_layoutParams;
+			glm::vec2 m_measuredSize = glm::vec2(0.0f);
+			bool m_measured = false;
+			bool m_layoutDirty = true;
 		};
 
 		class GFXGroup
@@ -410,17 +476,27 @@ namespace gfx
 				return success;
 			}
 
-			void drawGroup(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void drawGroup(glm::mat4 modelMat, GFXBatch * batch)
 			{
 				for (GFXComponent * component : m_group)
 					if (component->isVisible())
-						component->draw(modelMat, handles);
+						component->draw(modelMat, batch);
+			}
+
+			int renderGroupLayers(gfx::engine::GLContent * content, GFXBatch * batch)
+			{
+				int rendered = 0;
+				for (GFXComponent * component : m_group)
+					if (component->isVisible() && component->renderLayer(content, batch))
+						rendered++;
+				return rendered;
 			}
 
 			bool checkGroupEvents(gfx::engine::GLContent * content)
 			{
+				// only components the manager routed this frame's events to are checked
 				for (int ix = m_group.size() - 1; ix >= 0; --ix)
-					if (m_group[ix]->isEnabled() && m_group[ix]->checkEvents(content))
+					if (m_group[ix]->isRouted() && m_group[ix]->isEnabled() && m_group[ix]->checkEvents(content))
 						return true;
 				return false;
 			}
@@ -440,7 +516,56 @@ namespace gfx
 			void validateGroup()
 			{
 				for (GFXComponent * component : m_group)
+				{
 					component->validate();
+					component->clearLayout();
+				}
+			}
+
+			// Validates only the components that asked for layout since they were last validated
+			void validateDirtyGroup()
+			{
+				for (GFXComponent * component : m_group)
+					if (component->needsLayout())
+					{
+						component->validate();
+						component->clearLayout();
+					}
+			}
+
+			// Size the group needs under a box layout, from the cached sizes of its visible components
+			glm::vec2 measureGroup(GFXBoxLayout * layout)
+			{
+				std::vector<GFXLayoutItem_T> items;
+				getLayoutItems(&items);
+				return layout->measure(items);
+			}
+
+			// Positions and sizes the visible components with a box layout
+			void arrangeGroup(GFXBoxLayout * layout, glm::vec2 origin, glm::vec2 size)
+			{
+				std::vector<GFXLayoutItem_T> items;
+				getLayoutItems(&items);
+				layout->arrange(items, origin, size);
+				int ix = 0;
+				for (GFXComponent * component : m_group)
+					if (component->isVisible())
+					{
+						component->setPos(items[ix].pos);
+						component->setSize(items[ix].size);
+						ix++;
+					}
+			}
+
+			void clearGroup()
+			{
+				m_group.clear();
+			}
+
+			void invalidateGroup()
+			{
+				for (GFXComponent * component : m_group)
+					component->invalidate();
 			}
 
 			glm::vec2 getMinimumBounds(float padding)
@@ -461,24 +586,6 @@ namespace gfx
 				return glm::vec2(right + padding, top + padding);
 			}
 
-			GFXID verifyId(GFXID id)
-			{
-				if (id == GFX_NULL_ID)
-					id = GFX_DEFAULT_ID;
-				if (!componentExists(id))
-					return id;
-
-				int extra = 1;
-				std::string newId;
-				do
-				{
-					newId = alib::StringFormat("%0%1").arg(id).arg(extra).str();
-					extra++;
-				} while (getComponent(newId));
-
-				return newId;
-			}
-
 			void bringForward(GFXComponent * component)
 			{
 				for (int i = 0; i < m_group.size(); ++i)
@@ -519,6 +626,18 @@ namespace gfx
 					}
 			}
 		private:
+			void getLayoutItems(std::vector<GFXLayoutItem_T> * items)
+			{
+				for (GFXComponent * component : m_group)
+					if (component->isVisible())
+					{
+						GFXLayoutItem_T item;
+						item.measured = component->getMeasuredSize();
+						item.grow = component->getLayoutParams()->grow;
+						items->push_back(item);
+					}
+			}
+
 			std::vector<GFXComponent*> m_group;
 		};
 
@@ -550,38 +669,260 @@ namespace gfx
 				return this;
 			}
 
-			GFXID addId(GFXID id)
+			// Creates a component (or anything else) owned by the manager, it lives until the manager is released
+			template <typename T, typename... Args>
+			T * create(Args&&... args)
+			{
+				return m_arena.create<T>(std::forward<Args>(args)...);
+			}
+
+			// Gets a colour style owned by the manager, components with the same colours share one
+			GFXColorStyle_T * createColorStyle(glm::vec4 c0, glm::vec4 c1, glm::vec4 c2)
+			{
+				for (GFXColorStyle_T * style : m_colorStyles)
+					if (style->colors[0] == c0 && style->colors[1] == c1 && style->colors[2] == c2)
+						return style;
+				GFXColorStyle_T * style = m_colorStylePool.create();
+				style->colors[0] = c0;
+				style->colors[1] = c1;
+				style->colors[2] = c2;
+				m_colorStyles.push_back(style);
+				return style;
+			}
+
+			// Destroys everything the manager created and forgets every component, in one go.
+			// Call while the GL context is still current so fonts and meshes can free their GPU objects.
+			void release()
+			{
+				clearGroup();
+				m_slots.clear();
+				m_freeSlots.clear();
+				m_focused = GFX_NULL_ID;
+				m_grid.clear();
+				m_routed.clear();
+				m_candidates.clear();
+				m_captured.clear();
+				m_layoutQueue.clear();
+				m_events.clear();
+				m_colorStyles.clear();
+				m_colorStyle = GFX_NULL_COLORSTYLE;
+				m_arena.release();
+				m_colorStylePool.release();
+			}
+
+			// Bytes handed out by the manager's arena
+			size_t getArenaBytes()
 			{
-				//id = verifyId(id);
-				//gfxids.push_back(id);
-				return id;
+				return m_arena.getBytesUsed();
 			}
 
-			void setId(GFXID id, GFXComponent * component)
+			// Registers a component and returns its handle, the name should be a literal as it isn't copied.
+			// A component that is already registered keeps its handle.
+			GFXID addId(const char * name, GFXComponent * component)
 			{
-				for (int ix = 0; ix < m_gfxids.size(); ++ix)
-					if (m_gfxids[ix] == component->getId())
-						m_gfxids.erase(m_gfxids.begin() + ix);
-				component->setId(addId(id));
+				if (getComponent(component->getId()) == component)
+					return component->getId();
+
+				uint32_t index;
+				if (!m_freeSlots.empty())
+				{
+					index = m_freeSlots.back();
+					m_freeSlots.pop_back();
+				}
+				else
+				{
+					if (m_slots.size() >= GFX_ID_INDEX_MASK)
+					{
+						CERROR("out of component ids.", __FILE__, __LINE__, "GFXManager", __func__);
+						return GFX_NULL_ID;
+					}
+					index = m_slots.size();
+					m_slots.push_back(GFXSlot_T());
+				}
+				GFXSlot_T & slot = m_slots[index];
+				slot.component = component;
+				slot.name = name;
+				return makeId(index, slot.generation);
+			}
+
+			// Frees a component's handle, any copies of it stop resolving
+			void removeId(GFXComponent * component)
+			{
+				GFXID id = component->getId();
+				if (getComponent(id) != component)
+					return;
+				GFXSlot_T & slot = m_slots[id & GFX_ID_INDEX_MASK];
+				slot.component = GFX_NULLPTR;
+				slot.name = "";
+				// generation 0 is skipped so no live handle is ever GFX_NULL_ID
+				slot.generation = (slot.generation + 1) & GFX_ID_GENERATION_MASK;
+				if (slot.generation == 0)
+					slot.generation = 1;
+				m_freeSlots.push_back(id & GFX_ID_INDEX_MASK);
+				component->setId(GFX_NULL_ID);
+			}
+
+			// Looks up a handle, null if it was never issued or its component has since been removed
+			GFXComponent * getComponent(GFXID id)
+			{
+				uint32_t index = id & GFX_ID_INDEX_MASK;
+				if (id == GFX_NULL_ID || index >= m_slots.size() || m_slots[index].generation != id >> GFX_ID_INDEX_BITS)
+					return GFX_NULLPTR;
+				return m_slots[index].component;
+			}
+			bool isValidId(GFXID id)
+			{
+				return getComponent(id) != GFX_NULLPTR;
+			}
+			const char * getName(GFXID id)
+			{
+				return isValidId(id) ? m_slots[id & GFX_ID_INDEX_MASK].name : "";
+			}
+			int getComponentCount()
+			{
+				return m_slots.size() - m_freeSlots.size();
+			}
+
+			// Gets every registered component anywhere below root, found by following each one's parents up to it
+			void getDescendants(GFXComponent * root, std::vector<GFXComponent*> * descendants)
+			{
+				for (GFXSlot_T & slot : m_slots)
+				{
+					GFXComponent * component = slot.component;
+					if (component == GFX_NULLPTR || component == root)
+						continue;
+					// the top of a tree is its own parent so the walk stops there
+					GFXComponent * parent = component->getParent();
+					while (parent != GFX_NULLPTR && parent != root && parent->getParent() != parent)
+						parent = parent->getParent();
+					if (parent == root)
+						descendants->push_back(component);
+				}
 			}
 
 			bool checkEvents(gfx::engine::GLContent * content)
 			{
-				return checkGroupEvents(content);
+				routeEvents(content);
+				bool handled = checkGroupEvents(content);
+				m_events.dispatch();
+				return handled;
 			}
 			void update(gfx::engine::GLContent * content)
 			{
+				layout();
 				updateGroup(content);
+				m_events.dispatch();
+			}
+
+			// Triggers fired while checking events wait here until every component has been checked
+			GFXEventQueue * getEventQueue()
+			{
+				return &m_events;
 			}
 
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			// Validates the layout roots queued since the last update, the only part of the GUI that can have changed
+			void layout()
 			{
-				drawGroup(modelMat, handles);
+				for (int ix = 0; ix < m_layoutQueue.size(); ++ix)
+				{
+					GFXComponent * root = m_layoutQueue[ix];
+					if (root->needsLayout())
+					{
+						root->validate();
+						root->clearLayout();
+					}
+				}
+				m_layoutQueue.clear();
+			}
+			void queueLayout(GFXComponent * root)
+			{
+				for (GFXComponent * c : m_layoutQueue)
+					if (c == root)
+						return;
+				m_layoutQueue.push_back(root);
+			}
+
+			// Picks the components that get this frame's events: those under the mouse, those holding the mouse
+			// from an earlier press and the focused one, along with everything containing them
+			void routeEvents(gfx::engine::GLContent * content)
+			{
+				for (GFXComponent * component : m_routed)
+					component->unroute();
+				m_routed.clear();
+
+				m_candidates.clear();
+				m_grid.query(content->getMousePos(), &m_candidates);
+				for (GFXComponent * component : m_candidates)
+					component->route(&m_routed);
+				for (GFXComponent * component : m_captured)
+					component->route(&m_routed);
+				GFXComponent * focused = getComponent(m_focused);
+				if (focused != GFX_NULLPTR)
+					focused->route(&m_routed);
 			}
 
+			GFXSpatialGrid * getSpatialGrid()
+			{
+				return &m_grid;
+			}
+
+			// A component that was pressed keeps getting events until it's released, even once the mouse leaves it
+			void capture(GFXComponent * component)
+			{
+				for (GFXComponent * c : m_captured)
+					if (c == component)
+						return;
+				m_captured.push_back(component);
+			}
+			void releaseCapture(GFXComponent * component)
+			{
+				for (int ix = 0; ix < m_captured.size(); ++ix)
+					if (m_captured[ix] == component)
+					{
+						m_captured.erase(m_captured.begin() + ix);
+						return;
+					}
+			}
+
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
+			{
+				drawGroup(modelMat, batch);
+			}
+
+			// Draws the whole GUI through the manager's batch, load the ortho projection first.
+			// Windows that changed are redrawn into their layers first, then every window is composited as one quad.
+			void draw(gfx::engine::GLContent * content)
+			{
+				m_layersRendered = renderGroupLayers(content, &m_batch);
+
+				m_batch.begin(content->getWindowSize());
+				drawGroup(glm::mat4(1.0f), &m_batch);
+				m_batch.end();
+			}
+
+			// Gets the draw call and vertex counts of the last frame's composite pass
+			GFXBatchStats_T getBatchStats()
+			{
+				return m_batch.getStats();
+			}
+
+			// Gets the number of window layers redrawn last frame
+			int getLayersRendered()
+			{
+				return m_layersRendered;
+			}
+
+			// Forces every window to redraw its layer, e.g. after the GL context or fonts change
+			void invalidateAll()
+			{
+				invalidateGroup();
+			}
+
+			// Validates the top level components that need it, everything the first time
 			void validate()
 			{
-				validateGroup();
+				validateDirtyGroup();
+				m_layoutQueue.clear();
 			}
 
 			GFXComponent * init(GFXManager * manager, GFXComponent * parent)
@@ -597,11 +938,20 @@ namespace gfx
 
 			void setFocused(GFXComponent * component)
 			{
-				m_focused = component;
+				GFXID id = component != GFX_NULLPTR ? component->getId() : GFX_NULL_ID;
+				if (id == m_focused)
+					return;
+				// focus changes how both components draw, e.g. the text edit cursor
+				GFXComponent * focused = getComponent(m_focused);
+				if (focused != GFX_NULLPTR)
+					focused->invalidate();
+				if (component != GFX_NULLPTR)
+					component->invalidate();
+				m_focused = id;
 			}
 			bool isFocused(GFXComponent * component)
 			{
-				return component == m_focused;
+				return component->getId() != GFX_NULL_ID && component->getId() == m_focused;
 			}
 
 			GFXManager() {};
@@ -610,27 +960,108 @@ namespace gfx
 				m_fboId = fboId;
 				m_programId = programId;
 			}
+			// A global manager outlives the GL context, so this doesn't touch GL: whatever release() wasn't
+			// called for is dropped without running the component destructors that free layers and fonts
+			~GFXManager()
+			{
+				m_arena.abandon();
+			}
 		protected:
 			gfx::engine::FBOID m_fboId;
 			gfx::engine::GLSLProgramID m_programId;
-			std::vector<GFXID> m_gfxids;
-			GFXComponent * m_focused = GFX_NULLPTR;
+			struct GFXSlot_T
+			{
+				GFXComponent * component = GFX_NULLPTR;
+				const char * name = "";
+				uint32_t generation = 1;
+			};
+			static GFXID makeId(uint32_t index, uint32_t generation)
+			{
+				return (generation << GFX_ID_INDEX_BITS) | index;
+			}
+
+			std::vector<GFXSlot_T> m_slots;
+			std::vector<uint32_t> m_freeSlots;
+			GFXID m_focused = GFX_NULL_ID;
+			GFXBatch m_batch;
+			int m_layersRendered = 0;
+
+			GFXSpatialGrid m_grid;
+			std::vector<GFXComponent*> m_routed;
+			std::vector<GFXComponent*> m_candidates;
+			std::vector<GFXComponent*> m_captured;
+			std::vector<GFXComponent*> m_layoutQueue;
+			GFXEventQueue m_events;
+
+			GFXArena m_arena;
+			GFXPool<GFXColorStyle_T> m_colorStylePool;
+			std::vector<GFXColorStyle_T*> m_colorStyles;
 		};
 
+		inline void GFXComponent::track()
+		{
+			if (m_manager != GFX_NULLPTR)
+				m_manager->getSpatialGrid()->update(this, glm::vec4(getWorldPos(), m_size));
+		}
+
+		inline void GFXComponent::queueEvent(const GFXSignal * signal)
+		{
+			if (m_manager != GFX_NULLPTR)
+				m_manager->getEventQueue()->post(signal);
+			else
+				signal->fire();
+		}
+
+		inline void GFXComponent::requestLayout()
+		{
+			GFXComponent * component = this;
+			while (component != GFX_NULLPTR)
+			{
+				component->m_layoutDirty = true;
+				component->m_measured = false;
+				if (component->isLayoutRoot() || component->getParent() == m_manager)
+				{
+					if (m_manager != GFX_NULLPTR)
+						m_manager->queueLayout(component);
+					return;
+				}
+				component = component->getParent();
+			}
+		}
+
 		class GFXContainer : public GFXComponent, public GFXGroup
 		{
 		public:
 			GFXContainer * addComponent(GFXComponent * component)
 			{
 				add(component);
+				requestLayout();
 				return this;
 			}
 
+			// Lets the container size and place its components instead of them keeping their own positions
+			void setLayout(GFXBoxLayout layout)
+			{
+				m_layout = layout;
+				requestLayout();
+			}
+			GFXBoxLayout * getLayout()
+			{
+				return &m_layout;
+			}
+
+			glm::vec2 measure()
+			{
+				if (!m_layout.isEnabled())
+					return GFXComponent::measure();
+				return glm::max(measureGroup(&m_layout), m_layoutParams.minSize);
+			}
+
 			GFXComponent * init(GFXManager * manager, GFXComponent * parent)
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("container"));
+				setId(manager->addId("container", this));
 				if (m_colorStyle == GFX_NULL_COLORSTYLE)
 					inheritColorStyle();
 				initGroup(manager, this);
@@ -639,6 +1070,11 @@ namespace gfx
 
 			void validate()
 			{
+				if (m_layout.isEnabled())
+				{
+					invalidate();
+					arrangeGroup(&m_layout, glm::vec2(0.0f), m_size);
+				}
 				validateGroup();
 			}
 
@@ -652,10 +1088,10 @@ namespace gfx
 				return checkGroupEvents(content);
 			}
 
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
 			{
-				drawMesh(modelMat, handles);
-				drawGroup(modelMat * getRelativeModelMat(), handles);
+				drawMesh(modelMat, batch);
+				drawGroup(modelMat * getRelativeModelMat(), batch);
 			}
 
 			GFXContainer() : GFXComponent() {}
@@ -672,12 +1108,14 @@ namespace gfx
 				m_vao = miniMesh.m_vao;
 				m_buffer = miniMesh.m_buffer;
 				m_dataSize = miniMesh.m_dataSize;
+				m_vertices = miniMesh.m_vertices;
 				m_rotation = miniMesh.m_rotation;
 				m_theta = miniMesh.m_theta;
 				m_color = miniMesh.m_color;
 			}
 			GFXContainer(GFXMesh mesh) : GFXComponent(mesh) {}
-		private:
+		protected:
+			GFXBoxLayout m_layout;
 		};
 		
 
@@ -689,8 +1127,8 @@ namespace gfx
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("label"));
-				m_font = GFXFont(GFX_Courier_FONT);
+				setId(manager->addId("label", this));
+				m_font = GFXFont(GFX_Courier_FONT, m_size.y);
 				return this;
 			}
 			void validate()
@@ -705,10 +1143,11 @@ namespace gfx
 			{
 				return false;
 			}
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
 			{
-				for (int ix = 0; ix < m_text.length(); ix++)
-					m_font.draw(m_text[ix], modelMat, glm::vec2(ix * m_size.x / 2, m_size.y / 2) + m_pos, m_size, handles);
+				if (!m_layout.isValid(m_font.getFace(), glm::vec2(), false))
+					m_layout.build(m_text, m_font.getFace(), glm::vec2(), false);
+				m_layout.draw(modelMat * glm::translate(glm::mat4(1.), glm::vec3(m_pos + glm::vec2(0, m_size.y / 2), 0)), m_font.getColor(), batch);
 			}
 
 			float getLength()
@@ -724,11 +1163,14 @@ namespace gfx
 			void setText(std::string text)
 			{
 				m_text = text;
+				m_layout.invalidate();
+				invalidate();
 			}
 
 			void setColor(glm::vec4 color)
 			{
 				m_font.setColor(color);
+				invalidate();
 			}
 
 			GFXLabel(std::string text, int fontSize)
@@ -739,6 +1181,7 @@ namespace gfx
 
 		protected:
 			GFXFont m_font;
+			GFXTextLayout m_layout;
 			std::string m_text;
 		};
 
@@ -753,6 +1196,7 @@ namespace gfx
 				{
 					m_onDown = true;
 					m_manager->setFocused(this);
+					m_manager->capture(this);
 				}
 				return isTrue;
 			}
@@ -772,6 +1216,7 @@ namespace gfx
 					m_heldCounter = 0;
 					m_onDown = false;
 					m_onReleased = true;
+					m_manager->releaseCapture(this);
 				}
 				else
 					m_onReleased = false;
@@ -882,15 +1327,23 @@ namespace gfx
 
 
 
-		class GFXButton : public GFXClickable, public GFXLinker<GFXButton>
+		// Triggers a button can be linked to
+		enum GFXButtonTrigger_T
+		{
+			GFX_BUTTON_PRESSED,
+			GFX_BUTTON_DOWN,
+			GFX_BUTTON_RELEASED,
+			GFX_BUTTON_TRIGGER_COUNT
+		};
+
+		class GFXButton : public GFXClickable, public GFXLinker<GFXButton, GFXButtonTrigger_T, GFX_BUTTON_TRIGGER_COUNT>
 		{
 		public:
 
 			void update(gfx::engine::GLContent * content)
 			{
+				glm::vec4 oldColor = m_back->getColor();
 				m_back->setPos(m_pos);
-				if(m_toggledState)
-					m_back->setColor(glm::vec3(m_colorStyle->colors[0]) / 2.0f);
 				
 				//if (isHovering(content))
 				//	m_back->setColor(m_colorStyle->colors[0] * 1.5f);
@@ -898,9 +1351,13 @@ namespace gfx
 				//	m_back->setColor(m_colorStyle->colors[0]);
 				if (isDown(content))
 					m_back->setColor(m_colorStyle->colors[0] / 1.5f);
+				else if (m_toggledState)
+					m_back->setColor(glm::vec3(m_colorStyle->colors[0]) / 2.0f);
 				else
 					m_back->setColor(m_colorStyle->colors[0]);
-					
+
+				if (m_back->getColor() != oldColor)
+					invalidate();
 			}
 			bool checkEvents(gfx::engine::GLContent * content)
 			{
@@ -910,37 +1367,40 @@ namespace gfx
 				onButtonReleased(content);
 				return m_onDown;
 			}
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
 			{
 				m_back->setPos(m_pos);
-				m_back->drawMesh(modelMat, handles);
+				m_back->drawMesh(modelMat, batch);
 				if(m_text != "")
-					 m_label->draw(modelMat, handles);
+					 m_label->draw(modelMat, batch);
 			}
 		
 			GFXComponent * init(GFXManager * manager, GFXComponent * parent)
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("button"));
+				setId(manager->addId("button", this));
 				if (m_colorStyle == GFX_NULL_COLORSTYLE)
 					inheritColorStyle();
 
-				m_back = new GFXRectangleMesh(m_pos, m_size);
+				m_back = manager->create<GFXRectangleMesh>(m_pos, m_size);
 				m_back->setColor(m_colorStyle->colors[0]);
 				if (m_text != "")
 				{
-					m_label = new GFXLabel(m_text, GFX_GUI_DEFAULT_FONT_SIZE);
+					m_label = manager->create<GFXLabel>(m_text, GFX_GUI_DEFAULT_FONT_SIZE);
 					m_label->init(manager, this);
 					m_label->setColor(m_colorStyle->colors[2]);
 					m_label->setPos(m_pos + m_size / 2.0f);
 					m_label->center();
 				}
+				track();
 				return this;
 			}
 
 			void validate()
 			{
+				invalidate();
+				track();
 				m_back->setPos(m_pos);
 				m_back->setSize(m_size);
 				if (m_text != "")
@@ -955,21 +1415,21 @@ namespace gfx
 				if (isPressed(content))
 				{
 					m_toggledState = !m_toggledState && m_isToggleable;
-					callTrigger(&GFXButton::onButtonPressed);
+					callTrigger(GFX_BUTTON_PRESSED);
 				}
 			}
 			void onButtonDown(gfx::engine::GLContent * content)
 			{
 				if (isDown(content))
 				{
-					callTrigger(&GFXButton::onButtonDown);
+					callTrigger(GFX_BUTTON_DOWN);
 				}
 			}
 			void onButtonReleased(gfx::engine::GLContent * content)
 			{
 				if (isReleased(content))
 				{
-					callTrigger(&GFXButton::onButtonReleased);
+					callTrigger(GFX_BUTTON_RELEASED);
 				}
 			}
 			
@@ -977,6 +1437,10 @@ namespace gfx
 			{
 				return m_toggledState;
 			}
+			void setToggled(bool toggled)
+			{
+				m_toggledState = toggled;
+			}
 
 			void setText(std::string text)
 			{
@@ -1006,7 +1470,21 @@ namespace gfx
 			GFXLabel * m_label;
 		};
 
-		class GFXWindow : public GFXClickable, public GFXLinker<GFXWindow>
+		// Triggers a window can be linked to
+		enum GFXWindowTrigger_T
+		{
+			GFX_WINDOW_PRESSED,
+			GFX_WINDOW_DOWN,
+			GFX_WINDOW_RELEASED,
+			GFX_WINDOW_DRAGGING,
+			GFX_WINDOW_MOVE,
+			GFX_WINDOW_CLOSE,
+			GFX_WINDOW_SCALED,
+			GFX_WINDOW_RESIZE,
+			GFX_WINDOW_TRIGGER_COUNT
+		};
+
+		class GFXWindow : public GFXClickable, public GFXLinker<GFXWindow, GFXWindowTrigger_T, GFX_WINDOW_TRIGGER_COUNT>
 		{
 		public:
 			void update(gfx::engine::GLContent * content)
@@ -1119,22 +1597,106 @@ namespace gfx
 					focus();
 				return focused;
 			}
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
+			{
+				if (m_layered && m_layerSize.x > 0)
+					drawLayer(modelMat*getRelativeModelMat(), batch);
+				else
+					drawContents(modelMat*getRelativeModelMat(), batch);
+			}
+
+			// Redraws the window into its layer if anything in it changed since it was last drawn.
+			// The layer grows in steps so dragging a resize bar doesn't reallocate it every frame.
+			bool renderLayer(gfx::engine::GLContent * content, GFXBatch * batch)
 			{
-				m_components.draw(modelMat*getRelativeModelMat(), handles);
-				m_group.drawGroup(modelMat*getRelativeModelMat(), handles);
+				if (!m_layered)
+					return false;
+				glm::ivec2 size = glm::ivec2(glm::ceil(m_size));
+				if (size.x <= 0 || size.y <= 0)
+					return false;
+				if (size.x > m_layerSize.x || size.y > m_layerSize.y)
+				{
+					if (m_layerSize.x > 0)
+						m_layer.release();
+					m_layerSize = ((size + GFX_WINDOW_LAYER_STEP - 1) / GFX_WINDOW_LAYER_STEP) * GFX_WINDOW_LAYER_STEP;
+					m_layer = gfx::engine::FBO(m_layerSize.x, m_layerSize.y);
+					m_dirty = true;
+				}
+				if (!m_dirty)
+					return false;
+
+				glm::ivec2 screen = glm::ivec2(content->getWindowSize());
+				gfx::engine::GLStateCache::bindFramebuffer(m_layer.get_fboid());
+				// the screen's ortho projection is kept, the viewport is shifted so the window's top left lands on the layer's
+				gfx::engine::GLStateCache::viewport(0, m_layerSize.y - screen.y, screen.x, screen.y);
+				content->clearAlpha();
+				content->clearColorBuffer();
+				content->clearColor();
+				// colour is stored premultiplied so the layer's alpha is the window's coverage
+				gfx::engine::GLStateCache::blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+				batch->begin(glm::vec2(m_layerSize));
+				drawContents(glm::mat4(1.0f), batch);
+				batch->end();
+
+				gfx::engine::FBO::unbind();
+				gfx::engine::GLStateCache::viewport(0, 0, screen.x, screen.y);
+				gfx::engine::GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				m_dirty = false;
+				return true;
+			}
+
+			// Layered windows are only redrawn when they change, otherwise their cached texture is composited
+			void setLayered(bool layered)
+			{
+				m_layered = layered;
+				invalidate();
+			}
+			bool isLayered()
+			{
+				return m_layered;
 			}
 
 			GFXWindow * addComponent(GFXComponent * component)
 			{
 				m_group.add(component);
+				invalidate();
+				requestLayout();
 				return this;
 			}
 
+			// Lets the window size and place its components in the area under the top bar
+			void setLayout(GFXBoxLayout layout)
+			{
+				m_layout = layout;
+				requestLayout();
+			}
+			GFXBoxLayout * getLayout()
+			{
+				return &m_layout;
+			}
+
+			bool isLayoutRoot()
+			{
+				return true;
+			}
+
+			// Smallest size that fits the window's components, kept until one of them requests layout
+			glm::vec2 measure()
+			{
+				if (m_layout.isEnabled())
+					return m_group.measureGroup(&m_layout) + glm::vec2(0, m_topBarSize);
+				return m_group.getMinimumBounds(GFX_GUI_DEFAULT_PADDING);
+			}
+
 			void validate()
 			{
-				m_minSize = m_group.getMinimumBounds(GFX_GUI_DEFAULT_PADDING);
+				invalidate();
+				m_minSize = getMeasuredSize();
 				inflateToContent();
+				track();
+				if (m_layout.isEnabled())
+					m_group.arrangeGroup(&m_layout, glm::vec2(0, m_topBarSize), m_size - glm::vec2(0, m_topBarSize));
 
 				m_components.setPos(glm::vec2());
 				m_components.setSize(m_size);
@@ -1160,7 +1722,7 @@ namespace gfx
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("window"));
+				setId(manager->addId("window", this));
 				if (m_colorStyle == GFX_NULL_COLORSTYLE)
 					inheritColorStyle();
 
@@ -1170,52 +1732,48 @@ namespace gfx
 				m_components.setColorStyle(m_colorStyle);
 
 				// alter colorstyle for each component
-				GFXColorStyle_T * colorStyle = new GFXColorStyle_T;
-				colorStyle->colors[0] = glm::vec4(0);
-				colorStyle->colors[1] = m_colorStyle->colors[1];
-				colorStyle->colors[2] = m_colorStyle->colors[2];
+				GFXColorStyle_T * colorStyle = manager->createColorStyle(glm::vec4(0), m_colorStyle->colors[1], m_colorStyle->colors[2]);
 
 				// left resize grab
-				m_leftResizeBar = new gfx::gui::GFXButton(glm::vec2(), glm::vec2(m_deadzone, m_size.y));
+				m_leftResizeBar = manager->create<GFXButton>(glm::vec2(), glm::vec2(m_deadzone, m_size.y));
 				m_components.addComponent(m_leftResizeBar);
 				m_leftResizeBar->setColorStyle(colorStyle);
 				// right resize grab
-				m_rightResizeBar = new gfx::gui::GFXButton(glm::vec2(m_size.x - m_deadzone, 0), glm::vec2(m_deadzone, m_size.y));
+				m_rightResizeBar = manager->create<GFXButton>(glm::vec2(m_size.x - m_deadzone, 0), glm::vec2(m_deadzone, m_size.y));
 				m_components.addComponent(m_rightResizeBar);
 				m_rightResizeBar->setColorStyle(colorStyle);
 				// bottom resize grab
-				m_bottomResizeBar = new gfx::gui::GFXButton(glm::vec2(0, m_size.y - m_deadzone), glm::vec2(m_size.x, m_deadzone));
+				m_bottomResizeBar = manager->create<GFXButton>(glm::vec2(0, m_size.y - m_deadzone), glm::vec2(m_size.x, m_deadzone));
 				m_components.addComponent(m_bottomResizeBar);
 				m_bottomResizeBar->setColorStyle(colorStyle);
 				// bottom left resize grab
-				m_bottomLeftResizeBar = new gfx::gui::GFXButton(glm::vec2(0, m_size.y - m_deadzone), glm::vec2(m_deadzone, m_deadzone));
+				m_bottomLeftResizeBar = manager->create<GFXButton>(glm::vec2(0, m_size.y - m_deadzone), glm::vec2(m_deadzone, m_deadzone));
 				m_components.addComponent(m_bottomLeftResizeBar);
 				m_bottomLeftResizeBar->setColorStyle(colorStyle);
 				// bottom right resize grab
-				m_bottomRightResizeBar = new gfx::gui::GFXButton(glm::vec2(m_size.x - m_deadzone, m_size.y - m_deadzone), glm::vec2(m_deadzone, m_deadzone));
+				m_bottomRightResizeBar = manager->create<GFXButton>(glm::vec2(m_size.x - m_deadzone, m_size.y - m_deadzone), glm::vec2(m_deadzone, m_deadzone));
 				m_components.addComponent(m_bottomRightResizeBar);
 				m_bottomRightResizeBar->setColorStyle(colorStyle);
 
 				// top move grab
-				m_bar = new gfx::gui::GFXButton(glm::vec2(), glm::vec2(m_size.x, m_topBarSize), m_title);
+				m_bar = manager->create<GFXButton>(glm::vec2(), glm::vec2(m_size.x, m_topBarSize), m_title);
 				m_components.addComponent(m_bar);
 
 				// close window button
-				m_close = new gfx::gui::GFXButton(glm::vec2(m_size.x - m_topBarSize, 0), glm::vec2(m_topBarSize, m_topBarSize));
+				m_close = manager->create<GFXButton>(glm::vec2(m_size.x - m_topBarSize, 0), glm::vec2(m_topBarSize, m_topBarSize));
 				m_components.addComponent(m_close);
-				colorStyle->colors[0] = colorStyle->colors[2];
-				m_close->setColorStyle(colorStyle);
+				m_close->setColorStyle(manager->createColorStyle(m_colorStyle->colors[2], m_colorStyle->colors[1], m_colorStyle->colors[2]));
 
 				// scale window button
-				m_maxmin = new gfx::gui::GFXButton(glm::vec2(m_size.x - m_topBarSize * 2, 0), glm::vec2(m_topBarSize, m_topBarSize));
+				m_maxmin = manager->create<GFXButton>(glm::vec2(m_size.x - m_topBarSize * 2, 0), glm::vec2(m_topBarSize, m_topBarSize));
 				m_components.addComponent(m_maxmin);
-				colorStyle->colors[0] = colorStyle->colors[1];
-				m_maxmin->setColorStyle(colorStyle);
+				m_maxmin->setColorStyle(manager->createColorStyle(m_colorStyle->colors[1], m_colorStyle->colors[1], m_colorStyle->colors[2]));
 				
 				// initialise container
 				m_components.init(manager, this);
 				m_group.initGroup(manager, this);
 
+				track();
 				return this;
 			}
 
@@ -1223,35 +1781,35 @@ namespace gfx
 			{
 				if (onPressed(isPressed(content)))
 				{
-					callTrigger(&GFXWindow::onWindowPressed);
+					callTrigger(GFX_WINDOW_PRESSED);
 				}
 			}
 			void onWindowDown(gfx::engine::GLContent * content)
 			{
 				if (onDown(isDown(content)))
 				{
-					callTrigger(&GFXWindow::onWindowDown);
+					callTrigger(GFX_WINDOW_DOWN);
 				}
 			}
 			void onWindowReleased(gfx::engine::GLContent * content)
 			{
 				if (onReleased(isReleased(content)))
 				{
-					callTrigger(&GFXWindow::onWindowReleased);
+					callTrigger(GFX_WINDOW_RELEASED);
 				}
 			}
 			void onWindowDragging(gfx::engine::GLContent * content)
 			{
 				if (isDragging(content))
 				{
-					callTrigger(&GFXWindow::onWindowDragging);
+					callTrigger(GFX_WINDOW_DRAGGING);
 				}
 			}
 			void onWindowMove(gfx::engine::GLContent * content)
 			{
 				if (m_bar->isDragging(content))
 				{
-					callTrigger(&GFXWindow::onWindowMove);
+					callTrigger(GFX_WINDOW_MOVE);
 				}
 			}
 
@@ -1261,12 +1819,28 @@ namespace gfx
 				{
 					CERROR("failed to close window.", __FILE__, __LINE__, "GFXWindow", __func__);
 				}
+				// the chrome, the user components and anything nested in them were all tracked, so none may stay hittable
+				std::vector<GFXComponent*> subtree;
+				m_manager->getDescendants(this, &subtree);
+				subtree.push_back(this);
+				for (GFXComponent * component : subtree)
+				{
+					m_manager->getSpatialGrid()->remove(component);
+					m_manager->releaseCapture(component);
+					// handles to anything inside the window stop resolving once it's gone
+					m_manager->removeId(component);
+				}
+				if (m_layerSize.x > 0)
+				{
+					m_layer.release();
+					m_layerSize = glm::ivec2();
+				}
 			}
 			void onClose(gfx::engine::GLContent * content)
 			{
 				if (m_close->isReleasedOver(content))
 				{
-					callTrigger(&GFXWindow::onClose);
+					callTrigger(GFX_WINDOW_CLOSE);
 					closeWindow();
 				}
 			}
@@ -1301,7 +1875,7 @@ namespace gfx
 				if (m_maxmin->isReleasedOver(content))
 				{
 					toggleMaximise(content);
-					callTrigger(&GFXWindow::onWindowScaled);
+					callTrigger(GFX_WINDOW_SCALED);
 				}
 			}
 
@@ -1310,7 +1884,7 @@ namespace gfx
 				if(m_isResizable && !m_maximised)
 					if (m_leftResizeBar->isDragging(content) || m_rightResizeBar->isDragging(content) || m_bottomResizeBar->isDragging(content))
 					{
-						callTrigger(&GFXWindow::onResize);
+						callTrigger(GFX_WINDOW_RESIZE);
 					}
 			}
 			
@@ -1348,6 +1922,26 @@ namespace gfx
 				m_title = "Untitled Window";
 			}
 		protected:
+			void drawContents(glm::mat4 modelMat, GFXBatch * batch)
+			{
+				m_components.draw(modelMat, batch);
+				// a window sized smaller than its components shows only what fits under the top bar
+				batch->pushScissor(modelMat, glm::vec2(0, m_topBarSize), m_size);
+				m_group.drawGroup(modelMat, batch);
+				batch->popScissor();
+			}
+
+			// One quad showing the used corner of the layer, which is upside down as GL textures are bottom-up
+			void drawLayer(glm::mat4 modelMat, GFXBatch * batch)
+			{
+				float u = m_size.x / m_layerSize.x;
+				float v = 1.0f - m_size.y / m_layerSize.y;
+				glm::vec4 quad[6] = {
+					glm::vec4(0, 0, 0, 1), glm::vec4(1, 0, u, 1), glm::vec4(1, 1, u, v),
+					glm::vec4(0, 0, 0, 1), glm::vec4(1, 1, u, v), glm::vec4(0, 1, 0, v) };
+				batch->add(quad, 6, modelMat * glm::scale(glm::mat4(1.), glm::vec3(m_size, 1)), gfx::WHITE_A, GFX_GUI_SHADER_LAYER, *m_layer.get_tex());
+			}
+
 			bool isSmallerThanMin(glm::vec2 a, glm::vec2 b)
 			{
 				return a.x < b.x || a.y < b.y;
@@ -1397,26 +1991,41 @@ namespace gfx
 			std::string m_title;
 			GFXGroup m_group;
 			GFXContainer m_components;
+
+			bool m_layered = true;
+			gfx::engine::FBO m_layer;
+			glm::ivec2 m_layerSize = glm::ivec2(0);
+
+			GFXBoxLayout m_layout;
+		};
+
+		// Triggers a spinner can be linked to
+		enum GFXSpinnerTrigger_T
+		{
+			GFX_SPINNER_INCREASE,
+			GFX_SPINNER_DECREASE,
+			GFX_SPINNER_RESET,
+			GFX_SPINNER_TRIGGER_COUNT
 		};
 
-		class GFXSpinner : public GFXContainer, public GFXLinker<GFXSpinner>
+		class GFXSpinner : public GFXContainer, public GFXLinker<GFXSpinner, GFXSpinnerTrigger_T, GFX_SPINNER_TRIGGER_COUNT>
 		{
 		public:
 			GFXComponent * init(GFXManager * manager, GFXComponent * parent)
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("spinner"));
+				setId(manager->addId("spinner", this));
 				if (m_colorStyle == GFX_NULL_COLORSTYLE)
 					inheritColorStyle();
 
-				m_label = new gfx::gui::GFXButton(glm::vec2(m_size.x / 6, 0), glm::vec2(m_size.x / 6 * 4, m_size.y), "0");				
+				m_label = manager->create<GFXButton>(glm::vec2(m_size.x / 6, 0), glm::vec2(m_size.x / 6 * 4, m_size.y), "0");				
 				addComponent(m_label);
 
-				m_plus = new gfx::gui::GFXButton(glm::vec2(), glm::vec2(m_size.x / 6, m_size.y), "+");
+				m_plus = manager->create<GFXButton>(glm::vec2(), glm::vec2(m_size.x / 6, m_size.y), "+");
 				addComponent(m_plus);				
 
-				m_minus = new gfx::gui::GFXButton(glm::vec2(m_size.x / 6 * 5, 0), glm::vec2(m_size.x / 6, m_size.y), "-");
+				m_minus = manager->create<GFXButton>(glm::vec2(m_size.x / 6 * 5, 0), glm::vec2(m_size.x / 6, m_size.y), "-");
 				addComponent(m_minus);				
 
 				initGroup(manager, this);
@@ -1425,6 +2034,7 @@ namespace gfx
 			}
 			void validate()
 			{
+				invalidate();
 				m_label->setPos(glm::vec2(m_size.x / 6, 0));
 				m_label->setSize(glm::vec2(m_size.x / 6*4, m_size.y));
 
@@ -1447,9 +2057,9 @@ namespace gfx
 				onReset(content);
 				return checkGroupEvents(content);
 			}
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
 			{
-				drawGroup(modelMat * getRelativeModelMat(), handles);
+				drawGroup(modelMat * getRelativeModelMat(), batch);
 			}
 
 			void onIncrease(gfx::engine::GLContent * content)
@@ -1459,7 +2069,7 @@ namespace gfx
 					m_value += m_inc;
 					setValue(m_value);
 					validate();
-					callTrigger(&GFXSpinner::onIncrease);
+					callTrigger(GFX_SPINNER_INCREASE);
 				}
 			}
 			void onDecrease(gfx::engine::GLContent * content)
@@ -1469,7 +2079,7 @@ namespace gfx
 					m_value -= m_inc;
 					setValue(m_value);
 					validate();
-					callTrigger(&GFXSpinner::onDecrease);
+					callTrigger(GFX_SPINNER_DECREASE);
 				}
 			}
 			void onReset(gfx::engine::GLContent * content)
@@ -1478,7 +2088,7 @@ namespace gfx
 				{
 					setValue(0);
 					validate();
-					callTrigger(&GFXSpinner::onReset);
+					callTrigger(GFX_SPINNER_RESET);
 				}
 			}
 			
@@ -1518,17 +2128,25 @@ namespace gfx
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("textEdit"));
-				m_font = GFXFont(GFX_Courier_FONT);
+				setId(manager->addId("textEdit", this));
+				m_font = GFXFont(GFX_Courier_FONT, m_fontSize);
+				track();
 				return this;
 			}
 			void validate()
 			{
-
+				track();
 			}
 			void update(gfx::engine::GLContent * content)
 			{
-
+				// only a blink that shows or hides the cursor needs a redraw
+				++m_cursorBlinkTimer;
+				bool cursorVisible = canDrawCursor();
+				if (cursorVisible != m_cursorVisible)
+				{
+					m_cursorVisible = cursorVisible;
+					invalidate();
+				}
 			}
 			bool checkEvents(gfx::engine::GLContent * content)
 			{
@@ -1536,144 +2154,150 @@ namespace gfx
 				keyTyped(content);
 				return m_onDown;
 			}
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
 			{
-				++m_cursorBlinkTimer;
-				bool endOfText = true;
-				float ix, iy;
-				int ic;
-				for (ix = 0, iy = 0, ic = 0; ic < m_text.length(); ix += m_fontSize / 2.0f, ic++)
-				{		
-					if (ix + m_fontSize / 2 > m_size.x)
-					{						
-						iy += m_fontSize;
-						ix = 0;
-						if (!m_isMultiline)
-						{
-							endOfText = false;
-							break;
-						}
-					}
-					while (m_text[ic] == '\n')
-					{ 
-						if (m_cursorPosition == ic)
-							if (canDrawCursor())
-								drawCursor(modelMat, handles, ix, iy);
-						iy += m_fontSize;
-						ix = 0;		
-						ic++;
-						if (iy + m_fontSize > m_size.y)
-						{
-							endOfText = false;
-							break;
-						}						
-					}
-					if (iy + m_fontSize > m_size.y)
-					{
-						endOfText = false;
-						break;
-					}		
-					if (ic == m_text.length())
-						break;
-					m_font.draw(m_text[ic], modelMat, glm::vec2(ix, iy) + m_pos, glm::vec2(m_fontSize), handles);				
-					if (m_cursorPosition == ic)
-						if (canDrawCursor())
-							drawCursor(modelMat, handles, ix, iy);
+				// long lines and a wrapped last line would spill out of a bounded edit
+				bool clipped = m_size.x > 0.0f && m_size.y > 0.0f;
+				if (clipped)
+					batch->pushScissor(modelMat * getRelativeModelMat(), glm::vec2(), m_size);
+				getLayout()->draw(modelMat * glm::translate(glm::mat4(1.), glm::vec3(m_pos, 0)), m_font.getColor(), batch);
+				if (m_cursorVisible)
+				{
+					glm::vec2 cursor = getCursorPosOffset(m_cursorPosition);
+					drawCursor(modelMat, batch, cursor.x, cursor.y);
+				}
+				if (clipped)
+					batch->popScissor();
+			}
+
+			// Gets the text layout, rebuilding it if the text, size, font or scroll changed since it was last built.
+			// Only the lines that fit in the bounds are laid out, starting at the first visible line.
+			GFXTextLayout * getLayout()
+			{
+				if (m_layout.isValid(m_font.getFace(), m_size, m_isMultiline))
+					return &m_layout;
+
+				if (m_followCursor)
+					scrollToCursor();
+				buildVisibleLayout();
+				// wrapped lines can still push the cursor past the bottom, scroll on until it shows
+				int cursorLine = m_buffer.getLine(m_cursorPosition);
+				while (m_followCursor && m_cursorPosition - m_layoutStart > m_layout.getVisibleLength() && m_firstLine < cursorLine)
+				{
+					m_firstLine++;
+					buildVisibleLayout();
 				}
-				if(canDrawCursor())
-					if (!endOfText)
-						drawCursor(modelMat, handles, m_size.x, iy - m_fontSize);
-					else if(m_cursorPosition == m_text.size() || m_text.size() == 0)
-						drawCursor(modelMat, handles, ix, iy);
+				m_followCursor = false;
+				return &m_layout;
+			}
+
+			// Number of lines that fit in the bounds, or all of them if the height is unbounded
+			int getVisibleLineCount()
+			{
+				GFXFontFace_T * face = m_font.getFace();
+				if (face == NULL || m_size.y <= 0.0f)
+					return m_buffer.getLineCount();
+				return max(1, (int)(m_size.y / face->metrics.lineHeight));
+			}
+
+			// Scrolls so a line is the first one shown, until the cursor next moves
+			void setFirstLine(int line)
+			{
+				line = glm::clamp(line, 0, m_buffer.getLineCount() - 1);
+				m_followCursor = false;
+				if (line == m_firstLine)
+					return;
+				m_firstLine = line;
+				m_layout.invalidate();
+				invalidate();
+			}
+			int getFirstLine()
+			{
+				return m_firstLine;
 			}
 
 			bool canDrawCursor()
 			{
 				return (m_cursorBlinkTimer % m_cursorBlinkTime) < m_cursorBlinkTime / 2 && m_manager->isFocused(this);
 			}
-			void drawCursor(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles, float ix, float iy)
+			void drawCursor(glm::mat4 modelMat, GFXBatch * batch, float ix, float iy)
 			{
-				m_font.draw('|', modelMat, glm::vec2(ix - m_fontSize / 3, iy - m_fontSize / 3) + m_pos, glm::vec2(m_fontSize, m_fontSize * 1.5), handles);
+				m_font.draw('|', modelMat, glm::vec2(ix - m_fontSize / 3, iy - m_fontSize / 3) + m_pos, glm::vec2(m_fontSize, m_fontSize * 1.5), batch);
 			}
 			
 			glm::vec2 getCursorPosOffset(int pos)
 			{
-				float ix, iy;
-				int ic;
-				for (ix = 0, iy = 0, ic = 0; ic < m_text.length() && ic < pos; ix += m_fontSize / 2.0f, ic++)
-				{
-					if (ix + m_fontSize / 2 > m_size.x)
-					{
-						iy += m_fontSize;
-						ix = 0;
-						if (!m_isMultiline)
-							break;
-					}
-					while (m_text[ic] == '\n')
-					{
-						iy += m_fontSize;
-						ix = 0;
-						ic++;
-						if (iy + m_fontSize > m_size.y)
-							break;
-					}
-					if (iy + m_fontSize > m_size.y || ic == m_text.length())
-						break;
-				}
-				return glm::vec2(ix, iy);
+				GFXTextLayout * layout = getLayout();
+				return layout->getCursorOffset(pos - m_layoutStart);
 			}
 			int getEOLPos(int start)
 			{
-				float ix;
-				int ic = start;
-				if (m_text[ic] == '\n')
-					ic++;
-				for (ix = getCursorPosOffset(start).x, ic = start; ic < m_text.length(); ix += m_fontSize / 2.0f, ic++)
-				{
-					if (ix + m_fontSize / 2 > m_size.x)
-						break;
-					while (m_text[ic] == '\n')
-						break;
-				}
-				return ic;
+				GFXTextLayout * layout = getLayout();
+				int line = layout->getLine(start - m_layoutStart);
+				if (line + 1 >= layout->getLineCount())
+					return m_buffer.getLineEnd(m_buffer.getLine(start));
+				int next = m_layoutStart + layout->getLineStart(line + 1);
+				// stop before the newline rather than after it
+				return next > 0 && m_buffer.at(next - 1) == '\n' ? next - 1 : next;
 			}
 			int getSOLPos(int start)
 			{
-				float ix;
-				int ic;
-				for (ix = getCursorPosOffset(start).x, ic = start; ic >= 0; ix -= m_fontSize / 2.0f, ic--)
-				{
-					if (ix <= 0)
-						break;
-					while (m_text[ic] == '\n')
-						break;
-				}
-				return ic;
+				GFXTextLayout * layout = getLayout();
+				return m_layoutStart + layout->getLineStart(layout->getLine(start - m_layoutStart));
 			}
 
 			void setText(std::string text)
 			{
-				m_text = text;
+				m_buffer.clear();
+				m_buffer.insert(0, text);
+				if (m_cursorPosition > m_buffer.size())
+					m_cursorPosition = m_buffer.size();
+				m_followCursor = true;
+				m_layout.invalidate();
+				invalidate();
 			}
 			std::string getText()
 			{
-				return m_text;
+				return m_buffer.getText();
+			}
+
+			// Adds text to the end, what a log or console panel does most
+			void appendText(const std::string & text)
+			{
+				bool follow = m_cursorPosition == m_buffer.size();
+				m_buffer.insert(m_buffer.size(), text);
+				if (follow)
+				{
+					m_cursorPosition = m_buffer.size();
+					m_followCursor = true;
+				}
+				m_layout.invalidate();
+				invalidate();
+			}
+			int getLength()
+			{
+				return m_buffer.size();
 			}
 
 			void setColor(glm::vec4 color)
 			{
 				m_font.setColor(color);
+				invalidate();
 			}
 
 			void insertChar(char c)
 			{
-				m_text.insert(m_cursorPosition,1,c);
+				m_buffer.insert(m_cursorPosition, c);
+				m_followCursor = true;
+				m_layout.invalidate();
+				invalidate();
 				m_cursorPosition++;
 				m_cursorBlinkTimer = 0;
 			}
 
 			void keyTyped(gfx::engine::GLContent * content)
 			{
+				int oldCursorPosition = m_cursorPosition;
 				char key = content->getKeyboardEvents()->getTyped();
 				if (key != -1 && m_manager->isFocused(this))
 				{
@@ -1685,9 +2309,11 @@ namespace gfx
 				}
 				if (isKeyTyped(content, VK_BACK) && m_manager->isFocused(this))
 				{
-					if (m_text.size() > 0)
+					if (m_cursorPosition > 0)
 					{
-						m_text.erase(m_text.begin() + m_cursorPosition - 1);
+						m_buffer.erase(m_cursorPosition - 1, 1);
+						m_layout.invalidate();
+						invalidate();
 						m_cursorPosition--;
 						m_cursorBlinkTimer = 0;
 					}
@@ -1699,7 +2325,7 @@ namespace gfx
 				}
 				if (isKeyTyped(content, VK_RIGHT) && m_manager->isFocused(this))
 				{
-					if (m_cursorPosition < m_text.size())
+					if (m_cursorPosition < m_buffer.size())
 					{
 						m_cursorPosition++;
 						m_cursorBlinkTimer = 0;
@@ -1715,44 +2341,104 @@ namespace gfx
 				}
 				if (isKeyTyped(content, VK_HOME) && m_manager->isFocused(this))
 				{
-					//m_cursorPosition = getSOLPos(m_cursorPosition);
+					m_cursorPosition = getSOLPos(m_cursorPosition);
+					m_cursorBlinkTimer = 0;
 				}
 				if (isKeyTyped(content, VK_END) && m_manager->isFocused(this))
 				{
-					//m_cursorPosition = getEOLPos(m_cursorPosition);
+					m_cursorPosition = getEOLPos(m_cursorPosition);
+					m_cursorBlinkTimer = 0;
 				}
 
 				if (isKeyTyped(content, VK_DOWN) && m_manager->isFocused(this))
 				{
 					CINFO(alib::StringFormat("%0").arg(m_cursorPosition).str());
 				}
+
+				// the cursor may have left the visible lines
+				if (m_cursorPosition != oldCursorPosition)
+				{
+					m_followCursor = true;
+					m_layout.invalidate();
+					invalidate();
+				}
 			}
 
 			void setMultiline(bool isMultiline)
 			{
 				m_isMultiline = isMultiline;
+				invalidate();
+			}
+
+			// Changes the font size, the layout is rebuilt on the next draw
+			void setFontSize(int fontSize)
+			{
+				m_fontSize = fontSize;
+				if (m_manager != GFX_NULLPTR)
+				{
+					glm::vec4 color = m_font.getColor();
+					m_font = GFXFont(GFX_Courier_FONT, m_fontSize);
+					m_font.setColor(color);
+				}
+				invalidate();
 			}
 
 			GFXTextEdit(std::string text, int fontSize, glm::vec2 pos, glm::vec2 size)
 			{
 				m_fontSize = fontSize;
-				m_text = alib::StringFormat(text).str();
-				m_cursorPosition = m_text.size();
+				m_buffer.insert(0, alib::StringFormat(text).str());
+				m_cursorPosition = m_buffer.size();
 				m_pos = pos;
 				m_size = size;
 			}
 
 		protected:
+			// Keeps the cursor's line between the first and last visible lines
+			void scrollToCursor()
+			{
+				int cursorLine = m_buffer.getLine(m_cursorPosition);
+				int visibleLines = getVisibleLineCount();
+				if (cursorLine < m_firstLine)
+					m_firstLine = cursorLine;
+				else if (cursorLine >= m_firstLine + visibleLines)
+					m_firstLine = cursorLine - visibleLines + 1;
+				m_firstLine = glm::clamp(m_firstLine, 0, m_buffer.getLineCount() - 1);
+			}
+
+			void buildVisibleLayout()
+			{
+				m_layoutStart = m_buffer.getLineStart(m_firstLine);
+				m_buffer.getRange(m_layoutStart, m_buffer.getLineStart(m_firstLine + getVisibleLineCount()), &m_visibleText);
+				m_layout.build(m_visibleText, m_font.getFace(), m_size, m_isMultiline);
+			}
+
 			int m_fontSize = GFX_GUI_DEFAULT_FONT_SIZE;
 			int m_cursorPosition = 0;
 			bool m_isMultiline = false;
 			int m_cursorBlinkTimer = 0;
 			int m_cursorBlinkTime = 50;
+			bool m_cursorVisible = false;
 			GFXFont m_font;
-			std::string m_text;
+			GFXTextLayout m_layout;
+			GFXTextBuffer m_buffer;
+
+			// first line shown, the character it starts at and the text of the lines laid out from it
+			int m_firstLine = 0;
+			int m_layoutStart = 0;
+			bool m_followCursor = true;
+			std::string m_visibleText;
+		};
+
+		// Triggers a scroll bar can be linked to
+		enum GFXScrollBarTrigger_T
+		{
+			GFX_SCROLLBAR_DOWN,
+			GFX_SCROLLBAR_UP,
+			GFX_SCROLLBAR_BAR_MOVE,
+			GFX_SCROLLBAR_TRIGGER_COUNT
 		};
 
-		class GFXScrollBar : public GFXContainer, public GFXLinker<GFXScrollBar>
+		class GFXScrollBar : public GFXContainer, public GFXLinker<GFXScrollBar, GFXScrollBarTrigger_T, GFX_SCROLLBAR_TRIGGER_COUNT>
 		{
 		public:
 			void update(gfx::engine::GLContent * content)
@@ -1777,39 +2463,39 @@ namespace gfx
 				onBarMove(content);
 				return checkGroupEvents(content);
 			}
-			void draw(glm::mat4 modelMat, gfx::engine::MeshHandle_T handles)
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
 			{
-				drawGroup(modelMat * getRelativeModelMat(), handles);
+				drawGroup(modelMat * getRelativeModelMat(), batch);
 			}
 
 			GFXComponent * init(GFXManager * manager, GFXComponent * parent)
 			{
 				setManager(manager);
 				setParent(parent);
-				setId(manager->addId("scrollbar"));
+				setId(manager->addId("scrollbar", this));
 				if (m_colorStyle == GFX_NULL_COLORSTYLE)
 					inheritColorStyle();
 
 				if (m_isVertical)
 				{
-					m_down = new gfx::gui::GFXButton(glm::vec2(0, m_size.y - m_size.x), glm::vec2(m_size.x, m_size.x), "\\/");
+					m_down = manager->create<GFXButton>(glm::vec2(0, m_size.y - m_size.x), glm::vec2(m_size.x, m_size.x), "\\/");
 					addComponent(m_down);
 
-					m_up = new gfx::gui::GFXButton(glm::vec2(), glm::vec2(m_size.x, m_size.x), "/\\");
+					m_up = manager->create<GFXButton>(glm::vec2(), glm::vec2(m_size.x, m_size.x), "/\\");
 					addComponent(m_up);
 
-					m_bar = new gfx::gui::GFXButton(glm::vec2(0, m_size.x), glm::vec2(m_size.x, m_size.x), "=");
+					m_bar = manager->create<GFXButton>(glm::vec2(0, m_size.x), glm::vec2(m_size.x, m_size.x), "=");
 					addComponent(m_bar);
 				}
 				else
 				{
-					m_down = new gfx::gui::GFXButton(glm::vec2(m_size.x - m_size.y, 0), glm::vec2(m_size.y, m_size.y), ">");
+					m_down = manager->create<GFXButton>(glm::vec2(m_size.x - m_size.y, 0), glm::vec2(m_size.y, m_size.y), ">");
 					addComponent(m_down);
 
-					m_up = new gfx::gui::GFXButton(glm::vec2(), glm::vec2(m_size.y, m_size.y), "<");
+					m_up = manager->create<GFXButton>(glm::vec2(), glm::vec2(m_size.y, m_size.y), "<");
 					addComponent(m_up);
 
-					m_bar = new gfx::gui::GFXButton(glm::vec2(m_size.y, 0), glm::vec2(m_size.y, m_size.y), "||");
+					m_bar = manager->create<GFXButton>(glm::vec2(m_size.y, 0), glm::vec2(m_size.y, m_size.y), "||");
 					addComponent(m_bar);
 				}
 
@@ -1820,6 +2506,7 @@ namespace gfx
 
 			void validate()
 			{
+				invalidate();
 				if (m_isVertical)
 				{
 					m_down->setPos(glm::vec2(0, m_size.y - m_size.x));
@@ -1851,6 +2538,7 @@ namespace gfx
 				m_value = amount;
 				m_value = min(m_value, 1);
 				m_value = max(m_value, 0);
+				invalidate();
 				char number[24];
 				sprintf(number, "%.1f", m_value);
 			}
@@ -1867,7 +2555,7 @@ namespace gfx
 					m_value = min(m_value, 1);
 					setValue(m_value);
 					validate();
-					callTrigger(&GFXScrollBar::onDown);
+					callTrigger(GFX_SCROLLBAR_DOWN);
 				}
 			}
 			void onUp(gfx::engine::GLContent * content)
@@ -1878,7 +2566,7 @@ namespace gfx
 					m_value = max(m_value, 0);
 					setValue(m_value);
 					validate();
-					callTrigger(&GFXScrollBar::onUp);
+					callTrigger(GFX_SCROLLBAR_UP);
 				}
 			}
 			void onBarMove(gfx::engine::GLContent * content)
@@ -1886,10 +2574,16 @@ namespace gfx
 				if (m_bar->isDragging(content))
 				{
 					validate();
-					callTrigger(&GFXScrollBar::onBarMove);
+					callTrigger(GFX_SCROLLBAR_BAR_MOVE);
 				}
 			}
 
+			// How far one press of the arrows moves the value
+			void setIncrement(float inc)
+			{
+				m_inc = inc;
+			}
+
 			GFXScrollBar(glm::vec2 pos, glm::vec2 size, float value, float inc, bool isVertical)
 			{
 				m_pos = pos;
@@ -1908,5 +2602,290 @@ namespace gfx
 			GFXButton * m_up;
 			GFXButton * m_bar;
 		};
+
+		// Triggers a list view can be linked to
+		enum GFXListTrigger_T
+		{
+			GFX_LIST_ROW_SELECTED,
+			GFX_LIST_TRIGGER_COUNT
+		};
+
+		// Supplies the text of a cell for a list or table view, rows and columns count from 0
+		typedef std::function<std::string(int row, int column)> GFXCellModel;
+		// Supplies the number of rows in a list or table view
+		typedef std::function<int()> GFXRowCountModel;
+
+		// Scrolling list of rows pulled from a model on demand.
+		// Only the rows that fit in the view exist as components, when the view scrolls the same rows
+		// are handed the text of the new rows, so memory and per-frame cost don't grow with the data.
+		class GFXListView : public GFXContainer, public GFXLinker<GFXListView, GFXListTrigger_T, GFX_LIST_TRIGGER_COUNT>
+		{
+		public:
+			GFXComponent * init(GFXManager * manager, GFXComponent * parent)
+			{
+				setManager(manager);
+				setParent(parent);
+				setId(manager->addId("listView", this));
+				if (m_colorStyle == GFX_NULL_COLORSTYLE)
+					inheritColorStyle();
+
+				m_scrollBar = manager->create<GFXScrollBar>(glm::vec2(m_size.x - GFX_LIST_SCROLLBAR_WIDTH, 0), glm::vec2(GFX_LIST_SCROLLBAR_WIDTH, m_size.y), 0, 1, true);
+				addComponent(m_scrollBar);
+				for (int ic = 0; ic < m_headers.size(); ++ic)
+				{
+					GFXButton * header = manager->create<GFXButton>(glm::vec2(), glm::vec2(1, m_rowHeight), m_headers[ic]);
+					addComponent(header);
+					m_headerCells.push_back(header);
+				}
+
+				initGroup(manager, this);
+				validate();
+				return this;
+			}
+
+			void validate()
+			{
+				invalidate();
+				resizePool();
+
+				float headerHeight = m_headers.empty() ? 0.0f : m_rowHeight;
+				m_scrollBar->setPos(glm::vec2(m_size.x - GFX_LIST_SCROLLBAR_WIDTH, headerHeight));
+				m_scrollBar->setSize(glm::vec2(GFX_LIST_SCROLLBAR_WIDTH, m_size.y - headerHeight));
+				for (int ic = 0; ic < m_headerCells.size(); ++ic)
+				{
+					m_headerCells[ic]->setPos(glm::vec2(getColumnX(ic), 0));
+					m_headerCells[ic]->setSize(glm::vec2(getColumnWidth(ic), m_rowHeight));
+				}
+				for (int ir = 0; ir < m_rows.size(); ++ir)
+					for (int ic = 0; ic < m_rows[ir].cells.size(); ++ic)
+					{
+						m_rows[ir].cells[ic]->setPos(glm::vec2(getColumnX(ic), headerHeight + ir * m_rowHeight));
+						m_rows[ir].cells[ic]->setSize(glm::vec2(getColumnWidth(ic), m_rowHeight));
+					}
+
+				validateGroup();
+				bindRows(true);
+			}
+
+			void update(gfx::engine::GLContent * content)
+			{
+				updateGroup(content);
+				bindRows(false);
+			}
+
+			bool checkEvents(gfx::engine::GLContent * content)
+			{
+				onRowSelected(content);
+				return checkGroupEvents(content);
+			}
+
+			void draw(glm::mat4 modelMat, GFXBatch * batch)
+			{
+				// cell text wider than its column, or a view shorter than its one pooled row, would spill past the edges
+				glm::mat4 mat = modelMat * getRelativeModelMat();
+				batch->pushScissor(mat, glm::vec2(), m_size);
+				drawGroup(mat, batch);
+				batch->popScissor();
+			}
+
+			void onRowSelected(gfx::engine::GLContent * content)
+			{
+				for (GFXListRow_T & row : m_rows)
+					for (GFXButton * cell : row.cells)
+						if (row.index < m_boundCount && cell->isReleasedOver(content))
+						{
+							setSelected(row.index);
+							callTrigger(GFX_LIST_ROW_SELECTED);
+							return;
+						}
+			}
+
+			// Sets where the rows come from, the view reads the model again each time a row scrolls into view
+			void setModel(GFXRowCountModel rowCount, GFXCellModel cellText)
+			{
+				m_rowCountModel = rowCount;
+				m_cellModel = cellText;
+				modelChanged();
+			}
+
+			// Call when rows already shown have changed, a change in row count is picked up by itself
+			void modelChanged()
+			{
+				m_modelChanged = true;
+			}
+
+			int getSelected()
+			{
+				return m_selected;
+			}
+			void setSelected(int index)
+			{
+				m_selected = index;
+				for (GFXListRow_T & row : m_rows)
+					for (GFXButton * cell : row.cells)
+						cell->setToggled(row.index == m_selected);
+			}
+
+			// First row shown
+			int getFirstRow()
+			{
+				return m_firstRow;
+			}
+
+			// Number of rows that fit under the header
+			int getVisibleRowCount()
+			{
+				float headerHeight = m_headers.empty() ? 0.0f : m_rowHeight;
+				return max(1, (int)((m_size.y - headerHeight) / m_rowHeight));
+			}
+
+			GFXListView(glm::vec2 pos, glm::vec2 size, float rowHeight = GFX_LIST_DEFAULT_ROW_HEIGHT)
+			{
+				m_pos = pos;
+				m_size = size;
+				m_rowHeight = rowHeight;
+				m_columnWidths.push_back(1.0f);
+			}
+
+		protected:
+			// The components showing one row of the view
+			struct GFXListRow_T
+			{
+				std::vector<GFXButton*> cells;
+				int index = GFX_NULL_INDEX;
+			};
+
+			// Adds or hides rows so there are exactly enough to fill the view
+			void resizePool()
+			{
+				// rows are made by the manager, so there are none until the view is initialised
+				if (m_manager == GFX_NULLPTR)
+					return;
+				int needed = getVisibleRowCount();
+				while (m_rows.size() < needed && !m_spareRows.empty())
+				{
+					for (GFXButton * cell : m_spareRows.back().cells)
+					{
+						addComponent(cell);
+						cell->track();
+					}
+					m_rows.push_back(m_spareRows.back());
+					m_rows.back().index = GFX_NULL_INDEX;
+					m_spareRows.pop_back();
+				}
+				while (m_rows.size() < needed)
+				{
+					GFXListRow_T row;
+					for (int ic = 0; ic < m_columnWidths.size(); ++ic)
+					{
+						// a space keeps the button's label around for the text bound later
+						GFXButton * cell = m_manager->create<GFXButton>(glm::vec2(), glm::vec2(1, m_rowHeight), " ");
+						addComponent(cell);
+						cell->init(m_manager, this);
+						row.cells.push_back(cell);
+					}
+					m_rows.push_back(row);
+				}
+				while (m_rows.size() > needed)
+				{
+					for (GFXButton * cell : m_rows.back().cells)
+					{
+						removeComponent(cell);
+						m_manager->getSpatialGrid()->remove(cell);
+					}
+					// the manager owns the cells, so rows that no longer fit are kept for when the view grows again
+					m_spareRows.push_back(m_rows.back());
+					m_rows.pop_back();
+				}
+			}
+
+			// Hands each pooled row the model row it now shows, rows that already show the right one are left alone
+			void bindRows(bool force)
+			{
+				int count = m_rowCountModel ? m_rowCountModel() : 0;
+				int maxFirst = max(0, count - (int)m_rows.size());
+				int first = (int)(m_scrollBar->getValue() * maxFirst + 0.5f);
+				if (!force && !m_modelChanged && first == m_firstRow && count == m_boundCount)
+					return;
+				force |= m_modelChanged || count != m_boundCount;
+				m_modelChanged = false;
+				m_firstRow = first;
+				m_boundCount = count;
+				m_scrollBar->setIncrement(maxFirst > 0 ? 1.0f / maxFirst : 1.0f);
+
+				for (int ir = 0; ir < m_rows.size(); ++ir)
+				{
+					GFXListRow_T & row = m_rows[ir];
+					int index = first + ir;
+					if (!force && row.index == index)
+						continue;
+					row.index = index;
+					for (int ic = 0; ic < row.cells.size(); ++ic)
+					{
+						GFXButton * cell = row.cells[ic];
+						if (index < count)
+						{
+							cell->setText(m_cellModel ? m_cellModel(index, ic) : "");
+							cell->setToggled(index == m_selected);
+							cell->validate();
+							cell->visible();
+							cell->enable();
+						}
+						else
+						{
+							cell->invisible();
+							cell->disable();
+						}
+					}
+				}
+				invalidate();
+			}
+
+			float getColumnX(int column)
+			{
+				float x = 0.0f;
+				for (int ic = 0; ic < column; ++ic)
+					x += getColumnWidth(ic);
+				return x;
+			}
+			float getColumnWidth(int column)
+			{
+				float total = 0.0f;
+				for (float width : m_columnWidths)
+					total += width;
+				return m_columnWidths[column] / total * (m_size.x - GFX_LIST_SCROLLBAR_WIDTH);
+			}
+
+			float m_rowHeight;
+			std::vector<float> m_columnWidths;
+			std::vector<std::string> m_headers;
+			std::vector<GFXButton*> m_headerCells;
+
+			GFXRowCountModel m_rowCountModel;
+			GFXCellModel m_cellModel;
+			bool m_modelChanged = true;
+
+			GFXScrollBar * m_scrollBar;
+			std::vector<GFXListRow_T> m_rows;
+			std::vector<GFXListRow_T> m_spareRows;
+			int m_firstRow = 0;
+			int m_boundCount = 0;
+			int m_selected = GFX_NULL_INDEX;
+		};
+
+		// A list view with several columns under a row of headers.
+		// Column widths are relative to each other and share the width left of the scroll bar.
+		class GFXTableView : public GFXListView
+		{
+		public:
+			GFXTableView(glm::vec2 pos, glm::vec2 size, std::vector<std::string> headers, std::vector<float> columnWidths, float rowHeight = GFX_LIST_DEFAULT_ROW_HEIGHT)
+				: GFXListView(pos, size, rowHeight)
+			{
+				m_headers = headers;
+				m_columnWidths = columnWidths;
+				if (m_columnWidths.size() != m_headers.size())
+					m_columnWidths.assign(m_headers.size(), 1.0f);
+			}
+		};
 	}
 }
\ No newline at end of file
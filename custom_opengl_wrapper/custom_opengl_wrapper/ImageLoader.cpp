@@ -115,6 +115,13 @@ alib::ImageData_T ImageLoader::get_data_png(const char * filename)
 	return{ data, w,h,n };
 }
 
+// frees pixels loaded by get_data or get_data_png
+void ImageLoader::free_data(alib::ImageData_T * image)
+{
+	stbi_image_free(image->data);
+	image->data = NULL;
+}
+
 alib::ImageData_T * ImageLoader::createImageData_T(unsigned char * data, int w, int h, int n, alib::ImageData_T * imageData_t)
 {
 	if (imageData_t == nullptr)
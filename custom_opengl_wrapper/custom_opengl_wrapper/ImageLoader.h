@@ -20,6 +20,7 @@ namespace alib
 		static alib::ImageData_T get_data(const char * filename);
 		static alib::ImageData_T * createImageData_T(unsigned char * data, int w, int h, int n, alib::ImageData_T * imageData_t);
 		static alib::ImageData_T get_data_png(const char * filename);
+		static void free_data(alib::ImageData_T * image);
 	};
 }
 
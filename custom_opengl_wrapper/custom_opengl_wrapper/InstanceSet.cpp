@@ -0,0 +1,121 @@
+#include "InstanceSet.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include "GLStateCache.h"
+#include <algorithm>
+
+using gfx::engine::InstanceSet;
+
+namespace
+{
+	const char * CLASSNAME = "InstanceSet";
+}
+
+// constructor
+InstanceSet::InstanceSet() {}
+
+// Adds an instance and returns its index
+int InstanceSet::add(glm::mat4 model, glm::vec4 color)
+{
+	m_instances.push_back({ model, color });
+	mark_dirty(m_instances.size() - 1);
+	return m_instances.size() - 1;
+}
+
+// Sets the model matrix of an instance
+void InstanceSet::set_model_mat(int index, glm::mat4 model)
+{
+	m_instances[index].model = model;
+	mark_dirty(index);
+}
+
+// Sets the colour of an instance
+void InstanceSet::set_color(int index, glm::vec4 color)
+{
+	m_instances[index].color = color;
+	mark_dirty(index);
+}
+
+// Gets the model matrix of an instance
+glm::mat4 InstanceSet::get_model_mat(int index)
+{
+	return m_instances[index].model;
+}
+
+// Removes all instances
+void InstanceSet::clear()
+{
+	m_instances.clear();
+	m_dirty_begin = m_dirty_end = 0;
+}
+
+// Number of instances
+int InstanceSet::size()
+{
+	return m_instances.size();
+}
+
+// Uploads the dirty range, reallocating the buffer if it has grown
+void InstanceSet::update()
+{
+	if (m_buffer == 0)
+		glGenBuffers(1, &m_buffer);
+
+	gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	if (m_instances.size() > m_capacity)
+	{
+		// grow geometrically so adding instances one at a time doesn't reallocate every frame
+		m_capacity = std::max((int)m_instances.size(), m_capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(Instance_T), NULL, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(Instance_T), m_instances.data());
+		CINFO(alib::StringFormat("    instance buffer %0 resized to %1 instances").arg(m_buffer).arg(m_capacity).str());
+	}
+	else if (m_dirty_end > m_dirty_begin)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, m_dirty_begin * sizeof(Instance_T),
+			(m_dirty_end - m_dirty_begin) * sizeof(Instance_T), &m_instances[m_dirty_begin]);
+	}
+
+	m_dirty_begin = m_dirty_end = 0;
+}
+
+// Sets up the instance attributes on a VAO, only done once per VAO
+void InstanceSet::attach(GLuint vao)
+{
+	if (std::find(m_attached_vaos.begin(), m_attached_vaos.end(), vao) != m_attached_vaos.end())
+		return;
+
+	if (m_buffer == 0)
+		glGenBuffers(1, &m_buffer);
+
+	gfx::engine::GLStateCache::bindVertexArray(vao);
+	gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	for (int i = 0; i < 4; ++i)
+	{
+		glVertexAttribPointer((GLuint)(INSTANCE_ATTRIB_MODEL + i), 4, GL_FLOAT, GL_FALSE, sizeof(Instance_T),
+			(const GLvoid*)(offsetof(Instance_T, model) + i * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(INSTANCE_ATTRIB_MODEL + i);
+		glVertexAttribDivisor(INSTANCE_ATTRIB_MODEL + i, 1);
+	}
+	glVertexAttribPointer((GLuint)INSTANCE_ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(Instance_T),
+		(const GLvoid*)offsetof(Instance_T, color));
+	glEnableVertexAttribArray(INSTANCE_ATTRIB_COLOR);
+	glVertexAttribDivisor(INSTANCE_ATTRIB_COLOR, 1);
+	gfx::engine::GLStateCache::bindVertexArray(0);
+
+	m_attached_vaos.push_back(vao);
+}
+
+void InstanceSet::mark_dirty(int index)
+{
+	if (m_dirty_end == m_dirty_begin)
+	{
+		m_dirty_begin = index;
+		m_dirty_end = index + 1;
+	}
+	else
+	{
+		m_dirty_begin = std::min(m_dirty_begin, index);
+		m_dirty_end = std::max(m_dirty_end, index + 1);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include <vector>
+
+// attribute locations of the per-instance data (a mat4 takes four)
+#define INSTANCE_ATTRIB_MODEL 5
+#define INSTANCE_ATTRIB_COLOR 9
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Per-instance data as laid out in the instance buffer
+		struct Instance_T
+		{
+			glm::mat4 model;
+			glm::vec4 color;
+		};
+
+		// Holds the per-instance model matrices and colours for instanced draws of a Mesh.
+		// Only the range touched since the last upload is re-sent to the GPU.
+		class InstanceSet
+		{
+		public:
+			// Adds an instance and returns its index
+			int add(glm::mat4 model, glm::vec4 color = glm::vec4(1, 1, 1, 1));
+
+			// Sets the model matrix of an instance
+			void set_model_mat(int index, glm::mat4 model);
+
+			// Sets the colour of an instance
+			void set_color(int index, glm::vec4 color);
+
+			// Gets the model matrix of an instance
+			glm::mat4 get_model_mat(int index);
+
+			// Removes all instances
+			void clear();
+
+			// Number of instances
+			int size();
+
+			// Uploads the dirty range, reallocating the buffer if it has grown
+			void update();
+
+			// Sets up the instance attributes on a VAO, only done once per VAO
+			void attach(GLuint vao);
+
+
+			// constructor
+
+			InstanceSet();
+
+		private:
+			void mark_dirty(int index);
+
+			// member variables
+
+			std::vector<Instance_T> m_instances;
+
+			std::vector<GLuint> m_attached_vaos;
+
+			GLuint m_buffer = 0;
+
+			int
+				m_capacity = 0,
+				m_dirty_begin = 0,
+				m_dirty_end = 0;
+		};
+	}
+}
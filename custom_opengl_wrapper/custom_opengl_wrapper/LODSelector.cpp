@@ -0,0 +1,59 @@
+#include "LODSelector.h"
+
+using gfx::engine::LODSelector;
+
+// constructor
+LODSelector::LODSelector() {}
+
+// Sets the screen heights (0 to 1) below which each coarser LOD is used, largest first,
+// one fewer than the number of LODs as the finest has no lower limit
+void LODSelector::set_thresholds(std::vector<float> thresholds)
+{
+	m_thresholds = thresholds;
+}
+
+// Sets how far past a threshold a mesh has to go before switching, as a fraction of the threshold
+void LODSelector::set_hysteresis(float hysteresis)
+{
+	m_hysteresis = hysteresis;
+}
+
+// Picks and sets the mesh's LOD for this view and projection, returns the LOD picked
+int LODSelector::select(gfx::engine::Mesh * mesh, glm::mat4 * view, glm::mat4 * projection)
+{
+	int count = mesh->get_lod_count();
+	if (count <= 1)
+		return 0;
+
+	float size = get_screen_size(mesh->get_world_bounds().sphere, view, projection);
+	int lod = mesh->get_lod();
+	int last = glm::min(count - 1, (int)m_thresholds.size());
+
+	// step coarser while the mesh is well below the threshold into the next LOD
+	while (lod < last && size < m_thresholds[lod] * (1.0f - m_hysteresis))
+		lod++;
+	// step finer while the mesh is well above the threshold into the current one
+	while (lod > 0 && size > m_thresholds[lod - 1] * (1.0f + m_hysteresis))
+		lod--;
+
+	mesh->set_lod(lod);
+	return lod;
+}
+
+// Fraction of the screen height a world space sphere covers, for perspective and orthographic projections
+float LODSelector::get_screen_size(gfx::engine::BoundingSphere_T sphere, glm::mat4 * view, glm::mat4 * projection)
+{
+	// [1][1] scales view space y to clip space, a perspective divides it by the depth and an orthographic doesn't
+	float scale = (*projection)[1][1];
+	bool perspective = (*projection)[2][3] != 0.0f;
+	if (perspective)
+	{
+		float depth = -(*view * glm::vec4(sphere.center, 1.0f)).z;
+		// a camera inside the sphere sees it fill the screen
+		if (depth <= sphere.radius)
+			return 1.0f;
+		scale /= depth;
+	}
+	// clip space spans 2 across the screen so the diameter's fraction is the radius times the scale
+	return glm::abs(sphere.radius * scale);
+}
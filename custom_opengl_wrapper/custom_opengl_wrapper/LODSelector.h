@@ -0,0 +1,42 @@
+#pragma once
+
+#include "glm.h"
+#include "mesh.h"
+#include "Bounds.h"
+#include <vector>
+
+// fraction a mesh's size has to pass a threshold by before its LOD changes
+#define LOD_DEFAULT_HYSTERESIS 0.1f
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Picks each mesh's LOD from how much of the screen its bounding sphere covers.
+		// A mesh only steps to a coarser LOD once it is a little smaller than the threshold and back to a
+		// finer one once it is a little bigger, so a mesh sitting at a threshold doesn't pop back and forth.
+		class LODSelector
+		{
+		public:
+			// Sets the screen heights (0 to 1) below which each coarser LOD is used, largest first,
+			// one fewer than the number of LODs as the finest has no lower limit
+			void set_thresholds(std::vector<float> thresholds);
+
+			// Sets how far past a threshold a mesh has to go before switching, as a fraction of the threshold
+			void set_hysteresis(float hysteresis);
+
+			// Picks and sets the mesh's LOD for this view and projection, returns the LOD picked
+			int select(Mesh * mesh, glm::mat4 * view, glm::mat4 * projection);
+
+			// Fraction of the screen height a world space sphere covers, for perspective and orthographic projections
+			static float get_screen_size(BoundingSphere_T sphere, glm::mat4 * view, glm::mat4 * projection);
+
+			LODSelector();
+
+		private:
+			// defaults suit a chain built from 100/50/25/10% of the triangles
+			std::vector<float> m_thresholds = { 0.3f, 0.15f, 0.06f };
+			float m_hysteresis = LOD_DEFAULT_HYSTERESIS;
+		};
+	}
+}
@@ -1,6 +1,7 @@
 #include "Mesh.h"
 #include "CLog.h"
 #include "StringFormat.h"
+#include "GLStateCache.h"
 
 using gfx::engine::Mesh;
 
@@ -13,30 +14,97 @@ namespace
 void Mesh::init(std::vector<gfx::Vertex_T> * d)
 {
 	m_data_size = d->size();
+	m_bounds = gfx::engine::Bounds::compute(d);
+	std::vector<unsigned char> packed = m_layout.pack(d);
 	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+	gfx::engine::GLStateCache::bindVertexArray(m_vao);
 	glGenBuffers(1, &m_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-	glBufferData(GL_ARRAY_BUFFER, m_data_size * sizeof(struct gfx::Vertex_T), d->data(), GL_STATIC_DRAW);
-	glVertexAttribPointer((GLuint)0, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-		(const GLvoid*)offsetof(struct gfx::Vertex_T, position));
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer((GLuint)1, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-		(const GLvoid*)offsetof(struct gfx::Vertex_T, color));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer((GLuint)2, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-		(const GLvoid*)offsetof(struct gfx::Vertex_T, normal));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer((GLuint)3, 2, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-		(const GLvoid*)offsetof(struct gfx::Vertex_T, uv));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer((GLuint)4, 3, GL_FLOAT, GL_FALSE, sizeof(struct gfx::Vertex_T),
-		(const GLvoid*)offsetof(struct gfx::Vertex_T, tangent));
-	glEnableVertexAttribArray(4);
-	glBindVertexArray(0);
+	gfx::engine::GLStateCache::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+	m_layout.apply();
+	gfx::engine::GLStateCache::bindVertexArray(0);
 	glFlush();
 
-	CINFO(alib::StringFormat("    buffered into VAO %0").arg(m_vao).str());
+	CINFO(alib::StringFormat("    buffered into VAO %0 (%1 bytes per vertex)").arg(m_vao).arg(m_layout.get_stride()).str());
+}
+
+// Buffers Vertex data into the VBO packed with the given layout
+void Mesh::init(std::vector<gfx::Vertex_T> * d, gfx::engine::VertexLayout layout)
+{
+	m_layout = layout;
+	init(d);
+}
+
+// Buffers Vertex data into the VBO packed with the given layout and indices into the IBO
+void Mesh::init(std::vector<gfx::Vertex_T> * d, std::vector<GLuint> * indices, gfx::engine::VertexLayout layout)
+{
+	m_layout = layout;
+	init(d, indices);
+}
+
+// Buffers Vertex data into the VBO and indices into the IBO
+void Mesh::init(std::vector<gfx::Vertex_T> * d, std::vector<GLuint> * indices)
+{
+	std::vector<std::vector<GLuint>> lods(1, *indices);
+	init(d, &lods);
+}
+
+// Buffers Vertex data into the VBO and each LOD's indices one after another into the IBO, finest first
+void Mesh::init(std::vector<gfx::Vertex_T> * d, std::vector<std::vector<GLuint>> * lods)
+{
+	init(d);
+
+	// the LODs all index the same vertices so they share the VBO and only need their own range of the IBO
+	std::vector<GLuint> indices;
+	m_lods.clear();
+	for (std::vector<GLuint> & lod : *lods)
+	{
+		m_lods.push_back({ (int)indices.size(), (int)lod.size() });
+		indices.insert(indices.end(), lod.begin(), lod.end());
+	}
+	m_lod = 0;
+
+	m_index_count = m_lods.empty() ? 0 : m_lods[0].count;
+	gfx::engine::GLStateCache::bindVertexArray(m_vao);
+	glGenBuffers(1, &m_ibo);
+	// the element buffer binding is stored in the VAO
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+	if (m_data_size <= 0xFFFF)
+	{
+		// every index fits in 16 bits so halve the index memory
+		std::vector<GLushort> short_indices(indices.begin(), indices.end());
+		m_index_type = GL_UNSIGNED_SHORT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), short_indices.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		m_index_type = GL_UNSIGNED_INT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	}
+	gfx::engine::GLStateCache::bindVertexArray(0);
+
+	CINFO(alib::StringFormat("    buffered %0 %1-bit indices in %2 LODs into IBO %3")
+		.arg(indices.size()).arg(m_index_type == GL_UNSIGNED_SHORT ? 16 : 32).arg(m_lods.size()).arg(m_ibo).str());
+}
+
+// Sets which LOD is drawn, clamped to the LODs there are
+void Mesh::set_lod(int lod)
+{
+	m_lod = glm::clamp(lod, 0, glm::max(0, (int)m_lods.size() - 1));
+	if (!m_lods.empty())
+		m_index_count = m_lods[m_lod].count;
+}
+
+// Gets which LOD is drawn
+int Mesh::get_lod()
+{
+	return m_lod;
+}
+
+// Gets the number of LODs, 1 for a mesh without any
+int Mesh::get_lod_count()
+{
+	return glm::max(1, (int)m_lods.size());
 }
 
 // Loads image file into a texture
@@ -45,6 +113,8 @@ void Mesh::load_textures(const char *texfilename)
 	if (texfilename != "")
 	{
 		m_tex = alib::ImageLoader::loadTextureFromImage(texfilename);
+		// the loader binds the new texture directly
+		gfx::engine::GLStateCache::invalidateTextures();
 		CINFO(alib::StringFormat("    %0 -> Texture ID %1").arg(texfilename).arg(m_tex).str());
 	}
 	else
@@ -57,33 +127,65 @@ void Mesh::load_textures(const char *texfilename)
 void Mesh::draw(int wire_frame, gfx::engine::MeshHandle_T handles)
 {
 	handles.modelMatHandle->load(get_model_mat());
+	load_dequantise(handles);
 	draw_array(wire_frame, handles.textureHandle);
 }
 
 // Draws just the VBO and activating the texture
 void Mesh::draw_array(int wire_frame, gfx::engine::VarHandle *texture_handle)
 {
-	// load the textures
-	if (m_tex != GL_TEXTURE0)
-	{
-		load_texture_handle(texture_handle);
-		glActiveTexture(GL_TEXTURE0 + m_tex);
-		glBindTexture(GL_TEXTURE_2D, m_tex);
-	}
+	activate_texture(texture_handle);
 
-	// draw the data
-	glBindVertexArray(m_vao);
-	glDrawArrays(wire_frame ? GL_LINE_LOOP : GL_TRIANGLES, 0, m_data_size);
-	glBindVertexArray(0);
+	// draw the data, bindings are left in place for the next draw to reuse
+	gfx::engine::GLStateCache::bindVertexArray(m_vao);
+	draw_call(wire_frame);
+}
 
-	// unload the texture
+// Issues just the draw call, the VAO and texture must already be bound
+void Mesh::draw_call(int wire_frame)
+{
+	if (m_index_count > 0)
+		glDrawElements(wire_frame ? GL_LINE_LOOP : GL_TRIANGLES, m_index_count, m_index_type, get_lod_offset());
+	else
+		glDrawArrays(wire_frame ? GL_LINE_LOOP : GL_TRIANGLES, 0, m_data_size);
+}
+
+// Draws every instance in the set with one call, the model matrix is applied on top of each instance's
+void Mesh::draw_instanced(int wire_frame, gfx::engine::InstanceSet * instances, gfx::engine::MeshHandle_T handles)
+{
+	if (instances->size() == 0)
+		return;
+
+	instances->attach(m_vao);
+	instances->update();
+
+	handles.modelMatHandle->load(get_model_mat());
+	load_dequantise(handles);
+	activate_texture(handles.textureHandle);
+
+	gfx::engine::GLStateCache::bindVertexArray(m_vao);
+	if (m_index_count > 0)
+		glDrawElementsInstanced(wire_frame ? GL_LINE_LOOP : GL_TRIANGLES, m_index_count, m_index_type, get_lod_offset(), instances->size());
+	else
+		glDrawArraysInstanced(wire_frame ? GL_LINE_LOOP : GL_TRIANGLES, 0, m_data_size, instances->size());
+}
+
+// Gets the byte offset of the drawn LOD in the IBO
+const GLvoid * Mesh::get_lod_offset()
+{
+	if (m_lods.empty())
+		return (const GLvoid*)0;
+	return (const GLvoid*)(size_t)(m_lods[m_lod].first * (m_index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)));
+}
+
+// Binds the texture to its unit and loads the texture handle
+void Mesh::activate_texture(gfx::engine::VarHandle * texture_handle)
+{
 	if (m_tex != GL_TEXTURE0)
 	{
-		glActiveTexture(GL_TEXTURE0 + m_tex);
-		glBindTexture(GL_TEXTURE_2D, GL_TEXTURE0);
+		load_texture_handle(texture_handle);
+		gfx::engine::GLStateCache::bindTexture(GL_TEXTURE0 + m_tex, m_tex_target, m_tex);
 	}
-	glActiveTexture(GL_TEXTURE0);
-	glFinish();
 }
 
 // Override the texture handle seperately
@@ -97,6 +199,20 @@ void Mesh::set_tex(GLuint tex)
 {
 	this->m_tex = tex;
 }
+// Sets the texture and what it's bound as, GL_TEXTURE_2D_ARRAY for an array TextureAtlas
+void Mesh::set_tex(GLuint tex, GLenum target)
+{
+	this->m_tex = tex;
+	this->m_tex_target = target;
+}
+
+// Loads the layout's dequantise scale and offset, the shader applies them to the positions before the model matrix
+void Mesh::load_dequantise(gfx::engine::MeshHandle_T handles)
+{
+	// kept out of u_m so the normal matrix the shaders derive from it isn't skewed by the bounds
+	handles.dequantScaleHandle->load(m_layout.get_dequantise_scale());
+	handles.dequantOffsetHandle->load(m_layout.get_dequantise_offset());
+}
 
 // Get the model matrix
 glm::mat4 Mesh::get_model_mat()
@@ -107,6 +223,12 @@ glm::mat4 Mesh::get_model_mat()
 		glm::scale(glm::mat4(1.), m_scale);
 }
 
+// Get the bounds in world space at the current position, rotation and scale
+gfx::engine::Bounds_T Mesh::get_world_bounds()
+{
+	return gfx::engine::Bounds::transform(m_bounds, get_model_mat());
+}
+
 
 Mesh::Mesh() {}
 
@@ -134,4 +256,60 @@ Mesh::Mesh(
 
 	load_textures(texfilename);
 	init(&data);
+}
+
+// Texture filename, Vertex data pack, index list, world position, dynamic axis of rotation, and amount, static axis of rotation, and amount, scale vector. 
+Mesh::Mesh(
+	const char *texfilename,
+	std::vector<gfx::Vertex_T>	data,
+	std::vector<GLuint> indices,
+	glm::vec3 _pos,
+	glm::vec3 _rotation,
+	GLfloat _theta,
+	glm::vec3 _pre_rotation,
+	GLfloat _pre_theta,
+	glm::vec3 _scale
+)
+{
+	CINFO("Loading new indexed Mesh...");
+	CINFO(alib::StringFormat("    Vertex count = %0").arg(data.size()).str());
+	CINFO(alib::StringFormat("    Index count = %0").arg(indices.size()).str());
+
+	m_pos = _pos;
+	m_rotation = _rotation;
+	m_theta = _theta;
+	m_scale = _scale;
+	m_pre_rotation = _pre_rotation;
+	m_pre_theta = _pre_theta;
+
+	load_textures(texfilename);
+	init(&data, &indices);
+}
+
+// Texture filename, Vertex data pack, index list per LOD (see MeshSimplifier::build_lods), world position, dynamic axis of rotation, and amount, static axis of rotation, and amount, scale vector. 
+Mesh::Mesh(
+	const char *texfilename,
+	std::vector<gfx::Vertex_T>	data,
+	std::vector<std::vector<GLuint>> lods,
+	glm::vec3 _pos,
+	glm::vec3 _rotation,
+	GLfloat _theta,
+	glm::vec3 _pre_rotation,
+	GLfloat _pre_theta,
+	glm::vec3 _scale
+)
+{
+	CINFO("Loading new indexed Mesh with LODs...");
+	CINFO(alib::StringFormat("    Vertex count = %0").arg(data.size()).str());
+	CINFO(alib::StringFormat("    LOD count = %0").arg(lods.size()).str());
+
+	m_pos = _pos;
+	m_rotation = _rotation;
+	m_theta = _theta;
+	m_scale = _scale;
+	m_pre_rotation = _pre_rotation;
+	m_pre_theta = _pre_theta;
+
+	load_textures(texfilename);
+	init(&data, &lods);
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "MeshOptimiser.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <algorithm>
+#include <math.h>
+
+using gfx::MeshOptimiser;
+
+namespace
+{
+	const char * CLASSNAME = "MeshOptimiser";
+
+	// size of the LRU cache the Forsyth scores are modelled on
+	const int FORSYTH_CACHE_SIZE = 32;
+	const float FORSYTH_CACHE_DECAY = 1.5f;
+	const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+	const float FORSYTH_VALENCE_SCALE = 2.0f;
+	const float FORSYTH_VALENCE_POWER = 0.5f;
+
+	// score of a vertex from its LRU position and how many triangles still need it
+	float forsyth_score(int cache_pos, int remaining)
+	{
+		if (remaining == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cache_pos >= 0)
+		{
+			if (cache_pos < 3)
+			{
+				// the last triangle's vertices get a fixed score so it isn't repeated
+				score = FORSYTH_LAST_TRI_SCORE;
+			}
+			else
+			{
+				float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = powf(1.0f - (cache_pos - 3) * scaler, FORSYTH_CACHE_DECAY);
+			}
+		}
+
+		// boost vertices with few triangles left so lone triangles get cleared up
+		score += FORSYTH_VALENCE_SCALE * powf((float)remaining, -FORSYTH_VALENCE_POWER);
+		return score;
+	}
+
+	// counts the vertex transforms of an index list through a FIFO cache
+	int simulate_fifo(gfx::IndexData * indices, int vertex_count, int cache_size)
+	{
+		std::vector<int> timestamps(vertex_count, -cache_size - 1);
+		int time = 0, misses = 0;
+		for (int i = 0; i < indices->size(); ++i)
+		{
+			GLuint index = (*indices)[i];
+			if (time - timestamps[index] > cache_size)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	struct Cluster_T
+	{
+		int start, end;
+		float sort_key;
+	};
+}
+
+// runs the cache, overdraw and fetch passes in order and logs ACMR/ATVR before and after
+void MeshOptimiser::optimise(gfx::VertexData * v, gfx::IndexData * indices, int cache_size)
+{
+	int vertex_count = v->size();
+	CINFO(alib::StringFormat("Optimising mesh of %0 vertices, %1 triangles...").arg(vertex_count).arg(indices->size() / 3).str());
+	CINFO(alib::StringFormat("    before: ACMR = %0 ATVR = %1")
+		.arg(calc_acmr(indices, vertex_count, cache_size)).arg(calc_atvr(indices, vertex_count, cache_size)).str());
+
+	optimise_vertex_cache(indices, vertex_count);
+	CINFO(alib::StringFormat("    vertex cache: ACMR = %0 ATVR = %1")
+		.arg(calc_acmr(indices, vertex_count, cache_size)).arg(calc_atvr(indices, vertex_count, cache_size)).str());
+
+	optimise_overdraw(v, indices, cache_size);
+	optimise_vertex_fetch(v, indices);
+	CINFO(alib::StringFormat("    after: ACMR = %0 ATVR = %1")
+		.arg(calc_acmr(indices, vertex_count, cache_size)).arg(calc_atvr(indices, vertex_count, cache_size)).str());
+}
+
+// reorders triangles for the post-transform vertex cache (Forsyth's linear-speed heuristic)
+void MeshOptimiser::optimise_vertex_cache(gfx::IndexData * indices, int vertex_count)
+{
+	int tri_count = indices->size() / 3;
+	if (tri_count == 0)
+		return;
+
+	// vertex -> triangle adjacency
+	std::vector<int> remaining(vertex_count, 0), offsets(vertex_count + 1, 0), cache_pos(vertex_count, -1);
+	std::vector<float> vertex_score(vertex_count);
+	for (int i = 0; i < tri_count * 3; ++i)
+		remaining[(*indices)[i]]++;
+	for (int i = 0; i < vertex_count; ++i)
+		offsets[i + 1] = offsets[i] + remaining[i];
+	std::vector<int> adjacency(offsets[vertex_count]), fill(offsets.begin(), offsets.end() - 1);
+	for (int t = 0; t < tri_count; ++t)
+		for (int k = 0; k < 3; ++k)
+			adjacency[fill[(*indices)[t * 3 + k]]++] = t;
+
+	for (int i = 0; i < vertex_count; ++i)
+		vertex_score[i] = forsyth_score(-1, remaining[i]);
+
+	std::vector<float> tri_score(tri_count);
+	std::vector<bool> emitted(tri_count, false);
+	for (int t = 0; t < tri_count; ++t)
+		tri_score[t] = vertex_score[(*indices)[t * 3]] + vertex_score[(*indices)[t * 3 + 1]] + vertex_score[(*indices)[t * 3 + 2]];
+
+	gfx::IndexData result;
+	result.reserve(indices->size());
+
+	// cache holds a few extra slots for the vertices pushed out by each new triangle
+	std::vector<int> cache, next_cache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	next_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	int best = 0, scan = 0;
+	for (int t = 1; t < tri_count; ++t)
+		if (tri_score[t] > tri_score[best])
+			best = t;
+
+	while (best >= 0)
+	{
+		emitted[best] = true;
+		GLuint * tri = &(*indices)[best * 3];
+		for (int k = 0; k < 3; ++k)
+		{
+			result.push_back(tri[k]);
+			remaining[tri[k]]--;
+
+			// remove the triangle from this vertex's live adjacency
+			int * begin = &adjacency[offsets[tri[k]]];
+			int * end = begin + remaining[tri[k]] + 1;
+			std::swap(*std::find(begin, end, best), *(end - 1));
+		}
+
+		// move the triangle's vertices to the front of the LRU
+		next_cache.clear();
+		for (int k = 0; k < 3; ++k)
+			next_cache.push_back(tri[k]);
+		for (int i = 0; i < cache.size(); ++i)
+			if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+				next_cache.push_back(cache[i]);
+		for (int i = FORSYTH_CACHE_SIZE; i < next_cache.size(); ++i)
+			cache_pos[next_cache[i]] = -1;
+		std::swap(cache, next_cache);
+
+		// rescore the vertices in (and just out of) the cache and their live triangles
+		for (int i = 0; i < cache.size(); ++i)
+		{
+			int vtx = cache[i];
+			if (i < FORSYTH_CACHE_SIZE)
+				cache_pos[vtx] = i;
+			float score = forsyth_score(cache_pos[vtx], remaining[vtx]);
+			float delta = score - vertex_score[vtx];
+			vertex_score[vtx] = score;
+			for (int a = 0; a < remaining[vtx]; ++a)
+				tri_score[adjacency[offsets[vtx] + a]] += delta;
+		}
+		if (cache.size() > FORSYTH_CACHE_SIZE)
+			cache.resize(FORSYTH_CACHE_SIZE);
+
+		// the best triangle is nearly always one touching the cache
+		best = -1;
+		float best_score = -1.0f;
+		for (int i = 0; i < cache.size(); ++i)
+		{
+			int vtx = cache[i];
+			for (int a = 0; a < remaining[vtx]; ++a)
+			{
+				int t = adjacency[offsets[vtx] + a];
+				if (tri_score[t] > best_score)
+				{
+					best_score = tri_score[t];
+					best = t;
+				}
+			}
+		}
+
+		// otherwise fall back to the next unemitted triangle in input order
+		if (best < 0)
+		{
+			while (scan < tri_count && emitted[scan])
+				scan++;
+			best = scan < tri_count ? scan : -1;
+		}
+	}
+
+	*indices = result;
+}
+
+// splits a cache optimised list into clusters and sorts them front-most first to reduce overdraw
+void MeshOptimiser::optimise_overdraw(gfx::VertexData * v, gfx::IndexData * indices, int cache_size, float threshold)
+{
+	int tri_count = indices->size() / 3;
+	if (tri_count == 0)
+		return;
+
+	// split where the FIFO cache misses all three vertices of a triangle (a natural restart in the strip),
+	// but only once the cluster is already close to the mesh's overall ACMR so the cache gains are kept
+	float global_acmr = calc_acmr(indices, v->size(), cache_size);
+	std::vector<int> timestamps(v->size(), -cache_size - 1);
+	std::vector<Cluster_T> clusters;
+	int time = 0, cluster_start = 0, cluster_misses = 0;
+	for (int t = 0; t < tri_count; ++t)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			GLuint index = (*indices)[t * 3 + k];
+			if (time - timestamps[index] > cache_size)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+
+		int cluster_tris = t - cluster_start;
+		if (misses == 3 && cluster_tris > 0 && cluster_misses <= threshold * global_acmr * cluster_tris)
+		{
+			clusters.push_back({ cluster_start * 3, t * 3, 0.0f });
+			cluster_start = t;
+			cluster_misses = 0;
+		}
+		cluster_misses += misses;
+	}
+	clusters.push_back({ cluster_start * 3, tri_count * 3, 0.0f });
+
+	// area weighted mesh centroid
+	glm::vec3 mesh_centroid = glm::vec3(0.0f);
+	float mesh_area = 0.0f;
+	for (int i = 0; i < tri_count * 3; i += 3)
+	{
+		glm::vec3 a = (*v)[(*indices)[i]].position, b = (*v)[(*indices)[i + 1]].position, c = (*v)[(*indices)[i + 2]].position;
+		float area = glm::length(glm::cross(b - a, c - a));
+		mesh_centroid += (a + b + c) * (area / 3.0f);
+		mesh_area += area;
+	}
+	if (mesh_area > 0.0f)
+		mesh_centroid /= mesh_area;
+
+	// clusters facing away from the centre are most likely to occlude the rest, so draw them first
+	for (int i = 0; i < clusters.size(); ++i)
+	{
+		glm::vec3 centroid = glm::vec3(0.0f), normal = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (int j = clusters[i].start; j < clusters[i].end; j += 3)
+		{
+			glm::vec3 a = (*v)[(*indices)[j]].position, b = (*v)[(*indices)[j + 1]].position, c = (*v)[(*indices)[j + 2]].position;
+			glm::vec3 n = glm::cross(b - a, c - a);
+			float tri_area = glm::length(n);
+			centroid += (a + b + c) * (tri_area / 3.0f);
+			normal += n;
+			area += tri_area;
+		}
+		if (area > 0.0f)
+			centroid /= area;
+		float len = glm::length(normal);
+		clusters[i].sort_key = len > 0.0f ? glm::dot(centroid - mesh_centroid, normal / len) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[](const Cluster_T & a, const Cluster_T & b) { return a.sort_key > b.sort_key; });
+
+	gfx::IndexData result;
+	result.reserve(indices->size());
+	for (int i = 0; i < clusters.size(); ++i)
+		result.insert(result.end(), indices->begin() + clusters[i].start, indices->begin() + clusters[i].end);
+
+	CINFO(alib::StringFormat("    overdraw: sorted %0 clusters").arg(clusters.size()).str());
+
+	*indices = result;
+}
+
+// reorders the vertex buffer into first-use order and remaps the indices
+void MeshOptimiser::optimise_vertex_fetch(gfx::VertexData * v, gfx::IndexData * indices)
+{
+	std::vector<GLuint> remap(v->size(), 0xFFFFFFFF);
+	gfx::VertexData result;
+	result.reserve(v->size());
+
+	for (int i = 0; i < indices->size(); ++i)
+	{
+		GLuint & index = (*indices)[i];
+		if (remap[index] == 0xFFFFFFFF)
+		{
+			remap[index] = result.size();
+			result.push_back((*v)[index]);
+		}
+		index = remap[index];
+	}
+
+	// unreferenced vertices are dropped
+	*v = result;
+}
+
+// average cache miss ratio: transformed vertices per triangle for a FIFO cache
+float MeshOptimiser::calc_acmr(gfx::IndexData * indices, int vertex_count, int cache_size)
+{
+	if (indices->size() < 3)
+		return 0.0f;
+	return simulate_fifo(indices, vertex_count, cache_size) / (float)(indices->size() / 3);
+}
+
+// average transform to vertex ratio: transformed vertices per unique vertex for a FIFO cache
+float MeshOptimiser::calc_atvr(gfx::IndexData * indices, int vertex_count, int cache_size)
+{
+	if (vertex_count == 0)
+		return 0.0f;
+	return simulate_fifo(indices, vertex_count, cache_size) / (float)vertex_count;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include "Types.h"
+#include "PrimativeGenerator.h"
+
+#define OPT_DEFAULT_CACHE_SIZE 16
+#define OPT_DEFAULT_OVERDRAW_THRESHOLD 1.05f
+
+namespace gfx
+{
+	// Import-time reordering of indexed triangle lists for the post-transform cache, overdraw and vertex fetch
+	class MeshOptimiser
+	{
+	public:
+		// runs the cache, overdraw and fetch passes in order and logs ACMR/ATVR before and after
+		static void optimise(VertexData * v, IndexData * indices, int cache_size = OPT_DEFAULT_CACHE_SIZE);
+
+		// reorders triangles for the post-transform vertex cache (Forsyth's linear-speed heuristic)
+		static void optimise_vertex_cache(IndexData * indices, int vertex_count);
+
+		// splits a cache optimised list into clusters and sorts them front-most first to reduce overdraw
+		static void optimise_overdraw(VertexData * v, IndexData * indices, int cache_size = OPT_DEFAULT_CACHE_SIZE, float threshold = OPT_DEFAULT_OVERDRAW_THRESHOLD);
+
+		// reorders the vertex buffer into first-use order and remaps the indices
+		static void optimise_vertex_fetch(VertexData * v, IndexData * indices);
+
+		// average cache miss ratio: transformed vertices per triangle for a FIFO cache
+		static float calc_acmr(IndexData * indices, int vertex_count, int cache_size = OPT_DEFAULT_CACHE_SIZE);
+
+		// average transform to vertex ratio: transformed vertices per unique vertex for a FIFO cache
+		static float calc_atvr(IndexData * indices, int vertex_count, int cache_size = OPT_DEFAULT_CACHE_SIZE);
+	};
+}
@@ -0,0 +1,343 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimiser.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <math.h>
+
+using gfx::MeshSimplifier;
+
+namespace
+{
+	const char * CLASSNAME = "MeshSimplifier";
+
+	// symmetric 4x4 quadric stored as its upper triangle, sums squared distances to a set of planes
+	struct Quadric_T
+	{
+		double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+	};
+
+	Quadric_T plane_quadric(glm::dvec4 p, double weight)
+	{
+		return {
+			weight * p.x * p.x, weight * p.x * p.y, weight * p.x * p.z, weight * p.x * p.w,
+			weight * p.y * p.y, weight * p.y * p.z, weight * p.y * p.w,
+			weight * p.z * p.z, weight * p.z * p.w,
+			weight * p.w * p.w };
+	}
+
+	void add_quadric(Quadric_T * q, const Quadric_T & o)
+	{
+		q->a00 += o.a00; q->a01 += o.a01; q->a02 += o.a02; q->a03 += o.a03;
+		q->a11 += o.a11; q->a12 += o.a12; q->a13 += o.a13;
+		q->a22 += o.a22; q->a23 += o.a23;
+		q->a33 += o.a33;
+	}
+
+	double quadric_error(const Quadric_T & q, glm::vec3 p)
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double e =
+			q.a00 * x * x + 2 * q.a01 * x * y + 2 * q.a02 * x * z + 2 * q.a03 * x +
+			q.a11 * y * y + 2 * q.a12 * y * z + 2 * q.a13 * y +
+			q.a22 * z * z + 2 * q.a23 * z +
+			q.a33;
+		return e > 0.0 ? e : 0.0;
+	}
+
+	// A possible collapse of from onto to, stale once either vertex has changed since it was queued
+	struct Collapse_T
+	{
+		double cost;
+		int from, to;
+		int from_version, to_version;
+
+		bool operator>(const Collapse_T & other) const
+		{
+			return cost > other.cost;
+		}
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3 & p) const
+		{
+			const unsigned int * bits = reinterpret_cast<const unsigned int *>(&p);
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	unsigned long long edge_key(int a, int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		return ((unsigned long long)a << 32) | (unsigned int)b;
+	}
+}
+
+// collapses the cheapest edges until at most target_index_count indices are left or the next collapse
+// would move the surface more than max_error, returns the new index list and the error reached in error
+gfx::IndexData MeshSimplifier::simplify(gfx::VertexData * v, gfx::IndexData * indices, int target_index_count, float max_error, float * error)
+{
+	int vertex_count = v->size();
+	int tri_count = indices->size() / 3;
+
+	// weld first, keyed the same way as PrimativeGenerator::weld_object: identical copies of a vertex all index the
+	// first one, so unwelded triangle soup is joined up into a surface the collapses can walk, and v is left untouched
+	// for the other LODs
+	std::vector<GLuint> canonical(vertex_count);
+	{
+		std::unordered_map<gfx::Vertex_T, GLuint, gfx::VertexHash, gfx::VertexEqual> lookup;
+		lookup.reserve(vertex_count);
+		for (int i = 0; i < vertex_count; ++i)
+			canonical[i] = lookup.insert({ gfx::PrimativeGenerator::weld_key((*v)[i]), (GLuint)i }).first->second;
+	}
+	std::vector<GLuint> tris(tri_count * 3);
+	for (int i = 0; i < tri_count * 3; ++i)
+		tris[i] = canonical[(*indices)[i]];
+	std::vector<bool> tri_dead(tri_count, false);
+	int live_tris = tri_count;
+
+	// once welded, vertices still sharing a position differ in their uv, normal or colour, they sit on a seam
+	// and are locked so the two sides can't pull apart
+	std::vector<bool> locked(vertex_count, false);
+	{
+		std::unordered_map<glm::vec3, int, PositionHash> first_at;
+		for (int i = 0; i < vertex_count; ++i)
+		{
+			if (canonical[i] != i)
+				continue;
+			std::pair<std::unordered_map<glm::vec3, int, PositionHash>::iterator, bool> it = first_at.insert({ gfx::PrimativeGenerator::weld_key((*v)[i]).position, i });
+			if (!it.second)
+			{
+				locked[i] = true;
+				locked[it.first->second] = true;
+			}
+		}
+	}
+
+	// vertex -> triangles, kept up to date as triangles move between vertices
+	std::vector<std::vector<int>> vertex_tris(vertex_count);
+	for (int t = 0; t < tri_count; ++t)
+		for (int k = 0; k < 3; ++k)
+			vertex_tris[tris[t * 3 + k]].push_back(t);
+
+	// edges used by one triangle are on a border
+	std::unordered_map<unsigned long long, int> edge_uses;
+	for (int t = 0; t < tri_count; ++t)
+		for (int k = 0; k < 3; ++k)
+			edge_uses[edge_key(tris[t * 3 + k], tris[t * 3 + (k + 1) % 3])]++;
+	std::vector<bool> border(vertex_count, false);
+
+	// each vertex starts with the planes of its triangles, weighted by area,
+	// border edges add a plane standing up from the edge so the outline is kept
+	std::vector<Quadric_T> quadrics(vertex_count, Quadric_T());
+	for (int t = 0; t < tri_count; ++t)
+	{
+		glm::vec3 p[3] = { (*v)[tris[t * 3]].position, (*v)[tris[t * 3 + 1]].position, (*v)[tris[t * 3 + 2]].position };
+		glm::vec3 cross = glm::cross(p[1] - p[0], p[2] - p[0]);
+		float area = glm::length(cross);
+		if (area <= 0.0f)
+			continue;
+		glm::vec3 normal = cross / area;
+		Quadric_T q = plane_quadric(glm::dvec4(normal, -glm::dot(normal, p[0])), area * 0.5);
+		for (int k = 0; k < 3; ++k)
+			add_quadric(&quadrics[tris[t * 3 + k]], q);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			int a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+			if (edge_uses[edge_key(a, b)] != 1)
+				continue;
+			border[a] = border[b] = true;
+			glm::vec3 edge = p[(k + 1) % 3] - p[k];
+			float length = glm::length(edge);
+			if (length <= 0.0f)
+				continue;
+			glm::vec3 side = glm::normalize(glm::cross(edge, normal));
+			Quadric_T bq = plane_quadric(glm::dvec4(side, -glm::dot(side, p[k])), SIMPLIFY_BORDER_WEIGHT * length * length);
+			add_quadric(&quadrics[a], bq);
+			add_quadric(&quadrics[b], bq);
+		}
+	}
+
+	std::vector<int> version(vertex_count, 0);
+	std::vector<int> remap(vertex_count);
+	for (int i = 0; i < vertex_count; ++i)
+		remap[i] = i;
+
+	std::priority_queue<Collapse_T, std::vector<Collapse_T>, std::greater<Collapse_T>> heap;
+
+	// queues the cheaper direction of an edge that's allowed to collapse at all
+	auto queue_edge = [&](int a, int b)
+	{
+		Quadric_T q = quadrics[a];
+		add_quadric(&q, quadrics[b]);
+		double cost_ab = locked[a] || (border[a] && !border[b]) ? DBL_MAX : quadric_error(q, (*v)[b].position);
+		double cost_ba = locked[b] || (border[b] && !border[a]) ? DBL_MAX : quadric_error(q, (*v)[a].position);
+		if (cost_ab == DBL_MAX && cost_ba == DBL_MAX)
+			return;
+		if (cost_ab <= cost_ba)
+			heap.push({ cost_ab, a, b, version[a], version[b] });
+		else
+			heap.push({ cost_ba, b, a, version[b], version[a] });
+	};
+
+	for (std::pair<const unsigned long long, int> & edge : edge_uses)
+		queue_edge((int)(edge.first >> 32), (int)(edge.first & 0xFFFFFFFF));
+
+	double max_cost = (double)max_error * max_error;
+	double reached = 0.0;
+	std::vector<int> from_neighbours, to_neighbours;
+
+	while (live_tris * 3 > target_index_count && !heap.empty())
+	{
+		Collapse_T c = heap.top();
+		heap.pop();
+		if (c.from_version != version[c.from] || c.to_version != version[c.to] || remap[c.from] != c.from || remap[c.to] != c.to)
+			continue;
+		if (c.cost > max_cost)
+			break;
+
+		int from = c.from, to = c.to;
+		glm::vec3 target = (*v)[to].position;
+
+		// collect the vertices around both ends
+		from_neighbours.clear();
+		to_neighbours.clear();
+		bool shares_edge = false;
+		for (int t : vertex_tris[from])
+			if (!tri_dead[t])
+				for (int k = 0; k < 3; ++k)
+				{
+					int n = tris[t * 3 + k];
+					shares_edge |= n == to;
+					if (n != from)
+						from_neighbours.push_back(n);
+				}
+		if (!shares_edge)
+			continue;
+		for (int t : vertex_tris[to])
+			if (!tri_dead[t])
+				for (int k = 0; k < 3; ++k)
+					if (tris[t * 3 + k] != to)
+						to_neighbours.push_back(tris[t * 3 + k]);
+		std::sort(from_neighbours.begin(), from_neighbours.end());
+		from_neighbours.erase(std::unique(from_neighbours.begin(), from_neighbours.end()), from_neighbours.end());
+		std::sort(to_neighbours.begin(), to_neighbours.end());
+		to_neighbours.erase(std::unique(to_neighbours.begin(), to_neighbours.end()), to_neighbours.end());
+
+		// link condition: an interior edge has two shared neighbours and a border edge one,
+		// any more and the collapse would pinch the surface into a non-manifold fan
+		int shared = 0;
+		for (int n : from_neighbours)
+			shared += std::binary_search(to_neighbours.begin(), to_neighbours.end(), n);
+		bool border_edge = edge_uses.count(edge_key(from, to)) && edge_uses[edge_key(from, to)] == 1;
+		if (shared > (border_edge ? 1 : 2))
+			continue;
+
+		// the triangles that stay must not flip over or collapse to slivers
+		bool flips = false;
+		for (int t : vertex_tris[from])
+		{
+			if (tri_dead[t])
+				continue;
+			GLuint * tri = &tris[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+			glm::vec3 p[3], q[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				p[k] = (*v)[tri[k]].position;
+				q[k] = tri[k] == from ? target : p[k];
+			}
+			glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+			if (glm::dot(before, after) <= 0.0f)
+			{
+				flips = true;
+				break;
+			}
+		}
+		if (flips)
+			continue;
+
+		// collapse: triangles on the edge go, the rest of from's triangles move to to
+		for (int t : vertex_tris[from])
+		{
+			if (tri_dead[t])
+				continue;
+			GLuint * tri = &tris[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+			{
+				tri_dead[t] = true;
+				live_tris--;
+				continue;
+			}
+			for (int k = 0; k < 3; ++k)
+				if (tri[k] == from)
+					tri[k] = to;
+			vertex_tris[to].push_back(t);
+		}
+		vertex_tris[from].clear();
+		remap[from] = to;
+		add_quadric(&quadrics[to], quadrics[from]);
+		version[to]++;
+		reached = glm::max(reached, c.cost);
+
+		// edge use counts around the merged vertex change, recount them and requeue its edges
+		for (int n : from_neighbours)
+			edge_uses.erase(edge_key(from, n));
+		for (int n : to_neighbours)
+			edge_uses.erase(edge_key(to, n));
+		for (int n : from_neighbours)
+			edge_uses.erase(edge_key(to, n));
+		for (int t : vertex_tris[to])
+			if (!tri_dead[t])
+				for (int k = 0; k < 3; ++k)
+				{
+					int a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+					if (a == to || b == to)
+						edge_uses[edge_key(a, b)]++;
+				}
+		for (int t : vertex_tris[to])
+			if (!tri_dead[t])
+				for (int k = 0; k < 3; ++k)
+					if (tris[t * 3 + k] != to)
+						queue_edge(to, tris[t * 3 + k]);
+	}
+
+	gfx::IndexData result;
+	result.reserve(live_tris * 3);
+	for (int t = 0; t < tri_count; ++t)
+		if (!tri_dead[t])
+			result.insert(result.end(), tris.begin() + t * 3, tris.begin() + t * 3 + 3);
+
+	if (error != NULL)
+		*error = (float)sqrt(reached);
+	return result;
+}
+
+// builds one index list per ratio of the original triangle count, each simplified from the one before
+// and cache optimised, ratios should start at 1 and go down (e.g. 1, 0.5, 0.25, 0.1)
+std::vector<gfx::IndexData> MeshSimplifier::build_lods(gfx::VertexData * v, gfx::IndexData * indices, std::vector<float> ratios)
+{
+	CINFO(alib::StringFormat("Building %0 LODs of %1 triangles...").arg(ratios.size()).arg(indices->size() / 3).str());
+
+	std::vector<gfx::IndexData> lods;
+	gfx::IndexData previous = *indices;
+	for (int i = 0; i < ratios.size(); ++i)
+	{
+		int target = ((int)(indices->size() / 3 * ratios[i])) * 3;
+		float error = 0.0f;
+		gfx::IndexData lod = target >= previous.size() ? previous : simplify(v, &previous, target, FLT_MAX, &error);
+		if (i > 0)
+			gfx::MeshOptimiser::optimise_vertex_cache(&lod, v->size());
+		CINFO(alib::StringFormat("    LOD %0: %1 triangles, error %2").arg(i).arg(lod.size() / 3).arg(error).str());
+		lods.push_back(lod);
+		previous = lod;
+	}
+	return lods;
+}
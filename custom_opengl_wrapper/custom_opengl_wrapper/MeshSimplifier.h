@@ -0,0 +1,29 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include "Types.h"
+#include "PrimativeGenerator.h"
+#include <vector>
+#include <float.h>
+
+// how much more a collapse moving a border costs than one moving the surface the same distance
+#define SIMPLIFY_BORDER_WEIGHT 10.0f
+
+namespace gfx
+{
+	// Import-time mesh simplification by quadric error metrics (Garland & Heckbert).
+	// Edges are collapsed onto one of their own vertices rather than a new optimal point, so every LOD
+	// indexes the original vertex buffer and a whole LOD chain can share one VBO.
+	class MeshSimplifier
+	{
+	public:
+		// collapses the cheapest edges until at most target_index_count indices are left or the next collapse
+		// would move the surface more than max_error, returns the new index list and the error reached in error
+		static IndexData simplify(VertexData * v, IndexData * indices, int target_index_count, float max_error = FLT_MAX, float * error = NULL);
+
+		// builds one index list per ratio of the original triangle count, each simplified from the one before
+		// and cache optimised, ratios should start at 1 and go down (e.g. 1, 0.5, 0.25, 0.1)
+		static std::vector<IndexData> build_lods(VertexData * v, IndexData * indices, std::vector<float> ratios);
+	};
+}
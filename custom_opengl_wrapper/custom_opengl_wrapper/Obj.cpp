@@ -980,8 +980,6 @@ void Obj::draw_array(
 		glActiveTexture(GL_TEXTURE0 + height);
 		glBindTexture(GL_TEXTURE_2D, GL_TEXTURE0);
 	}
-
-	glFinish();
 }
 
 
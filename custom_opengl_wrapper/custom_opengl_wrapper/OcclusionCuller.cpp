@@ -0,0 +1,483 @@
+#include "OcclusionCuller.h"
+#include <chrono>
+#include <algorithm>
+
+#if OCCLUSION_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+using gfx::engine::OcclusionCuller;
+
+namespace
+{
+	// w below which a point counts as on or behind the eye
+	const float NEAR_W = 1e-5f;
+
+#if OCCLUSION_CULLER_SSE
+	// smallest and largest of four lanes
+	float horizontal_min(__m128 v)
+	{
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(_mm_min_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+	}
+	float horizontal_max(__m128 v)
+	{
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+	}
+#endif
+
+	float elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+// constructor
+OcclusionCuller::OcclusionCuller() : OcclusionCuller(OCCLUSION_DEFAULT_WIDTH, OCCLUSION_DEFAULT_HEIGHT, glm::clamp((int)std::thread::hardware_concurrency() / 2, 1, 4)) {}
+OcclusionCuller::OcclusionCuller(int width, int height, int threads)
+{
+	m_view_proj = glm::mat4(1.0f);
+	m_next_band = 0;
+	set_resolution(width, height);
+	m_thread_count = glm::max(threads, 1);
+	start_workers();
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+	stop_workers();
+}
+
+// Starts a frame, clears the depth buffer and forgets the last frame's occluders
+void OcclusionCuller::begin(glm::mat4 view_proj)
+{
+	m_view_proj = view_proj;
+	m_occluders.clear();
+	// the bands clear their own rows as they rasterise, this only matters if render isn't called
+	std::fill(m_hiz[0].begin(), m_hiz[0].end(), 1.0f);
+}
+
+// Queues an occluder, positions and indices are read at render so must live until then
+void OcclusionCuller::add_occluder(std::vector<glm::vec3> * positions, std::vector<GLuint> * indices, glm::mat4 model)
+{
+	m_occluders.push_back({ positions, indices, model });
+}
+
+// Rasterises the queued occluders and builds the depth pyramid
+void OcclusionCuller::render()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	setup_triangles();
+
+	// wake the workers then help them, the last one out signals done
+	m_next_band = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_busy = (int)m_workers.size();
+		m_generation++;
+	}
+	m_wake.notify_all();
+	rasterise_bands();
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_busy == 0; });
+	}
+
+	build_hiz();
+
+	m_stats.occluders = (int)m_occluders.size();
+	m_stats.triangles_rasterised = (int)m_triangles.size();
+	m_stats.render_ms = elapsed_ms(start);
+}
+
+// Whether a world space box is wholly behind the occluders, boxes crossing the near plane never are
+bool OcclusionCuller::is_occluded(AABB_T box)
+{
+	// the box's edges are three columns of the matrix scaled, so one corner and three adds give the rest
+	glm::vec3 size = box.max - box.min;
+	glm::vec4
+		origin = m_view_proj * glm::vec4(box.min, 1.0f),
+		dx = m_view_proj[0] * size.x,
+		dy = m_view_proj[1] * size.y,
+		dz = m_view_proj[2] * size.z;
+	glm::vec2 lo, hi;
+	float nearest;
+#if OCCLUSION_CULLER_SSE
+	// the eight corners as two lanes of four, the second four are the first moved along z
+	__m128
+		has_x = _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f),
+		has_y = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f),
+		clip[4][2];
+	for (int c = 0; c < 4; ++c)
+	{
+		clip[c][0] = _mm_add_ps(_mm_set1_ps(origin[c]), _mm_add_ps(_mm_mul_ps(has_x, _mm_set1_ps(dx[c])), _mm_mul_ps(has_y, _mm_set1_ps(dy[c]))));
+		clip[c][1] = _mm_add_ps(clip[c][0], _mm_set1_ps(dz[c]));
+	}
+	if (_mm_movemask_ps(_mm_cmple_ps(_mm_min_ps(clip[3][0], clip[3][1]), _mm_set1_ps(NEAR_W))))
+		return false;
+	__m128 inv_w[2] = { _mm_div_ps(_mm_set1_ps(1.0f), clip[3][0]), _mm_div_ps(_mm_set1_ps(1.0f), clip[3][1]) };
+	__m128 ndc[3][2];
+	for (int c = 0; c < 3; ++c)
+		for (int h = 0; h < 2; ++h)
+			ndc[c][h] = _mm_mul_ps(clip[c][h], inv_w[h]);
+	lo = glm::vec2(horizontal_min(_mm_min_ps(ndc[0][0], ndc[0][1])), horizontal_min(_mm_min_ps(ndc[1][0], ndc[1][1])));
+	hi = glm::vec2(horizontal_max(_mm_max_ps(ndc[0][0], ndc[0][1])), horizontal_max(_mm_max_ps(ndc[1][0], ndc[1][1])));
+	nearest = horizontal_min(_mm_min_ps(ndc[2][0], ndc[2][1])) * 0.5f + 0.5f;
+#else
+	lo = glm::vec2(FLT_MAX);
+	hi = glm::vec2(-FLT_MAX);
+	nearest = FLT_MAX;
+	for (int i = 0; i < 8; ++i)
+	{
+		glm::vec4 clip = origin;
+		if (i & 1)
+			clip += dx;
+		if (i & 2)
+			clip += dy;
+		if (i & 4)
+			clip += dz;
+		if (clip.w <= NEAR_W)
+			return false;
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		lo = glm::min(lo, glm::vec2(ndc));
+		hi = glm::max(hi, glm::vec2(ndc));
+		nearest = glm::min(nearest, ndc.z * 0.5f + 0.5f);
+	}
+#endif
+	if (nearest <= 0.0f)
+		return false;
+
+	// to pixels, leaving anything off screen to the frustum cull
+	lo = (lo * 0.5f + 0.5f) * glm::vec2(m_width, m_height);
+	hi = (hi * 0.5f + 0.5f) * glm::vec2(m_width, m_height);
+	if (hi.x < 0.0f || hi.y < 0.0f || lo.x >= m_width || lo.y >= m_height)
+		return false;
+	int
+		x0 = glm::max((int)lo.x, 0),
+		y0 = glm::max((int)lo.y, 0),
+		x1 = glm::min((int)hi.x, m_width - 1),
+		y1 = glm::min((int)hi.y, m_height - 1);
+
+	// the level at which the box covers at most two texels across, so at most 3x3 are read
+	int level = 0, span = glm::max(x1 - x0, y1 - y0);
+	while (span > 1 && level + 1 < (int)m_hiz.size())
+	{
+		span >>= 1;
+		level++;
+	}
+
+	std::vector<float> & depth = m_hiz[level];
+	int width = m_hiz_sizes[level].x;
+	for (int y = y0 >> level; y <= y1 >> level; ++y)
+		for (int x = x0 >> level; x <= x1 >> level; ++x)
+			if (depth[y * width + x] >= nearest)
+				return false;
+	return true;
+}
+
+// Appends the index of every box that isn't occluded to visible
+void OcclusionCuller::test(std::vector<AABB_T> * boxes, std::vector<int> * visible)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	int occluded = 0;
+	for (int i = 0; i < (int)boxes->size(); ++i)
+	{
+		if (is_occluded((*boxes)[i]))
+			occluded++;
+		else
+			visible->push_back(i);
+	}
+	m_stats.tested = (int)boxes->size();
+	m_stats.occluded = occluded;
+	m_stats.test_ms = elapsed_ms(start);
+}
+
+// Sets the depth buffer size, the width is rounded up to a multiple of four
+void OcclusionCuller::set_resolution(int width, int height)
+{
+	m_width = (glm::max(width, 4) + 3) & ~3;
+	m_height = glm::max(height, 1);
+
+	m_hiz.clear();
+	m_hiz_sizes.clear();
+	glm::ivec2 size = glm::ivec2(m_width, m_height);
+	while (true)
+	{
+		m_hiz.push_back(std::vector<float>(size.x * size.y, 1.0f));
+		m_hiz_sizes.push_back(size);
+		if (size.x == 1 && size.y == 1)
+			break;
+		size = glm::max((size + 1) / 2, glm::ivec2(1));
+	}
+}
+
+// Sets how many threads rasterise, including the calling thread
+void OcclusionCuller::set_thread_count(int threads)
+{
+	stop_workers();
+	m_thread_count = glm::max(threads, 1);
+	start_workers();
+}
+
+// Gets the depth buffer, 0 near to 1 far, rows from the bottom of the screen
+std::vector<float> * OcclusionCuller::get_depth_buffer()
+{
+	return &m_hiz[0];
+}
+int OcclusionCuller::get_width()
+{
+	return m_width;
+}
+int OcclusionCuller::get_height()
+{
+	return m_height;
+}
+
+// Gets the counters from the last render and test
+gfx::engine::OcclusionStats_T OcclusionCuller::get_stats()
+{
+	return m_stats;
+}
+
+// Projects the occluders' triangles, clipping them to the near plane and dropping ones off screen
+void OcclusionCuller::setup_triangles()
+{
+	m_triangles.clear();
+	m_stats.triangles = 0;
+	std::vector<glm::vec4> clip;
+	glm::vec2 scale = glm::vec2(m_width, m_height) * 0.5f;
+
+	for (Occluder_T & occluder : m_occluders)
+	{
+		glm::mat4 mvp = m_view_proj * occluder.model;
+		clip.resize(occluder.positions->size());
+		for (size_t i = 0; i < clip.size(); ++i)
+			clip[i] = mvp * glm::vec4((*occluder.positions)[i], 1.0f);
+
+		std::vector<GLuint> & indices = *occluder.indices;
+		m_stats.triangles += (int)indices.size() / 3;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			glm::vec4 in[3] = { clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]] };
+
+			// clip against the near plane (z = -w), a triangle can become a quad
+			glm::vec4 poly[4];
+			int count = 0;
+			for (int j = 0; j < 3; ++j)
+			{
+				glm::vec4 a = in[j], b = in[(j + 1) % 3];
+				float da = a.z + a.w, db = b.z + b.w;
+				if (da >= 0.0f)
+					poly[count++] = a;
+				if ((da >= 0.0f) != (db >= 0.0f))
+					poly[count++] = a + (b - a) * (da / (da - db));
+			}
+			if (count < 3)
+				continue;
+
+			glm::vec3 screen[4];
+			for (int j = 0; j < count; ++j)
+			{
+				float w = glm::max(poly[j].w, NEAR_W);
+				screen[j] = glm::vec3((glm::vec2(poly[j]) / w + 1.0f) * scale, poly[j].z / w * 0.5f + 0.5f);
+			}
+
+			// fan the clipped polygon, dropping triangles entirely off screen
+			for (int j = 1; j + 1 < count; ++j)
+			{
+				Triangle_T t;
+				t.v[0] = screen[0];
+				t.v[1] = screen[j];
+				t.v[2] = screen[j + 1];
+				glm::vec3 lo = glm::min(glm::min(t.v[0], t.v[1]), t.v[2]);
+				glm::vec3 hi = glm::max(glm::max(t.v[0], t.v[1]), t.v[2]);
+				if (hi.x < 0.0f || hi.y < 0.0f || lo.x >= m_width || lo.y >= m_height || lo.z > 1.0f)
+					continue;
+				t.min_y = glm::max((int)glm::floor(lo.y), 0);
+				t.max_y = glm::min((int)glm::ceil(hi.y), m_height);
+				m_triangles.push_back(t);
+			}
+		}
+	}
+}
+
+// Rasterises every triangle overlapping rows [y0, y1)
+void OcclusionCuller::rasterise_band(int y0, int y1)
+{
+	float * depth = m_hiz[0].data();
+	std::fill(depth + y0 * m_width, depth + y1 * m_width, 1.0f);
+
+	for (Triangle_T & t : m_triangles)
+	{
+		if (t.max_y <= y0 || t.min_y >= y1)
+			continue;
+
+		glm::vec3 a = t.v[0], b = t.v[1], c = t.v[2];
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (glm::abs(area) < 1e-6f)
+			continue;
+		// occluders are drawn from both sides, so wind every triangle the same way
+		if (area < 0.0f)
+		{
+			std::swap(b, c);
+			area = -area;
+		}
+
+		// edge functions e(x, y) = A x + B y + C, positive inside, each is the weight of the vertex opposite
+		float
+			A0 = b.y - c.y, B0 = c.x - b.x, C0 = b.x * c.y - b.y * c.x,
+			A1 = c.y - a.y, B1 = a.x - c.x, C1 = c.x * a.y - c.y * a.x,
+			A2 = a.y - b.y, B2 = b.x - a.x, C2 = a.x * b.y - a.y * b.x;
+
+		// depth is linear in screen space, so it is a plane in x and y too
+		float inv_area = 1.0f / area;
+		float
+			ZA = (A1 * (b.z - a.z) + A2 * (c.z - a.z)) * inv_area,
+			ZB = (B1 * (b.z - a.z) + B2 * (c.z - a.z)) * inv_area,
+			ZC = a.z + (C1 * (b.z - a.z) + C2 * (c.z - a.z)) * inv_area;
+
+		int
+			min_x = glm::max((int)glm::floor(glm::min(glm::min(a.x, b.x), c.x)), 0) & ~3,
+			max_x = glm::min((int)glm::ceil(glm::max(glm::max(a.x, b.x), c.x)), m_width),
+			row_start = glm::max(t.min_y, y0),
+			row_end = glm::min(t.max_y, y1);
+
+		// where each edge crosses a row moves by a fixed step per row, so the spans below need no divides
+		float edge_a[3] = { A0, A1, A2 }, edge_b[3] = { B0, B1, B2 }, edge_c[3] = { C0, C1, C2 };
+		float cross_x[3], cross_step[3];
+		for (int e = 0; e < 3; ++e)
+		{
+			float inv_a = edge_a[e] != 0.0f ? 1.0f / edge_a[e] : 0.0f;
+			cross_x[e] = -(edge_b[e] * (row_start + 0.5f) + edge_c[e]) * inv_a - 0.5f;
+			cross_step[e] = -edge_b[e] * inv_a;
+		}
+
+		for (int y = row_start; y < row_end; ++y)
+		{
+			float py = y + 0.5f;
+			float * row = depth + y * m_width;
+
+			// narrow the row to where every edge function is positive, long thin triangles cover little of their box
+			float span_lo = (float)min_x, span_hi = (float)max_x;
+			for (int e = 0; e < 3; ++e)
+			{
+				float cross = cross_x[e] + cross_step[e] * (y - row_start);
+				if (edge_a[e] > 0.0f)
+					span_lo = glm::max(span_lo, cross);
+				else if (edge_a[e] < 0.0f)
+					span_hi = glm::min(span_hi, cross);
+				else if (edge_b[e] * py + edge_c[e] < 0.0f)
+					span_hi = -1.0f;
+			}
+			if (span_hi < span_lo)
+				continue;
+			// both are clamped to the row so truncating is flooring, the mask below keeps the ends exact
+			int
+				row_min_x = (int)span_lo & ~3,
+				row_max_x = glm::min((int)span_hi + 2, max_x);
+#if OCCLUSION_CULLER_SSE
+			__m128 px = _mm_add_ps(_mm_set1_ps(row_min_x + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+			__m128 step = _mm_set1_ps(4.0f);
+			__m128
+				a0 = _mm_set1_ps(A0), a1 = _mm_set1_ps(A1), a2 = _mm_set1_ps(A2), za = _mm_set1_ps(ZA),
+				r0 = _mm_set1_ps(B0 * py + C0), r1 = _mm_set1_ps(B1 * py + C1), r2 = _mm_set1_ps(B2 * py + C2), rz = _mm_set1_ps(ZB * py + ZC),
+				zero = _mm_setzero_ps();
+			for (int x = row_min_x; x < row_max_x; x += 4)
+			{
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), r0);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), r1);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), r2);
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside))
+				{
+					__m128 z = _mm_add_ps(_mm_mul_ps(za, px), rz);
+					__m128 old = _mm_loadu_ps(row + x);
+					__m128 nearer = _mm_min_ps(old, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+				}
+				px = _mm_add_ps(px, step);
+			}
+#else
+			for (int x = row_min_x; x < row_max_x; ++x)
+			{
+				float px = x + 0.5f;
+				if (A0 * px + B0 * py + C0 >= 0.0f && A1 * px + B1 * py + C1 >= 0.0f && A2 * px + B2 * py + C2 >= 0.0f)
+					row[x] = glm::min(row[x], ZA * px + ZB * py + ZC);
+			}
+#endif
+		}
+	}
+}
+
+// Takes bands until there are none left, run by the calling thread and every worker
+void OcclusionCuller::rasterise_bands()
+{
+	int bands = (m_height + OCCLUSION_BAND_HEIGHT - 1) / OCCLUSION_BAND_HEIGHT;
+	for (int band = m_next_band++; band < bands; band = m_next_band++)
+		rasterise_band(band * OCCLUSION_BAND_HEIGHT, glm::min((band + 1) * OCCLUSION_BAND_HEIGHT, m_height));
+}
+
+// Builds each pyramid level from the one below
+void OcclusionCuller::build_hiz()
+{
+	for (size_t level = 1; level < m_hiz.size(); ++level)
+	{
+		std::vector<float> & src = m_hiz[level - 1], & dst = m_hiz[level];
+		glm::ivec2 src_size = m_hiz_sizes[level - 1], dst_size = m_hiz_sizes[level];
+		for (int y = 0; y < dst_size.y; ++y)
+		{
+			// odd sizes repeat the last row or column
+			int sy0 = y * 2, sy1 = glm::min(y * 2 + 1, src_size.y - 1);
+			for (int x = 0; x < dst_size.x; ++x)
+			{
+				int sx0 = x * 2, sx1 = glm::min(x * 2 + 1, src_size.x - 1);
+				dst[y * dst_size.x + x] = glm::max(
+					glm::max(src[sy0 * src_size.x + sx0], src[sy0 * src_size.x + sx1]),
+					glm::max(src[sy1 * src_size.x + sx0], src[sy1 * src_size.x + sx1]));
+			}
+		}
+	}
+}
+
+void OcclusionCuller::start_workers()
+{
+	m_quit = false;
+	// workers start from the current generation so they only wake for renders after this
+	for (int i = 1; i < m_thread_count; ++i)
+		m_workers.push_back(std::thread(&OcclusionCuller::worker_loop, this, m_generation));
+}
+
+void OcclusionCuller::stop_workers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (std::thread & worker : m_workers)
+		worker.join();
+	m_workers.clear();
+}
+
+void OcclusionCuller::worker_loop(int generation)
+{
+	int seen = generation;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			seen = m_generation;
+		}
+		rasterise_bands();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_busy == 0)
+				m_done.notify_one();
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include "Bounds.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <float.h>
+
+// the rasteriser does four pixels at a time where SSE is there, see FrustumCuller.h
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define OCCLUSION_CULLER_SSE 1
+#else
+#define OCCLUSION_CULLER_SSE 0
+#endif
+
+// size of the software depth buffer, small enough to rasterise in well under a millisecond
+#define OCCLUSION_DEFAULT_WIDTH 256
+#define OCCLUSION_DEFAULT_HEIGHT 128
+// rows of the depth buffer handed to a thread at a time
+#define OCCLUSION_BAND_HEIGHT 16
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Work done by the last render and test
+		struct OcclusionStats_T
+		{
+			int
+				occluders,
+				triangles,
+				triangles_rasterised,
+				tested,
+				occluded;
+			float
+				render_ms,
+				test_ms;
+		};
+
+		// Software occlusion culling on the CPU, it needs no GL context so it also runs headless.
+		// A few low poly occluders are rasterised into a small depth buffer, rows split between worker threads
+		// and four pixels at a time with SSE. A max depth pyramid is built on top so a box can then be tested
+		// against a handful of texels: if every texel it covers is nearer than the box's nearest point it's hidden.
+		class OcclusionCuller
+		{
+		public:
+			// Starts a frame, clears the depth buffer and forgets the last frame's occluders
+			void begin(glm::mat4 view_proj);
+
+			// Queues an occluder, positions and indices are read at render so must live until then
+			void add_occluder(std::vector<glm::vec3> * positions, std::vector<GLuint> * indices, glm::mat4 model);
+
+			// Rasterises the queued occluders and builds the depth pyramid
+			void render();
+
+			// Whether a world space box is wholly behind the occluders, boxes crossing the near plane never are
+			bool is_occluded(AABB_T box);
+
+			// Appends the index of every box that isn't occluded to visible
+			void test(std::vector<AABB_T> * boxes, std::vector<int> * visible);
+
+			// Sets the depth buffer size, the width is rounded up to a multiple of four
+			void set_resolution(int width, int height);
+
+			// Sets how many threads rasterise, including the calling thread
+			void set_thread_count(int threads);
+
+			// Gets the depth buffer, 0 near to 1 far, rows from the bottom of the screen
+			std::vector<float> * get_depth_buffer();
+			int get_width();
+			int get_height();
+
+			// Gets the counters from the last render and test
+			OcclusionStats_T get_stats();
+
+			OcclusionCuller();
+			OcclusionCuller(int width, int height, int threads);
+			~OcclusionCuller();
+			OcclusionCuller(const OcclusionCuller &) = delete;
+			OcclusionCuller & operator=(const OcclusionCuller &) = delete;
+
+		private:
+			struct Occluder_T
+			{
+				std::vector<glm::vec3> * positions;
+				std::vector<GLuint> * indices;
+				glm::mat4 model;
+			};
+
+			// a triangle in screen space, x and y in pixels and z the 0 to 1 depth
+			struct Triangle_T
+			{
+				glm::vec3 v[3];
+				int min_y, max_y;
+			};
+
+			// Projects the occluders' triangles, clipping them to the near plane and dropping ones off screen
+			void setup_triangles();
+
+			// Rasterises every triangle overlapping rows [y0, y1)
+			void rasterise_band(int y0, int y1);
+
+			// Takes bands until there are none left, run by the calling thread and every worker
+			void rasterise_bands();
+
+			// Builds each pyramid level from the one below
+			void build_hiz();
+
+			void start_workers();
+			void stop_workers();
+			void worker_loop(int generation);
+
+			int
+				m_width = OCCLUSION_DEFAULT_WIDTH,
+				m_height = OCCLUSION_DEFAULT_HEIGHT;
+
+			glm::mat4 m_view_proj;
+			std::vector<Occluder_T> m_occluders;
+			std::vector<Triangle_T> m_triangles;
+
+			// level 0 is the depth buffer, each level above holds the max of 2x2 texels below it
+			std::vector<std::vector<float>> m_hiz;
+			std::vector<glm::ivec2> m_hiz_sizes;
+
+			// worker pool, woken once per render
+			int m_thread_count = 1;
+			std::vector<std::thread> m_workers;
+			std::mutex m_mutex;
+			std::condition_variable m_wake, m_done;
+			int m_generation = 0;
+			int m_busy = 0;
+			bool m_quit = false;
+			std::atomic<int> m_next_band;
+
+			OcclusionStats_T m_stats = {};
+		};
+	}
+}
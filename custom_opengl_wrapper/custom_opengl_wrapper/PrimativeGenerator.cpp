@@ -1,13 +1,28 @@
 #include "PrimativeGenerator.h"
+#include "MeshOptimiser.h"
+#include "MeshSimplifier.h"
 #include "Types.h"
 #include "StringFormat.h"
 #include "CLog.h"
+#include <unordered_map>
+#include <cstring>
 
 using gfx::PrimativeGenerator;
 
 namespace
 {
 	const char * CLASSNAME = "PrimativeGenerator";
+
+	// hashes the bits of a position so shared corners can be found
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3 & v) const
+		{
+			uint32_t b[3];
+			memcpy(b, &v, sizeof(b));
+			return (size_t)(b[0] * 73856093u ^ b[1] * 19349663u ^ b[2] * 83492791u);
+		}
+	};
 }
 
 // converts cartesian to polar
@@ -284,6 +299,25 @@ namespace
 			n.push_back(nm);
 	}
 	return n;
+}
+// generates normals averaged over every triangle sharing a position (lets shared vertices be welded)
+ std::vector<glm::vec3>			PrimativeGenerator::generate_smooth_normals(std::vector<glm::vec3> v)
+{
+	std::unordered_map<glm::vec3, glm::vec3, PositionHash> sums;
+	for (int i = 0; i + 2 < v.size(); i += 3)
+	{
+		// area weighted face normal
+		glm::vec3 nm = glm::cross(v[i + 1] - v[i], v[i + 2] - v[i]);
+		for (int j = 0; j < 3; ++j)
+			sums[v[i + j]] += nm;
+	}
+	std::vector<glm::vec3> n;
+	for (int i = 0; i < v.size(); ++i)
+	{
+		glm::vec3 s = sums[v[i]];
+		n.push_back(glm::length(s) > 0.0f ? glm::normalize(s) : glm::vec3());
+	}
+	return n;
 }
  std::vector<glm::vec3>			PrimativeGenerator::generate_map_heights_from_uvs(std::vector<glm::vec3> v, std::vector<glm::vec3> n, std::vector<glm::vec2> uv, alib::ImageData_T * image, float k)
 {
@@ -599,6 +633,8 @@ namespace
 
 	if ((flags & GEN_NORMS) == GEN_NORMS)
 		n = generate_normals(nv);
+	if ((flags & GEN_NORMS_SMOOTH) == GEN_NORMS_SMOOTH)
+		n = generate_smooth_normals(nv);
 	if ((flags & GEN_COLOR) == GEN_COLOR)
 		c = generate_colour_buffer(color, nv.size());
 	if ((flags & GEN_COLOR_RAND) == GEN_COLOR_RAND)
@@ -669,6 +705,8 @@ namespace
 
 	if ((flags & GEN_NORMS) == GEN_NORMS)
 		n = generate_normals(nv);
+	if ((flags & GEN_NORMS_SMOOTH) == GEN_NORMS_SMOOTH)
+		n = generate_smooth_normals(nv);
 	if ((flags & GEN_COLOR) == GEN_COLOR)
 		c = generate_colour_buffer(color, nv.size());
 	if ((flags & GEN_COLOR_RAND) == GEN_COLOR_RAND)
@@ -749,4 +787,97 @@ namespace
 		object.push_back(vert);
 	}
 	return object;
-}
\ No newline at end of file
+}
+
+// packs like pack_object then welds the vertices triangles share and optimises them (see MeshOptimiser::optimise),
+// indices gets the triangle list to draw them with
+ gfx::VertexData				PrimativeGenerator::pack_indexed_object(
+	std::vector<glm::vec3> * v,
+	unsigned int flags,
+	glm::vec3 color,
+	gfx::IndexData * indices
+)
+{
+	if (flags == NULL)
+		flags = GEN_DEFAULT;
+
+	// colours are given to the welded vertices afterwards so random colours don't stop corners being shared,
+	// flat normals still give every face its own corners, GEN_NORMS_SMOOTH welds a smooth surface into one
+	unsigned int colour_flags = flags & (GEN_COLOR | GEN_COLOR_RAND | GEN_COLOR_RAND_I);
+	gfx::VertexData object = pack_object(v, (flags & ~colour_flags) | GEN_COLOR, glm::vec3());
+	*indices = weld_object(&object);
+
+	std::vector<glm::vec3> c;
+	if ((colour_flags & GEN_COLOR) == GEN_COLOR)
+		c = generate_colour_buffer(color, object.size());
+	if ((colour_flags & GEN_COLOR_RAND) == GEN_COLOR_RAND)
+		c = random_colour_buffer(color, object.size());
+	if ((colour_flags & GEN_COLOR_RAND_I) == GEN_COLOR_RAND_I)
+		c = random_intesity_colour_buffer(color, object.size());
+	for (int i = 0; i < c.size(); ++i)
+		object[i].color = c[i];
+
+	gfx::MeshOptimiser::optimise(&object, indices);
+	return object;
+}
+
+// packs like pack_indexed_object then simplifies it into one index list per ratio of its triangles (see MeshSimplifier::build_lods),
+// lods gets them finest first, all indexing the returned vertices, ready for the LOD Mesh constructor
+ gfx::VertexData				PrimativeGenerator::pack_lod_object(
+	std::vector<glm::vec3> * v,
+	unsigned int flags,
+	glm::vec3 color,
+	std::vector<gfx::IndexData> * lods,
+	std::vector<float> ratios
+)
+{
+	gfx::IndexData indices;
+	gfx::VertexData object = pack_indexed_object(v, flags, color, &indices);
+	*lods = gfx::MeshSimplifier::build_lods(&object, &indices, ratios);
+	return object;
+}
+
+// collapses bitwise identical vertices, leaving only the unique vertices in v and returning the triangle index list
+ gfx::IndexData				PrimativeGenerator::weld_object(gfx::VertexData * v)
+{
+	gfx::IndexData indices;
+	gfx::VertexData unique;
+	std::unordered_map<gfx::Vertex_T, GLuint, gfx::VertexHash, gfx::VertexEqual> lookup;
+
+	indices.reserve(v->size());
+	lookup.reserve(v->size());
+
+	for (int i = 0; i < v->size(); ++i)
+	{
+		gfx::Vertex_T vert = weld_key((*v)[i]);
+
+		auto it = lookup.find(vert);
+		if (it == lookup.end())
+		{
+			GLuint index = unique.size();
+			lookup.insert({ vert, index });
+			unique.push_back(vert);
+			indices.push_back(index);
+		}
+		else
+		{
+			indices.push_back(it->second);
+		}
+	}
+
+	CINFO(alib::StringFormat("    welded %0 vertices into %1 unique").arg(v->size()).arg(unique.size()).str());
+
+	*v = unique;
+	return indices;
+}
+
+// the vertex with -0.0 flattened to 0.0, so vertices that are equal are also equal to VertexHash and VertexEqual
+ gfx::Vertex_T					PrimativeGenerator::weld_key(gfx::Vertex_T v)
+{
+	// -0.0 and 0.0 are equal but differ bitwise
+	float * f = reinterpret_cast<float *>(&v);
+	for (int j = 0; j < sizeof(gfx::Vertex_T) / sizeof(float); ++j)
+		if (f[j] == 0.0f)
+			f[j] = 0.0f;
+	return v;
+}
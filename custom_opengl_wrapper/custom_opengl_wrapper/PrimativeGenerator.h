@@ -12,6 +12,8 @@
 
 #include "Types.h"
 #include "ImageLoader.h"
+#include <cstring>
+#include <cstdint>
 
 #define GEN_NORMS 0x1
 #define GEN_TANGS 0x2
@@ -25,6 +27,7 @@
 #define GEN_COLOR_RAND_I 0x40
 #define GEN_DEFAULT (GEN_NORMS | GEN_COLOR)
 #define GEN_SQUAREUVS 0x200
+#define GEN_NORMS_SMOOTH 0x400
 
 namespace gfx
 {
@@ -72,6 +75,35 @@ namespace gfx
 	}
 
 	typedef std::vector<Vertex_T> VertexData;
+	typedef std::vector<GLuint> IndexData;
+
+	// Vertex_T is all floats, so a bytewise compare is exact as long as there is no padding
+	static_assert(sizeof(Vertex_T) == 14 * sizeof(float), "Vertex_T must be tightly packed to be welded bytewise");
+
+	// FNV-1a over the raw bytes of a whole vertex record, hash vertices through PrimativeGenerator::weld_key
+	struct VertexHash
+	{
+		size_t operator()(const Vertex_T & v) const
+		{
+			const unsigned char * bytes = reinterpret_cast<const unsigned char *>(&v);
+			uint64_t h = 14695981039346656037ULL;
+			for (size_t i = 0; i < sizeof(Vertex_T); ++i)
+			{
+				h ^= bytes[i];
+				h *= 1099511628211ULL;
+			}
+			return (size_t)h;
+		}
+	};
+
+	// bytewise equality of two vertex records, compare vertices through PrimativeGenerator::weld_key
+	struct VertexEqual
+	{
+		bool operator()(const Vertex_T & a, const Vertex_T & b) const
+		{
+			return memcmp(&a, &b, sizeof(Vertex_T)) == 0;
+		}
+	};
 
 	class PrimativeGenerator
 	{
@@ -101,6 +133,8 @@ namespace gfx
 			static std::vector<glm::vec2>			generate_null_uvs(int n);
 			// generates normals from every triangle
 			static std::vector<glm::vec3>			generate_normals(std::vector<glm::vec3> v);
+			// generates normals averaged over every triangle sharing a position (lets shared vertices be welded)
+			static std::vector<glm::vec3>			generate_smooth_normals(std::vector<glm::vec3> v);
 			static std::vector<glm::vec3>			generate_map_heights_from_uvs(std::vector<glm::vec3> v, std::vector<glm::vec3> n, std::vector<glm::vec2> uv, alib::ImageData_T * image, float k);
 			// generates a second normal (tangent) for every normal (used for normal mapping)
 			static std::vector<glm::vec3>			generate_tangents(std::vector<glm::vec3> v);
@@ -191,5 +225,30 @@ namespace gfx
 				std::vector<glm::vec2> * uv,
 				std::vector<glm::vec3> * t
 			);
+
+			// packs like pack_object then welds the vertices triangles share and optimises them (see MeshOptimiser::optimise),
+			// indices gets the triangle list to draw them with
+			static VertexData				pack_indexed_object(
+				std::vector<glm::vec3> * v,
+				unsigned int flags,
+				glm::vec3 color,
+				IndexData * indices
+			);
+
+			// packs like pack_indexed_object then simplifies it into one index list per ratio of its triangles (see MeshSimplifier::build_lods),
+			// lods gets them finest first, all indexing the returned vertices, ready for the LOD Mesh constructor
+			static VertexData				pack_lod_object(
+				std::vector<glm::vec3> * v,
+				unsigned int flags,
+				glm::vec3 color,
+				std::vector<IndexData> * lods,
+				std::vector<float> ratios = { 1.0f, 0.5f, 0.25f, 0.1f }
+			);
+
+			// collapses bitwise identical vertices, leaving only the unique vertices in v and returning the triangle index list
+			static IndexData				weld_object(VertexData * v);
+
+			// the vertex with -0.0 flattened to 0.0, so vertices that are equal are also equal to VertexHash and VertexEqual
+			static Vertex_T					weld_key(Vertex_T v);
 	};
 }
\ No newline at end of file
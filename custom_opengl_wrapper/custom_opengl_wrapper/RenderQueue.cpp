@@ -0,0 +1,168 @@
+#include "RenderQueue.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include "GLStateCache.h"
+#include <string.h>
+
+using gfx::engine::RenderQueue;
+
+namespace
+{
+	const char * CLASSNAME = "RenderQueue";
+
+	// key layout from the top bit down, earlier fields sort first
+	const int PASS_BITS = 4, PROGRAM_BITS = 12, TEXTURE_BITS = 16, VAO_BITS = 16, DEPTH_BITS = 16;
+	const int DEPTH_SHIFT = 0;
+	const int VAO_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+	const int TEXTURE_SHIFT = VAO_SHIFT + VAO_BITS;
+	const int PROGRAM_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+	const int PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+
+	// the translucent pass puts depth straight under the pass so blending order wins over state changes
+	const int TRANSLUCENT_VAO_SHIFT = 0;
+	const int TRANSLUCENT_TEXTURE_SHIFT = TRANSLUCENT_VAO_SHIFT + VAO_BITS;
+	const int TRANSLUCENT_PROGRAM_SHIFT = TRANSLUCENT_TEXTURE_SHIFT + TEXTURE_BITS;
+	const int TRANSLUCENT_DEPTH_SHIFT = TRANSLUCENT_PROGRAM_SHIFT + PROGRAM_BITS;
+
+	uint64_t field(uint64_t value, int bits, int shift)
+	{
+		return (value & ((1ULL << bits) - 1)) << shift;
+	}
+}
+
+// constructor
+RenderQueue::RenderQueue() {}
+
+// Queues a mesh to be drawn with a program, depth is the distance from the eye
+void RenderQueue::add(gfx::engine::Mesh * mesh, gfx::engine::GLSLProgramID program, int pass, float depth, int wire_frame)
+{
+	float d = depth / m_max_depth;
+	d = d < 0.0f ? 0.0f : (d > 1.0f ? 1.0f : d);
+	uint64_t depth_bits = (uint64_t)(d * ((1 << DEPTH_BITS) - 1));
+
+	uint64_t key;
+	if (pass == RENDER_PASS_TRANSLUCENT)
+	{
+		// translucent geometry has to be blended back to front across every mesh, state only breaks ties
+		depth_bits = ((1 << DEPTH_BITS) - 1) - depth_bits;
+		key =
+			field(pass, PASS_BITS, PASS_SHIFT) |
+			field(depth_bits, DEPTH_BITS, TRANSLUCENT_DEPTH_SHIFT) |
+			field(program, PROGRAM_BITS, TRANSLUCENT_PROGRAM_SHIFT) |
+			field(mesh->m_tex, TEXTURE_BITS, TRANSLUCENT_TEXTURE_SHIFT) |
+			field(mesh->m_vao, VAO_BITS, TRANSLUCENT_VAO_SHIFT);
+	}
+	else
+	{
+		key =
+			field(pass, PASS_BITS, PASS_SHIFT) |
+			field(program, PROGRAM_BITS, PROGRAM_SHIFT) |
+			field(mesh->m_tex, TEXTURE_BITS, TEXTURE_SHIFT) |
+			field(mesh->m_vao, VAO_BITS, VAO_SHIFT) |
+			field(depth_bits, DEPTH_BITS, DEPTH_SHIFT);
+	}
+
+	m_packets.push_back({ key, mesh, program, wire_frame });
+}
+
+// Radix sorts the queued packets by key
+void RenderQueue::sort()
+{
+	int n = m_packets.size();
+	m_sorted.resize(n);
+
+	// LSD radix sort a byte at a time, it is stable so equal keys keep submission order
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		int counts[257];
+		memset(counts, 0, sizeof(counts));
+		for (int i = 0; i < n; ++i)
+			counts[((m_packets[i].key >> shift) & 0xFF) + 1]++;
+
+		// skip bytes that are the same for every packet
+		if (n == 0 || counts[((m_packets[0].key >> shift) & 0xFF) + 1] == n)
+			continue;
+
+		for (int i = 0; i < 256; ++i)
+			counts[i + 1] += counts[i];
+		for (int i = 0; i < n; ++i)
+			m_sorted[counts[(m_packets[i].key >> shift) & 0xFF]++] = m_packets[i];
+		std::swap(m_packets, m_sorted);
+	}
+}
+
+// Draws the sorted packets, only switching program, texture and VAO when they change
+void RenderQueue::submit(gfx::engine::GLSLProgramManager * programs)
+{
+	m_stats = {};
+	m_stats.packets = m_packets.size();
+
+	gfx::engine::MeshHandle_T handles;
+	GLSLProgramID program = 0;
+	GLuint tex = GL_TEXTURE0, vao = 0;
+	bool first = true;
+
+	for (int i = 0; i < m_packets.size(); ++i)
+	{
+		RenderPacket_T & packet = m_packets[i];
+		bool program_changed = first || packet.program != program;
+
+		if (program_changed)
+		{
+			programs->loadProgram(packet.program);
+			handles = programs->getCurrentProgram()->getMeshHandle();
+			program = packet.program;
+			m_stats.program_switches++;
+		}
+		else
+		{
+			m_stats.program_switches_avoided++;
+		}
+
+		// the texture uniform belongs to the program so it is reloaded with it
+		if (program_changed || packet.mesh->m_tex != tex)
+		{
+			packet.mesh->activate_texture(handles.textureHandle);
+			tex = packet.mesh->m_tex;
+			m_stats.texture_switches++;
+		}
+		else
+		{
+			m_stats.texture_switches_avoided++;
+		}
+
+		if (first || packet.mesh->m_vao != vao)
+		{
+			gfx::engine::GLStateCache::bindVertexArray(packet.mesh->m_vao);
+			vao = packet.mesh->m_vao;
+			m_stats.vao_switches++;
+		}
+		else
+		{
+			m_stats.vao_switches_avoided++;
+		}
+
+		handles.modelMatHandle->load(packet.mesh->get_model_mat());
+		packet.mesh->load_dequantise(handles);
+		packet.mesh->draw_call(packet.wire_frame);
+		first = false;
+	}
+}
+
+// Empties the queue for the next frame
+void RenderQueue::clear()
+{
+	m_packets.clear();
+}
+
+// Sets the depth that maps to the end of the key's depth range
+void RenderQueue::set_max_depth(float depth)
+{
+	m_max_depth = depth;
+}
+
+// Gets the counters from the last submit
+gfx::engine::RenderQueueStats_T RenderQueue::get_stats()
+{
+	return m_stats;
+}
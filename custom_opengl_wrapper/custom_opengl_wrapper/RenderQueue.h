@@ -0,0 +1,76 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include "mesh.h"
+#include "GLSLProgramManager.h"
+#include <vector>
+#include <stdint.h>
+
+// passes are drawn in this order, the translucent pass is sorted back to front
+#define RENDER_PASS_OPAQUE 0
+#define RENDER_PASS_TRANSLUCENT 1
+#define RENDER_PASS_OVERLAY 2
+
+namespace gfx
+{
+	namespace engine
+	{
+		// A single draw waiting in the queue
+		struct RenderPacket_T
+		{
+			uint64_t key;
+			Mesh * mesh;
+			GLSLProgramID program;
+			int wire_frame;
+		};
+
+		// State changes made and avoided by the last submit
+		struct RenderQueueStats_T
+		{
+			int
+				packets,
+				program_switches, program_switches_avoided,
+				texture_switches, texture_switches_avoided,
+				vao_switches, vao_switches_avoided;
+		};
+
+		// Collects draws for a frame, sorts them by a 64 bit key (pass | program | texture | VAO | depth, or
+		// pass | depth | program | texture | VAO for the translucent pass) and submits them with the fewest state changes
+		class RenderQueue
+		{
+		public:
+			// Queues a mesh to be drawn with a program, depth is the distance from the eye
+			void add(Mesh * mesh, GLSLProgramID program, int pass = RENDER_PASS_OPAQUE, float depth = 0.0f, int wire_frame = 0);
+
+			// Radix sorts the queued packets by key
+			void sort();
+
+			// Draws the sorted packets, only switching program, texture and VAO when they change
+			void submit(GLSLProgramManager * programs);
+
+			// Empties the queue for the next frame
+			void clear();
+
+			// Sets the depth that maps to the end of the key's depth range
+			void set_max_depth(float depth);
+
+			// Gets the counters from the last submit
+			RenderQueueStats_T get_stats();
+
+
+			// constructor
+
+			RenderQueue();
+
+		private:
+			// member variables
+
+			std::vector<RenderPacket_T> m_packets, m_sorted;
+
+			RenderQueueStats_T m_stats = {};
+
+			float m_max_depth = 1000.0f;
+		};
+	}
+}
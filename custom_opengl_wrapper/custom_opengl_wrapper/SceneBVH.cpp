@@ -0,0 +1,480 @@
+#include "SceneBVH.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <algorithm>
+#include <float.h>
+
+using gfx::engine::SceneBVH;
+
+namespace
+{
+	const char * CLASSNAME = "SceneBVH";
+
+	gfx::engine::AABB_T empty_box()
+	{
+		gfx::engine::AABB_T box;
+		box.min = glm::vec3(FLT_MAX);
+		box.max = glm::vec3(-FLT_MAX);
+		return box;
+	}
+
+	void grow(gfx::engine::AABB_T * box, gfx::engine::AABB_T other)
+	{
+		box->min = glm::min(box->min, other.min);
+		box->max = glm::max(box->max, other.max);
+	}
+
+	float half_area(gfx::engine::AABB_T box)
+	{
+		glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0.0f));
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	bool same_box(gfx::engine::AABB_T a, gfx::engine::AABB_T b)
+	{
+		return a.min == b.min && a.max == b.max;
+	}
+
+	// Distance along the ray to where it enters the box, FLT_MAX if it misses
+	float ray_box(glm::vec3 origin, glm::vec3 inv_dir, gfx::engine::AABB_T box, float max_distance)
+	{
+		glm::vec3 t0 = (box.min - origin) * inv_dir;
+		glm::vec3 t1 = (box.max - origin) * inv_dir;
+		glm::vec3 near_t = glm::min(t0, t1);
+		glm::vec3 far_t = glm::max(t0, t1);
+		float enter = glm::max(glm::max(near_t.x, near_t.y), glm::max(near_t.z, 0.0f));
+		float exit = glm::min(glm::min(far_t.x, far_t.y), glm::min(far_t.z, max_distance));
+		return enter <= exit ? enter : FLT_MAX;
+	}
+
+	float distance_sq(glm::vec3 point, gfx::engine::AABB_T box)
+	{
+		glm::vec3 offset = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+		return glm::dot(offset, offset);
+	}
+}
+
+// constructor
+SceneBVH::SceneBVH() {}
+
+// Adds a mesh, its bounds are taken from get_world_bounds, returns the id queries report
+int SceneBVH::add(gfx::engine::Mesh * mesh)
+{
+	return add(mesh->get_world_bounds().box, mesh);
+}
+
+// Adds a box with an optional mesh, returns the id queries report
+int SceneBVH::add(AABB_T box, gfx::engine::Mesh * mesh)
+{
+	int id;
+	if (!m_free.empty())
+	{
+		id = m_free.back();
+		m_free.pop_back();
+	}
+	else
+	{
+		id = m_objects.size();
+		m_objects.push_back(Object_T());
+	}
+	m_objects[id] = { box, mesh, -1, true, false };
+	m_needs_build = true;
+	return id;
+}
+
+// Removes an object, its id may be given to a later add
+void SceneBVH::remove(int id)
+{
+	if (id < 0 || id >= m_objects.size() || !m_objects[id].live)
+		return;
+	m_objects[id].live = false;
+	m_objects[id].mesh = NULL;
+	m_free.push_back(id);
+	m_needs_build = true;
+}
+
+// Re-reads the bounds of a mesh that has moved
+void SceneBVH::move(int id)
+{
+	if (m_objects[id].mesh != NULL)
+		move(id, m_objects[id].mesh->get_world_bounds().box);
+}
+
+// Sets the box of an object that has moved
+void SceneBVH::move(int id, AABB_T box)
+{
+	Object_T & object = m_objects[id];
+	object.box = box;
+	if (!object.moved)
+	{
+		object.moved = true;
+		m_moved.push_back(id);
+	}
+}
+
+// Rebuilds if objects were added or removed, otherwise refits the nodes above moved objects
+void SceneBVH::update()
+{
+	if (m_needs_build)
+		build();
+	else
+		refit();
+}
+
+// Builds the whole tree from scratch
+void SceneBVH::build()
+{
+	m_refs.clear();
+	m_centroids.resize(m_objects.size());
+	for (int i = 0; i < m_objects.size(); ++i)
+	{
+		m_objects[i].moved = false;
+		m_objects[i].leaf = -1;
+		if (m_objects[i].live)
+		{
+			m_refs.push_back(i);
+			m_centroids[i] = (m_objects[i].box.min + m_objects[i].box.max) * 0.5f;
+		}
+	}
+	m_moved.clear();
+	m_needs_build = false;
+
+	// a binary tree over n objects never needs more than 2n - 1 nodes
+	m_nodes.clear();
+	m_nodes.reserve(glm::max(1, (int)m_refs.size() * 2 - 1));
+	m_nodes.push_back({ empty_box(), 0, 0, -1 });
+
+	m_stats = {};
+	m_stats.objects = m_refs.size();
+	m_stats.depth = m_refs.empty() ? 0 : build_node(0, 0, m_refs.size(), 1);
+	m_stats.nodes = m_nodes.size();
+
+	CINFO(alib::StringFormat("built BVH over %0 objects: %1 nodes, %2 leaves, depth %3")
+		.arg(m_stats.objects).arg(m_stats.nodes).arg(m_stats.leaves).arg(m_stats.depth).str());
+}
+
+// Splits m_refs[start, end) under a node, returns the depth below it
+int SceneBVH::build_node(int node, int start, int end, int depth)
+{
+	AABB_T box = empty_box(), centroid_box = empty_box();
+	for (int i = start; i < end; ++i)
+	{
+		grow(&box, m_objects[m_refs[i]].box);
+		glm::vec3 c = m_centroids[m_refs[i]];
+		grow(&centroid_box, { c, c });
+	}
+	m_nodes[node].box = box;
+
+	int count = end - start;
+	glm::vec3 extent = centroid_box.max - centroid_box.min;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	int split = -1;
+	if (count > 1 && extent[axis] > 0.0f)
+	{
+		// bin the centroids along the widest axis and sweep both ways for the cheapest split
+		AABB_T bin_boxes[BVH_SAH_BINS];
+		int bin_counts[BVH_SAH_BINS] = {};
+		for (int b = 0; b < BVH_SAH_BINS; ++b)
+			bin_boxes[b] = empty_box();
+		float scale = BVH_SAH_BINS / extent[axis] * 0.9999f;
+		for (int i = start; i < end; ++i)
+		{
+			int b = (int)((m_centroids[m_refs[i]][axis] - centroid_box.min[axis]) * scale);
+			bin_counts[b]++;
+			grow(&bin_boxes[b], m_objects[m_refs[i]].box);
+		}
+
+		float right_cost[BVH_SAH_BINS];
+		AABB_T right = empty_box();
+		int right_count = 0;
+		for (int b = BVH_SAH_BINS - 1; b > 0; --b)
+		{
+			grow(&right, bin_boxes[b]);
+			right_count += bin_counts[b];
+			right_cost[b] = right_count * half_area(right);
+		}
+
+		// splitting has to beat testing every object in a leaf, counting the cost of visiting the extra node
+		float best_cost = count <= BVH_MAX_LEAF_SIZE ? count * half_area(box) : FLT_MAX;
+		float node_cost = BVH_TRAVERSAL_COST * half_area(box);
+		int best_bin = -1;
+		AABB_T left = empty_box();
+		int left_count = 0;
+		for (int b = 0; b < BVH_SAH_BINS - 1; ++b)
+		{
+			grow(&left, bin_boxes[b]);
+			left_count += bin_counts[b];
+			if (left_count == 0 || left_count == count)
+				continue;
+			float cost = node_cost + left_count * half_area(left) + right_cost[b + 1];
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_bin = b;
+			}
+		}
+
+		if (best_bin >= 0)
+		{
+			float boundary = centroid_box.min[axis] + (best_bin + 1) / scale;
+			split = std::partition(m_refs.begin() + start, m_refs.begin() + end,
+				[&](int id) { return m_centroids[id][axis] < boundary; }) - m_refs.begin();
+			if (split == start || split == end)
+				split = -1;
+		}
+	}
+
+	// objects sharing a centroid can't be binned apart, split them by count if there are too many for a leaf
+	if (split < 0 && count > BVH_MAX_LEAF_SIZE)
+	{
+		split = start + count / 2;
+		std::nth_element(m_refs.begin() + start, m_refs.begin() + split, m_refs.begin() + end,
+			[&](int a, int b) { return m_centroids[a][axis] < m_centroids[b][axis]; });
+	}
+
+	if (split < 0)
+	{
+		m_nodes[node].first = start;
+		m_nodes[node].count = count;
+		for (int i = start; i < end; ++i)
+			m_objects[m_refs[i]].leaf = node;
+		m_stats.leaves++;
+		return depth;
+	}
+
+	int children = m_nodes.size();
+	m_nodes[node].first = children;
+	m_nodes[node].count = 0;
+	m_nodes.push_back({ empty_box(), 0, 0, node });
+	m_nodes.push_back({ empty_box(), 0, 0, node });
+	int left_depth = build_node(children, start, split, depth + 1);
+	int right_depth = build_node(children + 1, split, end, depth + 1);
+	return glm::max(left_depth, right_depth);
+}
+
+// Sets a leaf's box from its objects
+void SceneBVH::fit_leaf(int node)
+{
+	AABB_T box = empty_box();
+	for (int i = m_nodes[node].first; i < m_nodes[node].first + m_nodes[node].count; ++i)
+		grow(&box, m_objects[m_refs[i]].box);
+	m_nodes[node].box = box;
+}
+
+// Refits the nodes above objects that moved since the last build or refit
+void SceneBVH::refit()
+{
+	m_stats.refit_objects = m_moved.size();
+	m_stats.refit_nodes = 0;
+
+	for (int id : m_moved)
+	{
+		m_objects[id].moved = false;
+		int node = m_objects[id].leaf;
+		if (node < 0)
+			continue;
+
+		AABB_T old_box = m_nodes[node].box;
+		fit_leaf(node);
+		m_stats.refit_nodes++;
+
+		// walk up until a node's box doesn't change, everything above it is already right
+		while (!same_box(old_box, m_nodes[node].box) && m_nodes[node].parent >= 0)
+		{
+			node = m_nodes[node].parent;
+			old_box = m_nodes[node].box;
+			AABB_T box = m_nodes[m_nodes[node].first].box;
+			grow(&box, m_nodes[m_nodes[node].first + 1].box);
+			m_nodes[node].box = box;
+			m_stats.refit_nodes++;
+		}
+	}
+	m_moved.clear();
+}
+
+// Appends the id of every object whose box may be in the frustum
+void SceneBVH::query_frustum(Frustum_T * frustum, std::vector<int> * out)
+{
+	if (m_nodes.empty() || m_refs.empty())
+		return;
+
+	// (node, planes still to test) pairs, a node wholly inside a plane's half space skips it for the whole subtree
+	m_stack.clear();
+	m_stack.push_back(0);
+	m_stack.push_back((1 << FRUSTUM_PLANE_COUNT) - 1);
+	while (!m_stack.empty())
+	{
+		int planes = m_stack.back(); m_stack.pop_back();
+		int node = m_stack.back(); m_stack.pop_back();
+		Node_T & n = m_nodes[node];
+
+		glm::vec3 center = (n.box.min + n.box.max) * 0.5f;
+		glm::vec3 extent = (n.box.max - n.box.min) * 0.5f;
+		bool outside = false;
+		for (int p = 0; p < FRUSTUM_PLANE_COUNT && !outside; ++p)
+		{
+			if (!(planes & (1 << p)))
+				continue;
+			glm::vec3 normal = glm::vec3(frustum->planes[p]);
+			float distance = glm::dot(normal, center) + frustum->planes[p].w;
+			float radius = glm::dot(glm::abs(normal), extent);
+			if (distance + radius < 0.0f)
+				outside = true;
+			else if (distance - radius >= 0.0f)
+				planes &= ~(1 << p);
+		}
+		if (outside)
+			continue;
+
+		if (n.count > 0)
+		{
+			for (int i = n.first; i < n.first + n.count; ++i)
+				if (planes == 0 || Bounds::is_visible(frustum, m_objects[m_refs[i]].box))
+					out->push_back(m_refs[i]);
+		}
+		else
+		{
+			m_stack.push_back(n.first);
+			m_stack.push_back(planes);
+			m_stack.push_back(n.first + 1);
+			m_stack.push_back(planes);
+		}
+	}
+}
+
+// Finds the first object box the ray hits within max_distance, the direction needn't be normalised
+bool SceneBVH::raycast(glm::vec3 origin, glm::vec3 dir, float max_distance, BVHRayHit_T * hit)
+{
+	if (m_nodes.empty() || m_refs.empty())
+		return false;
+
+	float length = glm::length(dir);
+	dir /= length;
+	// a zero component gives an infinite inverse, which the slab test handles
+	glm::vec3 inv_dir = 1.0f / dir;
+
+	float best = max_distance;
+	int best_id = -1;
+
+	m_stack.clear();
+	if (ray_box(origin, inv_dir, m_nodes[0].box, best) != FLT_MAX)
+		m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		int node = m_stack.back(); m_stack.pop_back();
+		Node_T & n = m_nodes[node];
+		if (ray_box(origin, inv_dir, n.box, best) == FLT_MAX)
+			continue;
+
+		if (n.count > 0)
+		{
+			for (int i = n.first; i < n.first + n.count; ++i)
+			{
+				float t = ray_box(origin, inv_dir, m_objects[m_refs[i]].box, best);
+				// the box test already rejects hits past best, so any hit is at least as close
+				if (t != FLT_MAX && (t < best || best_id < 0))
+				{
+					best = t;
+					best_id = m_refs[i];
+				}
+			}
+		}
+		else
+		{
+			// push the further child first so the nearer one is searched first and shortens the ray sooner
+			float t_left = ray_box(origin, inv_dir, m_nodes[n.first].box, best);
+			float t_right = ray_box(origin, inv_dir, m_nodes[n.first + 1].box, best);
+			int near_child = t_left <= t_right ? n.first : n.first + 1;
+			int far_child = t_left <= t_right ? n.first + 1 : n.first;
+			if (glm::max(t_left, t_right) != FLT_MAX)
+				m_stack.push_back(far_child);
+			if (glm::min(t_left, t_right) != FLT_MAX)
+				m_stack.push_back(near_child);
+		}
+	}
+
+	if (best_id < 0)
+		return false;
+	hit->id = best_id;
+	hit->distance = best;
+	hit->point = origin + dir * best;
+	return true;
+}
+
+// Finds the object whose box is closest to the point, -1 when none are within max_distance
+int SceneBVH::nearest(glm::vec3 point, float max_distance, float * distance)
+{
+	if (m_nodes.empty() || m_refs.empty())
+		return -1;
+
+	float best_sq = max_distance * max_distance;
+	int best_id = -1;
+
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		int node = m_stack.back(); m_stack.pop_back();
+		Node_T & n = m_nodes[node];
+		if (distance_sq(point, n.box) > best_sq)
+			continue;
+
+		if (n.count > 0)
+		{
+			for (int i = n.first; i < n.first + n.count; ++i)
+			{
+				float d = distance_sq(point, m_objects[m_refs[i]].box);
+				if (d < best_sq || (d == best_sq && best_id < 0))
+				{
+					best_sq = d;
+					best_id = m_refs[i];
+				}
+			}
+		}
+		else
+		{
+			float d_left = distance_sq(point, m_nodes[n.first].box);
+			float d_right = distance_sq(point, m_nodes[n.first + 1].box);
+			m_stack.push_back(d_left <= d_right ? n.first + 1 : n.first);
+			m_stack.push_back(d_left <= d_right ? n.first : n.first + 1);
+		}
+	}
+
+	if (best_id >= 0 && distance != NULL)
+		*distance = glm::sqrt(best_sq);
+	return best_id;
+}
+
+// Removes every object and node
+void SceneBVH::clear()
+{
+	m_objects.clear();
+	m_free.clear();
+	m_nodes.clear();
+	m_refs.clear();
+	m_moved.clear();
+	m_needs_build = false;
+	m_stats = {};
+}
+
+gfx::engine::Mesh * SceneBVH::get_mesh(int id)
+{
+	return m_objects[id].mesh;
+}
+
+gfx::engine::AABB_T SceneBVH::get_box(int id)
+{
+	return m_objects[id].box;
+}
+
+int SceneBVH::size()
+{
+	return m_objects.size() - m_free.size();
+}
+
+// Gets the counters from the last build and refit
+gfx::engine::SceneBVHStats_T SceneBVH::get_stats()
+{
+	return m_stats;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "glm.h"
+#include "mesh.h"
+#include "Bounds.h"
+#include <vector>
+
+// most objects a leaf is made with, leaves smaller than this are made when SAH says splitting isn't worth it
+#define BVH_MAX_LEAF_SIZE 4
+// centroid bins tried per split
+#define BVH_SAH_BINS 12
+// cost of visiting a node relative to testing one object's box
+#define BVH_TRAVERSAL_COST 1.0f
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Closest object a ray hit
+		struct BVHRayHit_T
+		{
+			int id;
+			float distance;
+			glm::vec3 point;
+		};
+
+		// Work done by the last build and refit
+		struct SceneBVHStats_T
+		{
+			int
+				objects,
+				nodes,
+				leaves,
+				depth,
+				refit_objects,
+				refit_nodes;
+		};
+
+		// Bounding volume hierarchy over the world space boxes of scene objects.
+		// Built top down with a binned surface area heuristic, then kept up to date as objects move by
+		// refitting only the nodes above the objects that moved, so a frame where a few objects move
+		// costs a few walks up the tree rather than a rebuild. Adding or removing objects rebuilds it.
+		class SceneBVH
+		{
+		public:
+			// Adds a mesh, its bounds are taken from get_world_bounds, returns the id queries report
+			int add(Mesh * mesh);
+
+			// Adds a box with an optional mesh, returns the id queries report
+			int add(AABB_T box, Mesh * mesh = NULL);
+
+			// Removes an object, its id may be given to a later add. Adds and removes take effect at the next update
+			void remove(int id);
+
+			// Re-reads the bounds of a mesh that has moved
+			void move(int id);
+
+			// Sets the box of an object that has moved
+			void move(int id, AABB_T box);
+
+			// Rebuilds if objects were added or removed, otherwise refits the nodes above moved objects
+			void update();
+
+			// Builds the whole tree from scratch
+			void build();
+
+			// Refits the nodes above objects that moved since the last build or refit
+			void refit();
+
+			// Appends the id of every object whose box may be in the frustum
+			void query_frustum(Frustum_T * frustum, std::vector<int> * out);
+
+			// Finds the first object box the ray hits within max_distance, the direction needn't be normalised
+			bool raycast(glm::vec3 origin, glm::vec3 dir, float max_distance, BVHRayHit_T * hit);
+
+			// Finds the object whose box is closest to the point, -1 when none are within max_distance
+			int nearest(glm::vec3 point, float max_distance, float * distance = NULL);
+
+			// Removes every object and node
+			void clear();
+
+			Mesh * get_mesh(int id);
+			AABB_T get_box(int id);
+			int size();
+
+			// Gets the counters from the last build and refit
+			SceneBVHStats_T get_stats();
+
+			SceneBVH();
+
+		private:
+			struct Object_T
+			{
+				AABB_T box;
+				Mesh * mesh;
+				int leaf;
+				bool live;
+				bool moved;
+			};
+
+			// interior nodes have count 0 and children at first and first + 1,
+			// leaves hold count objects from m_refs starting at first
+			struct Node_T
+			{
+				AABB_T box;
+				int first;
+				int count;
+				int parent;
+			};
+
+			// Splits m_refs[start, end) under a node, returns the depth below it
+			int build_node(int node, int start, int end, int depth);
+
+			// Sets a leaf's box from its objects
+			void fit_leaf(int node);
+
+			std::vector<Object_T> m_objects;
+			std::vector<int> m_free;
+			std::vector<Node_T> m_nodes;
+			std::vector<int> m_refs;
+			std::vector<int> m_moved;
+			std::vector<glm::vec3> m_centroids;
+			std::vector<int> m_stack;
+
+			bool m_needs_build = false;
+
+			SceneBVHStats_T m_stats = {};
+		};
+	}
+}
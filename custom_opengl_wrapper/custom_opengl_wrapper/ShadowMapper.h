@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FBO.h"
+#include "GLContent.h"
 #include "Types.h"
 namespace gfx
 {
@@ -33,17 +34,17 @@ namespace gfx
 				m_fbo.binding_draw_meshes(model_handle, texture_handle);
 			}
 
-			void render_shadowmap(VarHandle * model_handle, VarHandle * texture_handle, VarHandle * view_handle, VarHandle *proj_handle)
+			// Draws the meshes from the light, its view and projection go through the shadow slot of the camera block
+			void render_shadowmap(GLContent * content, VarHandle * model_handle, VarHandle * texture_handle)
 			{
-				view_handle->load(m_v);
-				proj_handle->load(m_p);
+				load_mats(content);
 				m_fbo.binding_draw_meshes(model_handle, texture_handle);
 			}
 
-			void load_mats(VarHandle * view_handle, VarHandle *proj_handle)
+			// Loads the light's view and projection into the shadow slot of the camera block
+			void load_mats(GLContent * content)
 			{
-				view_handle->load(m_v);
-				proj_handle->load(m_p);
+				content->loadShadowCamera(m_v, m_p);
 			}
 
 			ShadowMapper * set_fbo(FBO fbo)
@@ -0,0 +1,259 @@
+#include "TextureAtlas.h"
+#include "GLStateCache.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <string.h>
+
+using gfx::engine::TextureAtlas;
+
+namespace
+{
+	const char * CLASSNAME = "TextureAtlas";
+	const int CHANNELS = 4;
+}
+
+// constructor
+TextureAtlas::TextureAtlas() {}
+TextureAtlas::TextureAtlas(glm::ivec2 page_size, int padding)
+{
+	m_page_size = page_size;
+	m_padding = padding;
+}
+
+// Loads an image file to be packed, returns its region index or -1 if it can't be loaded or won't fit a page
+int TextureAtlas::add(const char * filename)
+{
+	int existing = find(filename);
+	if (existing >= 0)
+		return existing;
+
+	alib::ImageData_T image = alib::ImageLoader::get_data_png(filename);
+	if (image.data == NULL)
+	{
+		CERROR(alib::StringFormat("image not loaded: %0").arg(filename).str(), __FILE__, __LINE__, CLASSNAME, "add");
+		return -1;
+	}
+	// the loader was asked for RGBA whatever the file holds
+	image.n = CHANNELS;
+	int region = add(&image);
+	alib::ImageLoader::free_data(&image);
+
+	if (region >= 0)
+		m_files[filename] = region;
+	return region;
+}
+
+// Copies RGBA pixels to be packed, returns its region index or -1 if it won't fit a page
+int TextureAtlas::add(alib::ImageData_T * image)
+{
+	if (image->n != CHANNELS)
+	{
+		CERROR(alib::StringFormat("only RGBA images can be packed, got %0 channels").arg(image->n).str(), __FILE__, __LINE__, CLASSNAME, "add");
+		return -1;
+	}
+	if (image->w > m_page_size.x || image->h > m_page_size.y)
+	{
+		CERROR(alib::StringFormat("%0x%1 image is bigger than a %2x%3 page").arg(image->w).arg(image->h).arg(m_page_size.x).arg(m_page_size.y).str(),
+			__FILE__, __LINE__, CLASSNAME, "add");
+		return -1;
+	}
+
+	PendingImage_T pending;
+	pending.size = glm::ivec2(image->w, image->h);
+	pending.pixels.assign(image->data, image->data + image->w * image->h * CHANNELS);
+	m_images.push_back(pending);
+	return m_images.size() - 1;
+}
+
+// Packs everything added and uploads the pages, the CPU copies are freed afterwards
+bool TextureAtlas::build(GLenum target)
+{
+	CINFO(alib::StringFormat("Packing %0 images into a texture atlas...").arg((int)m_images.size()).str());
+	m_target = target;
+
+	std::vector<glm::ivec2> sizes;
+	for (PendingImage_T & image : m_images)
+		sizes.push_back(image.size);
+	int pages = gfx::TexturePacker::pack(&sizes, m_page_size, m_padding, &m_rects);
+	if (pages < 0)
+		return false;
+
+	// trim the pages to what was used, an array's layers all have to be the size of the biggest
+	std::vector<glm::ivec2> page_sizes(pages, glm::ivec2(1));
+	for (gfx::PackedRect_T & r : m_rects)
+		page_sizes[r.page] = glm::max(page_sizes[r.page], glm::ivec2(r.x + r.w, r.y + r.h));
+	if (m_target == GL_TEXTURE_2D_ARRAY)
+	{
+		glm::ivec2 largest = glm::ivec2(1);
+		for (glm::ivec2 size : page_sizes)
+			largest = glm::max(largest, size);
+		page_sizes.assign(pages, largest);
+	}
+
+	std::vector<std::vector<unsigned char>> page_pixels(pages);
+	for (int p = 0; p < pages; ++p)
+		page_pixels[p].assign(page_sizes[p].x * page_sizes[p].y * CHANNELS, 0);
+
+	m_regions.resize(m_images.size());
+	for (int i = 0; i < (int)m_images.size(); ++i)
+	{
+		gfx::PackedRect_T & r = m_rects[i];
+		glm::vec2 page_size = glm::vec2(page_sizes[r.page]);
+		m_regions[i].offset = glm::vec2(r.x, r.y) / page_size;
+		m_regions[i].scale = glm::vec2(r.w, r.h) / page_size;
+		m_regions[i].layer = r.page;
+	}
+
+	double covered = 0.0, total = 0.0;
+	for (int i = 0; i < (int)m_images.size(); ++i)
+	{
+		gfx::PackedRect_T & r = m_rects[i];
+		std::vector<unsigned char> & page = page_pixels[r.page];
+		int width = page_sizes[r.page].x, height = page_sizes[r.page].y;
+		PendingImage_T & image = m_images[i];
+
+		for (int y = 0; y < r.h; ++y)
+			memcpy(&page[((r.y + y) * width + r.x) * CHANNELS], &image.pixels[y * r.w * CHANNELS], r.w * CHANNELS);
+
+		// stretch the edges out into the padding, corners included, clamped to the page
+		int
+			x0 = glm::max(r.x - m_padding, 0), x1 = glm::min(r.x + r.w + m_padding, width),
+			y0 = glm::max(r.y - m_padding, 0), y1 = glm::min(r.y + r.h + m_padding, height);
+		for (int y = y0; y < y1; ++y)
+		{
+			int sy = glm::clamp(y, r.y, r.y + r.h - 1);
+			for (int x = x0; x < x1; ++x)
+			{
+				int sx = glm::clamp(x, r.x, r.x + r.w - 1);
+				if (sx == x && sy == y)
+					continue;
+				memcpy(&page[(y * width + x) * CHANNELS], &page[(sy * width + sx) * CHANNELS], CHANNELS);
+			}
+		}
+		covered += (double)r.w * r.h;
+	}
+	for (glm::ivec2 size : page_sizes)
+		total += (double)size.x * size.y;
+	m_occupancy = total > 0.0 ? (float)(covered / total) : 0.0f;
+
+	if (m_target == GL_TEXTURE_2D_ARRAY)
+	{
+		m_textures.push_back(upload_array(&page_pixels, page_sizes[0]));
+	}
+	else
+	{
+		for (int p = 0; p < pages; ++p)
+			m_textures.push_back(upload_2d(&page_pixels[p], page_sizes[p]));
+	}
+	for (AtlasRegion_T & region : m_regions)
+		region.tex = get_tex(region.layer);
+
+	for (int p = 0; p < pages; ++p)
+		CINFO(alib::StringFormat("    page %0: %1x%2").arg(p).arg(page_sizes[p].x).arg(page_sizes[p].y).str());
+	CINFO(alib::StringFormat("    %0 images on %1 pages, occupancy %2").arg((int)m_images.size()).arg(pages).arg(m_occupancy).str());
+
+	m_images.clear();
+	m_images.shrink_to_fit();
+	return true;
+}
+
+// Region index of a file added earlier, or -1
+int TextureAtlas::find(const char * filename)
+{
+	std::map<std::string, int>::iterator it = m_files.find(filename);
+	return it == m_files.end() ? -1 : it->second;
+}
+
+// Gets where an image ended up, only valid after build
+gfx::engine::AtlasRegion_T TextureAtlas::get_region(int region)
+{
+	return m_regions[region];
+}
+
+// Maps an image's own UV into the page it was packed into
+glm::vec2 TextureAtlas::remap_uv(glm::vec2 uv, gfx::engine::AtlasRegion_T region)
+{
+	return region.offset + uv * region.scale;
+}
+
+// Rewrites a mesh's UVs to point at its image's region, done before the mesh is buffered
+void TextureAtlas::remap_uvs(gfx::VertexData * v, gfx::engine::AtlasRegion_T region)
+{
+	for (gfx::Vertex_T & vertex : *v)
+		vertex.uv = remap_uv(vertex.uv, region);
+}
+
+// Gets the texture holding a page, for an array every layer is in the one texture
+GLuint TextureAtlas::get_tex(int layer)
+{
+	if (m_textures.empty())
+		return GL_TEXTURE0;
+	return m_target == GL_TEXTURE_2D_ARRAY ? m_textures[0] : m_textures[layer];
+}
+GLenum TextureAtlas::get_target()
+{
+	return m_target;
+}
+int TextureAtlas::get_page_count()
+{
+	int pages = 0;
+	for (gfx::PackedRect_T & r : m_rects)
+		pages = glm::max(pages, r.page + 1);
+	return pages;
+}
+int TextureAtlas::get_region_count()
+{
+	return m_regions.empty() ? m_images.size() : m_regions.size();
+}
+
+// Fraction of the pages' area covered by images
+float TextureAtlas::get_occupancy()
+{
+	return m_occupancy;
+}
+
+// Deletes the textures, needs the context the atlas was built in
+void TextureAtlas::release()
+{
+	if (m_textures.empty())
+		return;
+	glDeleteTextures(m_textures.size(), m_textures.data());
+	gfx::engine::GLStateCache::invalidateTextures();
+	m_textures.clear();
+}
+
+// Uploads one page to a GL_TEXTURE_2D
+GLuint TextureAtlas::upload_2d(std::vector<unsigned char> * page, glm::ivec2 size)
+{
+	GLuint tex = GL_TEXTURE0;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	// regions sit next to each other so nothing may wrap into a neighbour
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, page->data());
+	glGenerateMipmap(GL_TEXTURE_2D);
+	// the texture was bound behind the state cache's back
+	gfx::engine::GLStateCache::invalidateTextures();
+	return tex;
+}
+
+// Uploads every page as one GL_TEXTURE_2D_ARRAY
+GLuint TextureAtlas::upload_array(std::vector<std::vector<unsigned char>> * pages, glm::ivec2 size)
+{
+	GLuint tex = GL_TEXTURE0;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, size.x, size.y, pages->size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	for (int layer = 0; layer < (int)pages->size(); ++layer)
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size.x, size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, (*pages)[layer].data());
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	gfx::engine::GLStateCache::invalidateTextures();
+	return tex;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include "Types.h"
+#include "PrimativeGenerator.h"
+#include "ImageLoader.h"
+#include "TexturePacker.h"
+#include <vector>
+#include <string>
+#include <map>
+
+// pages are this big unless asked otherwise, GL 4 guarantees at least 16384
+#define TEXTURE_ATLAS_PAGE_SIZE 4096
+// pixels between packed images, filled by stretching each image's edge so filtering never reaches a neighbour
+#define TEXTURE_ATLAS_PADDING 2
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Where an image ended up, uv = offset + uv * scale maps its own 0 to 1 coordinates into the page
+		struct AtlasRegion_T
+		{
+			glm::vec2 offset, scale;
+			// page of a GL_TEXTURE_2D_ARRAY atlas, or which texture of a GL_TEXTURE_2D one
+			int layer;
+			GLuint tex;
+		};
+
+		// Packs same format (RGBA8) images into a few large textures at load time, so meshes and GUI quads that
+		// used to bind a texture each can share one and be drawn without rebinding. Pages are either separate
+		// GL_TEXTURE_2D textures or the layers of one GL_TEXTURE_2D_ARRAY, a shader sampling the array takes
+		// vec3(uv, layer). Images are packed with TexturePacker and their UVs rewritten with remap_uvs.
+		// Packed UVs can't repeat, an image that tiles needs to keep its own texture.
+		class TextureAtlas
+		{
+		public:
+			// Loads an image file to be packed, returns its region index or -1 if it can't be loaded or won't fit a page
+			int add(const char * filename);
+
+			// Copies RGBA pixels to be packed, returns its region index or -1 if it won't fit a page
+			int add(alib::ImageData_T * image);
+
+			// Packs everything added and uploads the pages, the CPU copies are freed afterwards
+			bool build(GLenum target = GL_TEXTURE_2D);
+
+			// Region index of a file added earlier, or -1
+			int find(const char * filename);
+
+			// Gets where an image ended up, only valid after build
+			AtlasRegion_T get_region(int region);
+
+			// Maps an image's own UV into the page it was packed into
+			static glm::vec2 remap_uv(glm::vec2 uv, AtlasRegion_T region);
+
+			// Rewrites a mesh's UVs to point at its image's region, done before the mesh is buffered
+			static void remap_uvs(gfx::VertexData * v, AtlasRegion_T region);
+
+			// Gets the texture holding a page, for an array every layer is in the one texture
+			GLuint get_tex(int layer = 0);
+			GLenum get_target();
+			int get_page_count();
+			int get_region_count();
+
+			// Fraction of the pages' area covered by images
+			float get_occupancy();
+
+			// Deletes the textures, needs the context the atlas was built in
+			void release();
+
+			TextureAtlas();
+			TextureAtlas(glm::ivec2 page_size, int padding);
+
+		private:
+			// Uploads one page to a GL_TEXTURE_2D
+			GLuint upload_2d(std::vector<unsigned char> * page, glm::ivec2 size);
+
+			// Uploads every page as one GL_TEXTURE_2D_ARRAY
+			GLuint upload_array(std::vector<std::vector<unsigned char>> * pages, glm::ivec2 size);
+
+			struct PendingImage_T
+			{
+				std::vector<unsigned char> pixels;
+				glm::ivec2 size;
+			};
+
+			glm::ivec2 m_page_size = glm::ivec2(TEXTURE_ATLAS_PAGE_SIZE);
+			int m_padding = TEXTURE_ATLAS_PADDING;
+			GLenum m_target = GL_TEXTURE_2D;
+
+			std::vector<PendingImage_T> m_images;
+			std::vector<gfx::PackedRect_T> m_rects;
+			std::vector<AtlasRegion_T> m_regions;
+			std::map<std::string, int> m_files;
+			std::vector<GLuint> m_textures;
+			float m_occupancy = 0.0f;
+		};
+	}
+}
@@ -0,0 +1,139 @@
+#include "TexturePacker.h"
+#include <algorithm>
+#include <limits.h>
+
+using gfx::TexturePacker;
+
+namespace
+{
+	// a run of the skyline, everything below y between x and x + w is taken
+	struct SkylineNode_T
+	{
+		int x, y, w;
+	};
+
+	// Lowest y a w by h rect can sit at with its left edge on node index, or -1 if it runs off the page
+	int fit(std::vector<SkylineNode_T> * skyline, int index, int w, int h, glm::ivec2 page_size)
+	{
+		int x = (*skyline)[index].x;
+		if (x + w > page_size.x)
+			return -1;
+		int y = 0, left = w;
+		for (int i = index; left > 0; ++i)
+		{
+			y = glm::max(y, (*skyline)[i].y);
+			if (y + h > page_size.y)
+				return -1;
+			left -= (*skyline)[i].w;
+		}
+		return y;
+	}
+
+	// Raises the skyline over a rect placed at node index
+	void place(std::vector<SkylineNode_T> * skyline, int index, int y, int w, int h)
+	{
+		SkylineNode_T node = { (*skyline)[index].x, y + h, w };
+		skyline->insert(skyline->begin() + index, node);
+
+		// cut back or drop the nodes the new one now covers
+		for (int i = index + 1; i < (int)skyline->size(); )
+		{
+			SkylineNode_T & next = (*skyline)[i];
+			int overlap = node.x + node.w - next.x;
+			if (overlap <= 0)
+				break;
+			if (overlap < next.w)
+			{
+				next.x += overlap;
+				next.w -= overlap;
+				break;
+			}
+			skyline->erase(skyline->begin() + i);
+		}
+
+		// join neighbours at the same height
+		for (int i = 0; i + 1 < (int)skyline->size(); )
+		{
+			if ((*skyline)[i].y == (*skyline)[i + 1].y)
+			{
+				(*skyline)[i].w += (*skyline)[i + 1].w;
+				skyline->erase(skyline->begin() + i + 1);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+}
+
+// packs every size onto pages of page_size with padding pixels between neighbours, rects are returned in the
+// order of sizes, returns the number of pages used or -1 if a size is bigger than a page
+int TexturePacker::pack(std::vector<glm::ivec2> * sizes, glm::ivec2 page_size, int padding, std::vector<gfx::PackedRect_T> * rects)
+{
+	int n = sizes->size();
+	rects->assign(n, { 0, 0, 0, 0, -1 });
+
+	// every rect carries its padding on its right and bottom, the page gets the same so the last one can overhang
+	glm::ivec2 padded_page = page_size + padding;
+
+	std::vector<int> order(n);
+	for (int i = 0; i < n; ++i)
+	{
+		order[i] = i;
+		if ((*sizes)[i].x > page_size.x || (*sizes)[i].y > page_size.y)
+			return -1;
+	}
+	std::sort(order.begin(), order.end(), [sizes](int a, int b)
+	{
+		glm::ivec2 sa = (*sizes)[a], sb = (*sizes)[b];
+		return sa.y != sb.y ? sa.y > sb.y : sa.x > sb.x;
+	});
+
+	std::vector<std::vector<SkylineNode_T>> pages;
+	for (int i : order)
+	{
+		int w = (*sizes)[i].x + padding, h = (*sizes)[i].y + padding;
+
+		// the open page and node where the rect's top edge is lowest, then leftmost
+		int best_page = -1, best_node = -1, best_y = 0, best_top = INT_MAX, best_x = INT_MAX;
+		for (int p = 0; p < (int)pages.size(); ++p)
+			for (int j = 0; j < (int)pages[p].size(); ++j)
+			{
+				int y = fit(&pages[p], j, w, h, padded_page);
+				if (y < 0)
+					continue;
+				if (y + h < best_top || (y + h == best_top && pages[p][j].x < best_x))
+				{
+					best_page = p;
+					best_node = j;
+					best_y = y;
+					best_top = y + h;
+					best_x = pages[p][j].x;
+				}
+			}
+
+		if (best_page < 0)
+		{
+			pages.push_back({ { 0, 0, padded_page.x } });
+			best_page = pages.size() - 1;
+			best_node = 0;
+			best_y = 0;
+		}
+
+		(*rects)[i] = { pages[best_page][best_node].x, best_y, (*sizes)[i].x, (*sizes)[i].y, best_page };
+		place(&pages[best_page], best_node, best_y, w, h);
+	}
+	return pages.size();
+}
+
+// fraction of the pages' area the packed rects cover
+float TexturePacker::get_occupancy(std::vector<gfx::PackedRect_T> * rects, glm::ivec2 page_size, int pages)
+{
+	if (pages <= 0)
+		return 0.0f;
+	double area = 0.0;
+	for (gfx::PackedRect_T & r : *rects)
+		area += (double)r.w * r.h;
+	return (float)(area / ((double)page_size.x * page_size.y * pages));
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "glm.h"
+#include <vector>
+
+namespace gfx
+{
+	// Where a rect ended up, x and y are its top left corner in pixels on its page
+	struct PackedRect_T
+	{
+		int x, y, w, h, page;
+	};
+
+	// Asset-time rect packing for texture atlases, skyline bottom-left (Jukka Jylanki's "A Thousand Ways to Pack the Bin").
+	// Each page keeps the outline of its packed rects' top edges and a rect goes wherever its top edge ends up lowest,
+	// rects are placed tallest first so the skyline stays flat. A rect that fits no open page starts a new one.
+	class TexturePacker
+	{
+	public:
+		// packs every size onto pages of page_size with padding pixels between neighbours, rects are returned in the
+		// order of sizes, returns the number of pages used or -1 if a size is bigger than a page
+		static int pack(std::vector<glm::ivec2> * sizes, glm::ivec2 page_size, int padding, std::vector<PackedRect_T> * rects);
+
+		// fraction of the pages' area the packed rects cover
+		static float get_occupancy(std::vector<PackedRect_T> * rects, glm::ivec2 page_size, int pages);
+	};
+}
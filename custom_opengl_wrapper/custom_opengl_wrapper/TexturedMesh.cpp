@@ -1,4 +1,5 @@
 #include "TexturedMesh.h"
+#include "GLStateCache.h"
 
 using gfx::engine::TexturedMesh;
 
@@ -14,9 +15,17 @@ void TexturedMesh::draw(int wire_frame, gfx::engine::VarHandle *model, gfx::engi
 
 void TexturedMesh::add_mesh(gfx::engine::Mesh mesh)
 {
+	// each part is drawn with its own transform on top of this mesh's, so its bounds are carried across the same way
+	gfx::engine::Bounds_T bounds = gfx::engine::Bounds::transform(mesh.m_bounds, mesh.get_model_mat());
+	m_bounds = m_meshes.empty() ? bounds : gfx::engine::Bounds::merge(m_bounds, bounds);
 	m_meshes.push_back(mesh);
 }
 
+gfx::engine::Bounds_T TexturedMesh::get_world_bounds()
+{
+	return Mesh::get_world_bounds();
+}
+
 TexturedMesh::TexturedMesh() {}
 
 TexturedMesh::TexturedMesh(
@@ -125,6 +134,7 @@ TexturedMesh::TexturedMesh(
 			std::string tex_name = materials[i].diffuse_texname;
 			tex_name = std::string(base_filename).append(tex_name.c_str()).c_str();
 			GLuint textId = alib::ImageLoader::loadTextureFromImage(tex_name.c_str());
+			gfx::engine::GLStateCache::invalidateTextures();
 
 			//texture_map.insert(std::make_pair(materials[i].diffuse_texname.c_str(), t));
 
@@ -19,6 +19,9 @@ namespace gfx
 
 			void add_mesh(Mesh mesh);
 
+			// Gets the bounds around every part in world space
+			Bounds_T get_world_bounds();
+
 			TexturedMesh();
 
 			TexturedMesh(
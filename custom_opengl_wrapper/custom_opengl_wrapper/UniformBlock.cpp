@@ -0,0 +1,98 @@
+#include "UniformBlock.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include "GLStateCache.h"
+#include <cstring>
+
+using gfx::engine::UniformBlock;
+
+namespace
+{
+	const char * CLASSNAME = "UniformBlock";
+}
+
+// Copies the data into a slot, only uploading if it differs from what the slot holds
+void UniformBlock::update(int slot, const void * data)
+{
+	if (slot < 0 || slot >= m_slots)
+	{
+		CERROR(alib::StringFormat("slot %0 out of range (%1 slots)").arg(slot).arg(m_slots).str(),
+			__FILE__, __LINE__, CLASSNAME, "update");
+		return;
+	}
+	init();
+
+	unsigned char * shadow = &m_shadow[slot * m_size];
+	if (m_valid[slot] && memcmp(shadow, data, m_size) == 0)
+		return;
+	memcpy(shadow, data, m_size);
+	m_valid[slot] = true;
+
+	gfx::engine::GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, slot * m_stride, m_size, data);
+}
+
+// Binds a slot to the block's binding point
+void UniformBlock::bind(int slot)
+{
+	init();
+	gfx::engine::GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, m_binding, m_buffer, slot * m_stride, m_size);
+}
+
+// Updates a slot then binds it
+void UniformBlock::load(int slot, const void * data)
+{
+	update(slot, data);
+	bind(slot);
+}
+
+GLuint UniformBlock::get_binding()
+{
+	return m_binding;
+}
+
+int UniformBlock::get_slot_count()
+{
+	return m_slots;
+}
+
+// Deletes the buffer
+void UniformBlock::release()
+{
+	if (m_buffer != 0)
+		glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+	m_valid.assign(m_slots, false);
+}
+
+// Creates the buffer, deferred until first use as it needs a context
+void UniformBlock::init()
+{
+	if (m_buffer != 0)
+		return;
+
+	// each slot has to start on the offset alignment for glBindBufferRange
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_stride = ((m_size + alignment - 1) / alignment) * alignment;
+
+	glGenBuffers(1, &m_buffer);
+	gfx::engine::GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, m_stride * m_slots, NULL, GL_DYNAMIC_DRAW);
+	m_valid.assign(m_slots, false);
+
+	CINFO(alib::StringFormat("    uniform block %0 created at binding %1 (%2 slots of %3 bytes)")
+		.arg(m_buffer).arg(m_binding).arg(m_slots).arg((int)m_stride).str());
+}
+
+// constructor
+UniformBlock::UniformBlock() {}
+
+UniformBlock::UniformBlock(GLuint binding, GLsizeiptr size, int slots)
+{
+	m_binding = binding;
+	m_size = size;
+	m_slots = slots;
+	m_shadow.resize(size * slots);
+	m_valid.assign(slots, false);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include <vector>
+
+// fixed binding points of the shared uniform blocks, the shaders declare the blocks with these names
+#define UBO_BINDING_CAMERA 0
+#define UBO_BINDING_LIGHTING 1
+
+#define UBO_NAME_CAMERA "Camera"
+#define UBO_NAME_LIGHTING "Lighting"
+
+namespace gfx
+{
+	namespace engine
+	{
+		// std140 layout of the Camera block (vec3s are padded to vec4)
+		struct CameraBlock_T
+		{
+			glm::mat4 view;
+			glm::mat4 proj;
+			glm::vec4 eye_pos;
+		};
+
+		// std140 layout of the Lighting block (vec3s are padded to vec4)
+		struct LightBlock_T
+		{
+			glm::vec4 pos;
+			glm::vec4 color;
+			glm::vec4 properties;
+			glm::vec4 ambient;
+		};
+
+		// A std140 uniform buffer shared by every program through a fixed binding point.
+		// The buffer holds a number of slots so several versions of the block (e.g. one per projection)
+		// can live on the GPU at once and switching between them is a rebind rather than an upload.
+		class UniformBlock
+		{
+		public:
+			// Copies the data into a slot, only uploading if it differs from what the slot holds
+			void update(int slot, const void * data);
+
+			// Binds a slot to the block's binding point
+			void bind(int slot = 0);
+
+			// Updates a slot then binds it
+			void load(int slot, const void * data);
+
+			GLuint get_binding();
+
+			int get_slot_count();
+
+			// Deletes the buffer
+			void release();
+
+
+			// constructor
+
+			UniformBlock();
+
+			UniformBlock(GLuint binding, GLsizeiptr size, int slots = 1);
+
+		private:
+			// Creates the buffer, deferred until first use as it needs a context
+			void init();
+
+			// member variables
+
+			GLuint
+				m_binding = 0,
+				m_buffer = 0;
+
+			GLsizeiptr
+				m_size = 0,
+				m_stride = 0;
+
+			int m_slots = 0;
+
+			// copy of each slot's contents, compared against before uploading
+			std::vector<unsigned char> m_shadow;
+			std::vector<bool> m_valid;
+		};
+	}
+}
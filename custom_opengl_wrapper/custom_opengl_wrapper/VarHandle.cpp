@@ -1,6 +1,7 @@
 #include "VarHandle.h"
 #include "CLog.h"
 #include "StringFormat.h"
+#include <string.h>
 
 using gfx::engine::VarHandle;
 
@@ -26,50 +27,72 @@ void VarHandle::init(GLuint program)
 	CINFO(alib::StringFormat("Program ID %0: linking %1 -> VarHandle ID %2").arg(program).arg(m_var_name).arg(m_handle).str());
 }
 
+// Uploads the bound data, every load skips the upload if the value matches the last one sent
 void VarHandle::load()
 {
 	if (m_handle_type != NO_HANDLE)
 	{
 		if (m_handle_type == MAT4_HANDLE)
-		{
-			glm::mat4 mat = *m_data_m;
-			glUniformMatrix4fv(m_handle, 1, GL_FALSE, &mat[0][0]);
-		}
+			load(*m_data_m);
 		else if (m_handle_type == VEC3_HANDLE)
-			glUniform3f(m_handle, m_data_v3->x, m_data_v3->y, m_data_v3->z);
+			load(*m_data_v3);
 		else if (m_handle_type == VEC4_HANDLE)
-			glUniform4f(m_handle, m_data_v4->x, m_data_v4->y, m_data_v4->z, m_data_v4->w);
+			load(*m_data_v4);
 		else if (m_handle_type == FLOAT_HANDLE)
-			glUniform1f(m_handle, *m_data_f);
+			load(*m_data_f);
 		else if (m_handle_type == GLUINT_HANDLE)
-			glUniform1i(m_handle, *m_data_i);
+			load(*m_data_i);
 		else if (m_handle_type == INT_HANDLE)
-			glUniform1i(m_handle, *m_data_ii);
+			load(*m_data_ii);
 	}
 }
 void VarHandle::load(glm::mat4 data)
 {
-	glUniformMatrix4fv(m_handle, 1, GL_FALSE, &data[0][0]);
+	if (changed(&data[0][0], sizeof(data)))
+		glUniformMatrix4fv(m_handle, 1, GL_FALSE, &data[0][0]);
 }
 void VarHandle::load(glm::vec3 data)
 {
-	glUniform3f(m_handle, data.x, data.y, data.z);
+	if (changed(&data[0], sizeof(data)))
+		glUniform3f(m_handle, data.x, data.y, data.z);
 }
 void VarHandle::load(glm::vec4 data)
 {
-	glUniform4f(m_handle, data.x, data.y, data.z, data.w);
+	if (changed(&data[0], sizeof(data)))
+		glUniform4f(m_handle, data.x, data.y, data.z, data.w);
 }
 void VarHandle::load(GLfloat data)
 {
-	glUniform1f(m_handle, data);
+	if (changed(&data, sizeof(data)))
+		glUniform1f(m_handle, data);
 }
 void VarHandle::load(GLuint data)
 {
-	glUniform1i(m_handle, data);
+	if (changed(&data, sizeof(data)))
+		glUniform1i(m_handle, data);
 }
 void VarHandle::load(int data)
 {
-	glUniform1i(m_handle, data);
+	if (changed(&data, sizeof(data)))
+		glUniform1i(m_handle, data);
+}
+
+// Forgets the last uploaded value so the next load always reaches GL
+void VarHandle::invalidate()
+{
+	m_shadow_valid = false;
+}
+
+bool VarHandle::changed(const void * data, size_t size)
+{
+	// missing uniforms are never uploaded
+	if (m_handle == gfx::engine::NULL_VAR_HANDLE_ID)
+		return false;
+	if (m_shadow_valid && memcmp(m_shadow, data, size) == 0)
+		return false;
+	memcpy(m_shadow, data, size);
+	m_shadow_valid = true;
+	return true;
 }
 
 glm::mat4 * VarHandle::get_handle_data_mat4()
@@ -94,46 +117,55 @@ const char * VarHandle::get_handle_name()
 
 VarHandle::VarHandle()
 {
+	m_var_name = "";
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_handle_type = NO_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_handle_type = NO_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_, glm::mat4 * data)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_data_m = data;
 	m_handle_type = MAT4_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_, glm::vec3 * data)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_data_v3 = data;
 	m_handle_type = VEC3_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_, glm::vec4 * data)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_data_v4 = data;
 	m_handle_type = VEC4_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_, GLfloat * data)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_data_f = data;
 	m_handle_type = FLOAT_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_, GLuint * data)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_data_i = data;
 	m_handle_type = GLUINT_HANDLE;
 }
 VarHandle::VarHandle(const char * var_name_, int * data)
 {
 	m_var_name = var_name_;
+	m_handle = gfx::engine::NULL_VAR_HANDLE_ID;
 	m_data_ii = data;
 	m_handle_type = INT_HANDLE;
 }
\ No newline at end of file
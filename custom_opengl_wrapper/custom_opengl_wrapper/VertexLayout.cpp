@@ -0,0 +1,273 @@
+#include "VertexLayout.h"
+#include "CLog.h"
+#include "StringFormat.h"
+#include <glm/gtc/packing.hpp>
+#include <cstring>
+
+using gfx::engine::VertexLayout;
+using gfx::engine::VertexFormat_T;
+
+namespace
+{
+	const char * CLASSNAME = "VertexLayout";
+
+	const char * ATTRIB_NAMES[VERTEX_ATTRIB_COUNT] = { "position", "color", "normal", "uv", "tangent" };
+
+	// components read from Vertex_T for each attribute
+	int attrib_components(int attrib)
+	{
+		return attrib == VERTEX_ATTRIB_UV ? 2 : 3;
+	}
+
+	// bytes an attribute takes in the packed vertex, 3 component halves are padded to 4 to keep alignment
+	int attrib_size(int attrib, VertexFormat_T format)
+	{
+		int n = attrib_components(attrib);
+		switch (format)
+		{
+		case gfx::engine::VF_FLOAT:
+			return n * sizeof(GLfloat);
+		case gfx::engine::VF_HALF:
+		case gfx::engine::VF_UNORM16:
+			return (n == 3 ? 4 : n) * sizeof(GLushort);
+		case gfx::engine::VF_UNORM8:
+		case gfx::engine::VF_OCT16:
+		case gfx::engine::VF_SNORM10:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	// checks a format makes sense for an attribute
+	bool attrib_supports(int attrib, VertexFormat_T format)
+	{
+		bool is_direction = attrib == VERTEX_ATTRIB_NORMAL || attrib == VERTEX_ATTRIB_TANGENT;
+		switch (format)
+		{
+		case gfx::engine::VF_UNORM8:
+			return attrib == VERTEX_ATTRIB_COLOR;
+		case gfx::engine::VF_OCT16:
+		case gfx::engine::VF_SNORM10:
+			return is_direction;
+		case gfx::engine::VF_UNORM16:
+			return !is_direction;
+		default:
+			return true;
+		}
+	}
+
+	// maps a unit vector onto the octahedron and unfolds it into [-1,1]^2
+	glm::vec2 oct_encode(glm::vec3 n)
+	{
+		float l1 = fabs(n.x) + fabs(n.y) + fabs(n.z);
+		if (l1 == 0.0f)
+			return glm::vec2(0, 0);
+		n /= l1;
+		glm::vec2 p(n.x, n.y);
+		if (n.z < 0.0f)
+		{
+			p = glm::vec2(
+				(1.0f - fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+				(1.0f - fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+		}
+		return p;
+	}
+
+	// reads an attribute out of a vertex as a vec4
+	glm::vec4 attrib_value(const gfx::Vertex_T & v, int attrib)
+	{
+		switch (attrib)
+		{
+		case VERTEX_ATTRIB_POSITION: return glm::vec4(v.position, 1.0f);
+		case VERTEX_ATTRIB_COLOR: return glm::vec4(v.color, 1.0f);
+		case VERTEX_ATTRIB_NORMAL: return glm::vec4(v.normal, 0.0f);
+		case VERTEX_ATTRIB_UV: return glm::vec4(v.uv, 0.0f, 0.0f);
+		default: return glm::vec4(v.tangent, 0.0f);
+		}
+	}
+}
+
+// Full float layout, 56 bytes
+VertexLayout VertexLayout::full()
+{
+	return VertexLayout(VF_FLOAT, VF_FLOAT, VF_FLOAT, VF_FLOAT, VF_FLOAT);
+}
+
+// Half positions and uvs, RGBA8 colour, 10:10:10:2 normal, no tangent, 20 bytes
+VertexLayout VertexLayout::compact()
+{
+	return VertexLayout(VF_HALF, VF_UNORM8, VF_SNORM10, VF_HALF, VF_NONE);
+}
+
+// Half positions and uvs, RGBA8 colour, octahedral normal and tangent, 24 bytes
+VertexLayout VertexLayout::compact_oct()
+{
+	return VertexLayout(VF_HALF, VF_UNORM8, VF_OCT16, VF_HALF, VF_OCT16);
+}
+
+// Half positions, unorm16 uvs, nothing else, 12 bytes
+VertexLayout VertexLayout::gui()
+{
+	return VertexLayout(VF_HALF, VF_NONE, VF_NONE, VF_UNORM16, VF_NONE);
+}
+
+// Packs the vertices into a byte buffer of this layout, recording the position bounds for VF_UNORM16
+std::vector<unsigned char> VertexLayout::pack(std::vector<gfx::Vertex_T> * d)
+{
+	std::vector<unsigned char> out(d->size() * m_stride);
+
+	if (m_formats[VERTEX_ATTRIB_POSITION] == VF_UNORM16 && d->size() > 0)
+	{
+		glm::vec3 lo = (*d)[0].position, hi = lo;
+		for (int i = 1; i < d->size(); ++i)
+		{
+			lo = glm::min(lo, (*d)[i].position);
+			hi = glm::max(hi, (*d)[i].position);
+		}
+		m_bounds_min = lo;
+		// flat axes still need a non zero scale
+		m_bounds_size = glm::max(hi - lo, glm::vec3(1e-6f));
+	}
+
+	for (int i = 0; i < d->size(); ++i)
+	{
+		unsigned char * vertex = &out[i * m_stride];
+		for (int a = 0; a < VERTEX_ATTRIB_COUNT; ++a)
+		{
+			unsigned char * dst = vertex + m_offsets[a];
+			glm::vec4 value = attrib_value((*d)[i], a);
+			int n = attrib_components(a);
+			switch (m_formats[a])
+			{
+			case VF_FLOAT:
+				memcpy(dst, &value[0], n * sizeof(GLfloat));
+				break;
+			case VF_HALF:
+			{
+				glm::uint64 packed = glm::packHalf4x16(value);
+				memcpy(dst, &packed, attrib_size(a, VF_HALF));
+				break;
+			}
+			case VF_UNORM16:
+			{
+				if (a == VERTEX_ATTRIB_POSITION)
+					value = glm::vec4((glm::vec3(value) - m_bounds_min) / m_bounds_size, 1.0f);
+				glm::uint64 packed = glm::packUnorm4x16(value);
+				memcpy(dst, &packed, attrib_size(a, VF_UNORM16));
+				break;
+			}
+			case VF_UNORM8:
+			{
+				glm::uint32 packed = glm::packUnorm4x8(value);
+				memcpy(dst, &packed, sizeof(packed));
+				break;
+			}
+			case VF_OCT16:
+			{
+				glm::uint32 packed = glm::packSnorm2x16(oct_encode(glm::vec3(value)));
+				memcpy(dst, &packed, sizeof(packed));
+				break;
+			}
+			case VF_SNORM10:
+			{
+				glm::uint32 packed = glm::packSnorm3x10_1x2(value);
+				memcpy(dst, &packed, sizeof(packed));
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+
+	return out;
+}
+
+// Sets the attribute pointers for the currently bound VAO and VBO
+void VertexLayout::apply()
+{
+	for (int a = 0; a < VERTEX_ATTRIB_COUNT; ++a)
+	{
+		const GLvoid * offset = (const GLvoid*)(size_t)m_offsets[a];
+		int n = attrib_components(a);
+		switch (m_formats[a])
+		{
+		case VF_FLOAT:
+			glVertexAttribPointer((GLuint)a, n, GL_FLOAT, GL_FALSE, m_stride, offset);
+			break;
+		case VF_HALF:
+			glVertexAttribPointer((GLuint)a, n, GL_HALF_FLOAT, GL_FALSE, m_stride, offset);
+			break;
+		case VF_UNORM16:
+			glVertexAttribPointer((GLuint)a, n, GL_UNSIGNED_SHORT, GL_TRUE, m_stride, offset);
+			break;
+		case VF_UNORM8:
+			glVertexAttribPointer((GLuint)a, 4, GL_UNSIGNED_BYTE, GL_TRUE, m_stride, offset);
+			break;
+		case VF_OCT16:
+			glVertexAttribPointer((GLuint)a, 2, GL_SHORT, GL_TRUE, m_stride, offset);
+			break;
+		case VF_SNORM10:
+			glVertexAttribPointer((GLuint)a, 4, GL_INT_2_10_10_10_REV, GL_TRUE, m_stride, offset);
+			break;
+		default:
+			glDisableVertexAttribArray((GLuint)a);
+			continue;
+		}
+		glEnableVertexAttribArray((GLuint)a);
+	}
+}
+
+// Scale that maps quantised positions back to model space, position = i_vert * scale + offset (1 unless positions are VF_UNORM16)
+glm::vec3 VertexLayout::get_dequantise_scale()
+{
+	if (m_formats[VERTEX_ATTRIB_POSITION] != VF_UNORM16)
+		return glm::vec3(1, 1, 1);
+	return m_bounds_size;
+}
+
+// Offset that maps quantised positions back to model space (0 unless positions are VF_UNORM16)
+glm::vec3 VertexLayout::get_dequantise_offset()
+{
+	if (m_formats[VERTEX_ATTRIB_POSITION] != VF_UNORM16)
+		return glm::vec3(0, 0, 0);
+	return m_bounds_min;
+}
+
+// Bytes per vertex
+int VertexLayout::get_stride()
+{
+	return m_stride;
+}
+
+// Format of an attribute
+VertexFormat_T VertexLayout::get_format(int attrib)
+{
+	return m_formats[attrib];
+}
+
+// Same as full()
+VertexLayout::VertexLayout() : VertexLayout(VF_FLOAT, VF_FLOAT, VF_FLOAT, VF_FLOAT, VF_FLOAT) {}
+
+VertexLayout::VertexLayout(VertexFormat_T position, VertexFormat_T color, VertexFormat_T normal, VertexFormat_T uv, VertexFormat_T tangent)
+{
+	m_formats[VERTEX_ATTRIB_POSITION] = position;
+	m_formats[VERTEX_ATTRIB_COLOR] = color;
+	m_formats[VERTEX_ATTRIB_NORMAL] = normal;
+	m_formats[VERTEX_ATTRIB_UV] = uv;
+	m_formats[VERTEX_ATTRIB_TANGENT] = tangent;
+
+	m_stride = 0;
+	for (int a = 0; a < VERTEX_ATTRIB_COUNT; ++a)
+	{
+		if (!attrib_supports(a, m_formats[a]))
+		{
+			CERROR(alib::StringFormat("unsupported format for %0, falling back to float").arg(ATTRIB_NAMES[a]).str(),
+				__FILE__, __LINE__, CLASSNAME, "VertexLayout");
+			m_formats[a] = VF_FLOAT;
+		}
+		m_offsets[a] = m_stride;
+		m_stride += attrib_size(a, m_formats[a]);
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "opengl.h"
+#include "glm.h"
+#include "Types.h"
+#include <vector>
+
+// attribute locations shared by every shader
+#define VERTEX_ATTRIB_POSITION 0
+#define VERTEX_ATTRIB_COLOR 1
+#define VERTEX_ATTRIB_NORMAL 2
+#define VERTEX_ATTRIB_UV 3
+#define VERTEX_ATTRIB_TANGENT 4
+#define VERTEX_ATTRIB_COUNT 5
+
+namespace gfx
+{
+	namespace engine
+	{
+		// Storage format of a single vertex attribute
+		enum VertexFormat_T
+		{
+			// attribute is not stored, the shader reads the current generic value
+			VF_NONE = 0,
+			// 32-bit floats
+			VF_FLOAT,
+			// 16-bit floats
+			VF_HALF,
+			// 16-bit normalised; positions are normalised to the mesh bounds, colours and uvs must be in [0,1]
+			VF_UNORM16,
+			// RGBA8 normalised (colours only)
+			VF_UNORM8,
+			// octahedral encoded unit vector in two snorm16 (normals/tangents only, needs a *_packed shader)
+			VF_OCT16,
+			// signed 10:10:10:2 normalised unit vector (normals/tangents only, works with the standard shaders)
+			VF_SNORM10
+		};
+
+		// Describes how Vertex_T data is packed into a VBO and generates the matching attribute pointers
+		class VertexLayout
+		{
+		public:
+			// Full float layout, 56 bytes
+			static VertexLayout full();
+
+			// Half positions and uvs, RGBA8 colour, 10:10:10:2 normal, no tangent, 20 bytes
+			static VertexLayout compact();
+
+			// Half positions and uvs, RGBA8 colour, octahedral normal and tangent, 24 bytes
+			static VertexLayout compact_oct();
+
+			// Half positions, unorm16 uvs, nothing else, 12 bytes
+			static VertexLayout gui();
+
+			// Packs the vertices into a byte buffer of this layout, recording the position bounds for VF_UNORM16
+			std::vector<unsigned char> pack(std::vector<gfx::Vertex_T> * d);
+
+			// Sets the attribute pointers for the currently bound VAO and VBO
+			void apply();
+
+			// Scale that maps quantised positions back to model space, position = i_vert * scale + offset (1 unless positions are VF_UNORM16)
+			glm::vec3 get_dequantise_scale();
+
+			// Offset that maps quantised positions back to model space (0 unless positions are VF_UNORM16)
+			glm::vec3 get_dequantise_offset();
+
+			// Bytes per vertex
+			int get_stride();
+
+			// Format of an attribute
+			VertexFormat_T get_format(int attrib);
+
+
+			// constructors
+
+			// Same as full()
+			VertexLayout();
+
+			VertexLayout(VertexFormat_T position, VertexFormat_T color, VertexFormat_T normal, VertexFormat_T uv, VertexFormat_T tangent);
+
+		private:
+			// member variables
+
+			VertexFormat_T m_formats[VERTEX_ATTRIB_COUNT];
+
+			int m_offsets[VERTEX_ATTRIB_COUNT];
+
+			int m_stride = 0;
+
+			glm::vec3
+				m_bounds_min = glm::vec3(0.0f),
+				m_bounds_size = glm::vec3(1, 1, 1);
+		};
+	}
+}
@@ -0,0 +1,171 @@
+// Times SceneBVH queries against a brute force scan of every object.
+// CPU only, so it runs on machines without a GPU. Build it on its own with
+// SceneBVH.cpp, Bounds.cpp and Mesh.cpp in place of main.cpp.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <float.h>
+
+#include "SceneBVH.h"
+
+#define BENCH_OBJECTS 100000
+#define BENCH_WORLD_SIZE 2000.0f
+#define BENCH_QUERIES 1000
+#define BENCH_MOVED_PERCENT 1
+
+using gfx::engine::AABB_T;
+using gfx::engine::Bounds;
+using gfx::engine::SceneBVH;
+
+std::vector<AABB_T> boxes;
+SceneBVH bvh;
+
+inline float randf()
+{
+	return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+}
+
+glm::vec3 random_point()
+{
+	return (glm::vec3(randf(), randf(), randf()) - 0.5f) * BENCH_WORLD_SIZE;
+}
+
+AABB_T random_box()
+{
+	glm::vec3 center = random_point();
+	glm::vec3 extent = glm::vec3(randf(), randf(), randf()) * 4.0f + 0.5f;
+	return { center - extent, center + extent };
+}
+
+double now_ms()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+float ray_box(glm::vec3 origin, glm::vec3 dir, AABB_T box)
+{
+	glm::vec3 t0 = (box.min - origin) / dir;
+	glm::vec3 t1 = (box.max - origin) / dir;
+	glm::vec3 near_t = glm::min(t0, t1), far_t = glm::max(t0, t1);
+	float enter = glm::max(glm::max(near_t.x, near_t.y), glm::max(near_t.z, 0.0f));
+	float exit = glm::min(glm::min(far_t.x, far_t.y), far_t.z);
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+void report(const char * name, double bvh_ms, double brute_ms, int queries, int mismatches)
+{
+	printf("%-10s bvh %9.4f ms   brute force %9.4f ms   x%6.1f   (%d queries, %d mismatches)\n",
+		name, bvh_ms / queries, brute_ms / queries, brute_ms / bvh_ms, queries, mismatches);
+}
+
+int main()
+{
+	srand(1);
+	for (int i = 0; i < BENCH_OBJECTS; ++i)
+	{
+		boxes.push_back(random_box());
+		bvh.add(boxes.back());
+	}
+
+	double start = now_ms();
+	bvh.build();
+	double build_ms = now_ms() - start;
+	gfx::engine::SceneBVHStats_T stats = bvh.get_stats();
+	printf("build      %d objects in %.2f ms, %d nodes, %d leaves, depth %d\n\n", stats.objects, build_ms, stats.nodes, stats.leaves, stats.depth);
+
+	// frustum: a camera at random points looking at the origin
+	std::vector<int> found;
+	double bvh_ms = 0.0, brute_ms = 0.0;
+	int mismatches = 0;
+	for (int q = 0; q < BENCH_QUERIES; ++q)
+	{
+		glm::mat4 view_proj = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, BENCH_WORLD_SIZE * 0.25f) *
+			glm::lookAt(random_point(), random_point(), glm::vec3(0, 1, 0));
+		gfx::engine::Frustum_T frustum = Bounds::extract_frustum(view_proj);
+
+		found.clear();
+		start = now_ms();
+		bvh.query_frustum(&frustum, &found);
+		bvh_ms += now_ms() - start;
+
+		start = now_ms();
+		int count = 0;
+		for (int i = 0; i < BENCH_OBJECTS; ++i)
+			count += Bounds::is_visible(&frustum, boxes[i]);
+		brute_ms += now_ms() - start;
+		mismatches += count != found.size();
+	}
+	report("frustum", bvh_ms, brute_ms, BENCH_QUERIES, mismatches);
+
+	// rays: from random points in random directions
+	bvh_ms = brute_ms = 0.0;
+	mismatches = 0;
+	for (int q = 0; q < BENCH_QUERIES; ++q)
+	{
+		glm::vec3 origin = random_point();
+		glm::vec3 dir = glm::normalize(random_point());
+		gfx::engine::BVHRayHit_T hit;
+
+		start = now_ms();
+		bool bvh_hit = bvh.raycast(origin, dir, FLT_MAX, &hit);
+		bvh_ms += now_ms() - start;
+
+		start = now_ms();
+		float best = FLT_MAX;
+		for (int i = 0; i < BENCH_OBJECTS; ++i)
+			best = glm::min(best, ray_box(origin, dir, boxes[i]));
+		brute_ms += now_ms() - start;
+		mismatches += bvh_hit != (best != FLT_MAX) || (bvh_hit && glm::abs(hit.distance - best) > 1e-3f);
+	}
+	report("raycast", bvh_ms, brute_ms, BENCH_QUERIES, mismatches);
+
+	// nearest: random points
+	bvh_ms = brute_ms = 0.0;
+	mismatches = 0;
+	for (int q = 0; q < BENCH_QUERIES; ++q)
+	{
+		glm::vec3 point = random_point();
+		float distance = 0.0f;
+
+		start = now_ms();
+		bvh.nearest(point, FLT_MAX, &distance);
+		bvh_ms += now_ms() - start;
+
+		start = now_ms();
+		float best = FLT_MAX;
+		for (int i = 0; i < BENCH_OBJECTS; ++i)
+		{
+			glm::vec3 offset = glm::max(glm::max(boxes[i].min - point, point - boxes[i].max), glm::vec3(0.0f));
+			best = glm::min(best, glm::dot(offset, offset));
+		}
+		brute_ms += now_ms() - start;
+		mismatches += glm::abs(distance - glm::sqrt(best)) > 1e-3f;
+	}
+	report("nearest", bvh_ms, brute_ms, BENCH_QUERIES, mismatches);
+
+	// refit: move a few percent of the objects a little, as a frame of moving meshes would
+	printf("\n");
+	int moved = BENCH_OBJECTS * BENCH_MOVED_PERCENT / 100;
+	double refit_ms = 0.0;
+	int refit_nodes = 0;
+	for (int q = 0; q < 100; ++q)
+	{
+		for (int m = 0; m < moved; ++m)
+		{
+			int i = rand() % BENCH_OBJECTS;
+			glm::vec3 offset = (glm::vec3(randf(), randf(), randf()) - 0.5f) * 2.0f;
+			boxes[i].min += offset;
+			boxes[i].max += offset;
+			bvh.move(i, boxes[i]);
+		}
+		start = now_ms();
+		bvh.refit();
+		refit_ms += now_ms() - start;
+		refit_nodes += bvh.get_stats().refit_nodes;
+	}
+	printf("refit      %d moved objects in %.4f ms, %d nodes touched, full rebuild %.2f ms\n", moved, refit_ms / 100, refit_nodes / 100, build_ms);
+
+	return 0;
+}
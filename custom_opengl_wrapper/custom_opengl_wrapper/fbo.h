@@ -55,6 +55,13 @@ namespace gfx
 			// Creates a FBO and its render texture and depth buffer
 			void get_frame_buffer(GLuint * FramebufferName, GLuint * colorTexture, GLuint *depthTexture);
 
+			// Deletes the frame buffer and its attachments
+			void release();
+
+			int get_width();
+
+			int get_height();
+
 			// constructors
 
 			FBO();
@@ -71,7 +78,7 @@ namespace gfx
 
 			FBOID m_id;
 
-			GLuint m_tex, m_depth;
+			GLuint m_tex, m_depth, m_depth_buffer = 0;
 
 			int m_width = 0, m_height = 0;
 
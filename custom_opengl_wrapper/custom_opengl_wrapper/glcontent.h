@@ -4,6 +4,10 @@
 #include "glm.h"
 #include "GLCamera.h"
 #include "KeyboardEvents.h"
+#include "FramePacer.h"
+#include "UniformBlock.h"
+#include "Types.h"
+#include "Bounds.h"
 #include <chrono>
 #include <thread>
 
@@ -23,12 +27,30 @@ namespace gfx
 	{
 		typedef void(*GLContentLoop)();
 		typedef void(*GLContentInit)();
+		typedef void(*GLContentRelease)();
+
+		// slots of the camera block, one per projection
+		enum CameraSlot_T
+		{
+			CAMERA_SLOT_PERSPECTIVE,
+			CAMERA_SLOT_EXTERNAL_ORTHO,
+			CAMERA_SLOT_ORTHO,
+			CAMERA_SLOT_PSEUDO_ISOMETRIC,
+			CAMERA_SLOT_HYPER_PERSPECTIVE,
+			// a light's view for rendering shadow maps, see ShadowMapper
+			CAMERA_SLOT_SHADOW,
+			CAMERA_SLOT_COUNT
+		};
 
 		class GLContent
 		{
 		public:
 			void run(GLContentLoop loop, GLContentInit init, GLFWkeyfun key_func, GLFWmousebuttonfun mouse_func);
 
+			// Runs like run, calling release once the window closes while the context is still current,
+			// anything holding GPU objects must free them there as run exits the program afterwards
+			void run(GLContentLoop loop, GLContentInit init, GLFWkeyfun key_func, GLFWmousebuttonfun mouse_func, GLContentRelease release);
+
 			void loadPerspective();
 
 			void loadExternalOrtho();
@@ -49,6 +71,9 @@ namespace gfx
 			glm::mat4 * getViewMat();
 			glm::mat4 * getProjMat();
 
+			// Gets the frustum of the projection and view last loaded, whichever projection that was
+			gfx::engine::Frustum_T * getFrustum();
+
 			void setClearColor(glm::vec3 color);
 
 			void setClearColor(glm::vec4 color);
@@ -84,6 +109,22 @@ namespace gfx
 				return m_frames;
 			}
 
+			// Sets how many frames the CPU may queue ahead of the GPU (1-3)
+			void setFramesInFlight(int frames);
+
+			// Gets the time in milliseconds the CPU waited on the GPU at the start of the last frame
+			float getFrameWaitTime();
+
+			// Re-uploads the camera block, for when the view or projection is changed through getViewMat/getProjMat
+			void updateCameraBlock();
+
+			// Uploads a light's view and projection to the shadow slot of the camera block and binds it,
+			// load a projection again afterwards to go back to drawing from the camera
+			void loadShadowCamera(glm::mat4 view, glm::mat4 proj);
+
+			// Sets the light shared by every program through the Lighting block
+			void setLight(gfx::Light_T light, glm::vec3 ambient_color);
+
 		private:
 			glm::mat4 getExternalOrtho();
 			glm::mat4 getExternalOrthoView();
@@ -105,11 +146,14 @@ namespace gfx
 
 
 			//GL graphics loop
-			void			glLoop(GLContentLoop loop, GLFWwindow * window);
+			void			glLoop(GLContentLoop loop, GLFWwindow * window, GLContentRelease release);
 			//GL window initialise
 			GLFWwindow *				initWindow(gfx::engine::GLContentInit init, GLFWkeyfun key_func, GLFWmousebuttonfun mouse_func);
 
 			void handleKeyEvent();
+
+			// Uploads the view and projection to a camera slot and binds it
+			void loadCameraBlock(int slot);
 		public:
 			//constructors
 
@@ -137,6 +181,8 @@ namespace gfx
 				m_view,
 				m_projection;
 
+			gfx::engine::Frustum_T m_frustum;
+
 			float
 				m_fov = 45.0f,
 				m_aspectRatio = m_windowSize.x / m_windowSize.y,
@@ -150,6 +196,15 @@ namespace gfx
 
 			int m_frames = 0;
 
+			gfx::engine::FramePacer m_framePacer;
+
+			// one camera slot per projection so switching between them doesn't re-upload
+			gfx::engine::UniformBlock
+				m_cameraBlock = gfx::engine::UniformBlock(UBO_BINDING_CAMERA, sizeof(gfx::engine::CameraBlock_T), CAMERA_SLOT_COUNT),
+				m_lightBlock = gfx::engine::UniformBlock(UBO_BINDING_LIGHTING, sizeof(gfx::engine::LightBlock_T));
+
+			int m_cameraSlot = CAMERA_SLOT_PERSPECTIVE;
+
 			
 		};
 
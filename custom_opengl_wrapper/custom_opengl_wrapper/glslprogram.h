@@ -18,6 +18,7 @@ namespace gfx
 		struct GLSLProgram
 		{
 		public:
+			// Adds a handle, pointers from getHandle/getMeshHandle are only stable once all handles are added
 			GLSLProgram * addHandle(VarHandle handle);
 
 			void load();
@@ -39,6 +40,9 @@ namespace gfx
 			GLSLProgram * setTexHandle();
 			GLSLProgram * setTex1Handle();
 
+			// Adds the position dequantise scale and offset uniforms, shaders without them ignore quantised layouts
+			GLSLProgram * setDequantiseHandles();
+
 			VarHandle * getModelMat4Handle();
 
 			VarHandle * getViewMat4Handle();
@@ -53,9 +57,13 @@ namespace gfx
 
 			VarHandle * getTex1Handle();
 
+			VarHandle * getDequantScaleHandle();
+
+			VarHandle * getDequantOffsetHandle();
+
 			MeshHandle_T getMeshHandle()
 			{
-				return {getTexHandle(), getColorHandle(), getFlagHandle(), getModelMat4Handle(), getViewMat4Handle(), getProjMat4Handle()};
+				return {getTexHandle(), getColorHandle(), getFlagHandle(), getModelMat4Handle(), getViewMat4Handle(), getProjMat4Handle(), getDequantScaleHandle(), getDequantOffsetHandle()};
 			}
 
 			//Loads shaders from their files into a shader program (from opengl-tutorials.org)
@@ -75,13 +83,18 @@ namespace gfx
 				const char * m_vertexFilePath;
 				const char * m_fragmentFilePath;
 
-				std::map<VarHandleID, VarHandle> m_handles;
+				// indexed by uniform location, gaps hold inert handles
+				std::vector<VarHandle> m_handles;
+
+				// returned for uniforms the program doesn't have (location -1)
+				VarHandle m_nullHandle;
 
 				VarHandleID
-					m_modelMat, m_viewMat, m_projMat,
-					m_color,
-					m_flag,
-					m_tex, m_tex1;
+					m_modelMat = NULL_VAR_HANDLE_ID, m_viewMat = NULL_VAR_HANDLE_ID, m_projMat = NULL_VAR_HANDLE_ID,
+					m_color = NULL_VAR_HANDLE_ID,
+					m_flag = NULL_VAR_HANDLE_ID,
+					m_tex = NULL_VAR_HANDLE_ID, m_tex1 = NULL_VAR_HANDLE_ID,
+					m_dequantScale = NULL_VAR_HANDLE_ID, m_dequantOffset = NULL_VAR_HANDLE_ID;
 		};
 	}
 }
@@ -12,6 +12,11 @@
 #include "FBOManager.h"
 #include "Mesh.h"
 #include "PrimativeGenerator.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "LODSelector.h"
+#include "OcclusionCuller.h"
+#include "TextureAtlas.h"
 
 #include "CLog.h"
 
@@ -24,14 +29,23 @@ gfx::engine::GLContent content;
 gfx::engine::GLCamera camera = gfx::engine::GLCamera(glm::vec3(0, 0, 0), glm::vec3(), glm::vec3(0,0,-1), glm::vec3(0, 1, 0));
 
 gfx::gui::GFXManager gfxManager;
+// wide enough for both 2048 font sheets side by side with their padding, build trims what isn't used
+gfx::engine::TextureAtlas gui_atlas = gfx::engine::TextureAtlas(glm::ivec2(8192, 2048), TEXTURE_ATLAS_PADDING);
+
+gfx::engine::RenderQueue render_queue;
+gfx::engine::FrustumCuller frustum_culler;
+std::vector<int> visible_meshes;
+gfx::engine::OcclusionCuller occlusion_culler;
+std::vector<gfx::engine::AABB_T> occlusion_candidates;
+std::vector<int> unoccluded_meshes;
+gfx::engine::LODSelector lod_selector;
 
 gfx::engine::Mesh
 screen_texture,
 sphere;
 
 gfx::engine::GLSLProgramID
-RENDER_PROGRAM,
-GUI_PROGRAM;
+RENDER_PROGRAM;
 
 glm::vec3 ambient_color;
 
@@ -64,71 +78,78 @@ void init()
 	RENDER_PROGRAM =
 		program_manager.addProgram("shaders/basic_texture.vert", "shaders/basic_texture.frag",
 			content.getModelMat(), content.getViewMat(), content.getProjMat());
-	GUI_PROGRAM =
-		program_manager.addProgram("shaders/basic_gui.vert", "shaders/basic_gui.frag",
-			content.getModelMat(), content.getViewMat(), content.getProjMat());
 
 	//// ADDING HANDLES TO PROGRAMS
 	CINFO("Adding handles to GLSL programs...");
 	program_manager.getProgram(RENDER_PROGRAM)
 		->setTexHandle();
-	program_manager.getProgram(GUI_PROGRAM)
-		->setColorHandle()
-		->setFlagHandle()
-		->setTexHandle();
 
 	//// CREATE OBJECTS
 	CINFO("Initialising objects...");
 
 	std::vector<glm::vec3> v;
-	v = gfx::PrimativeGenerator::generate_cube();
+	std::vector<gfx::IndexData> lods;
+	v = gfx::PrimativeGenerator::generate_sphere(32, 32);
+	// smooth normals let the sphere weld into one surface the simplifier can collapse, LODSelector picks between them
+	gfx::VertexData data = gfx::PrimativeGenerator::pack_lod_object(&v, GEN_NORMS_SMOOTH | GEN_COLOR_RAND, gfx::WHITE, &lods);
 	sphere = gfx::engine::Mesh(
 		"",
-		gfx::PrimativeGenerator::pack_object(&v, GEN_COLOR_RAND, gfx::WHITE),
+		data,
+		lods,
 		glm::vec3(0, 0, 0),
 		glm::vec3(0, 1, 0), glm::radians(0.0f),
 		glm::vec3(1, 0, 0), glm::radians(90.0f),
 		glm::vec3(1, 1, 1)
 	);
 
-	gfx::gui::GFXColorStyle_T * colorStyle = new gfx::gui::GFXColorStyle_T;
-	colorStyle->colors[0] = gfx::ORANGE_A;
-	colorStyle->colors[1] = gfx::OFF_WHITE_A;
-	colorStyle->colors[2] = gfx::OFF_BLACK_A;
-	gfxManager.setColorStyle(colorStyle);
+	//// PACK GUI TEXTURES
+	// both font sheets share a texture so mixing fonts doesn't split the GUI batch
+	gui_atlas.add(gfx::gui::GFX_Courier_FONT);
+	gui_atlas.add(gfx::gui::GFX_Malgun_Gothic_FONT);
+	if (gui_atlas.build(GL_TEXTURE_2D))
+		gfx::gui::GFXFontCache::setPackedAtlas(&gui_atlas);
 
-	gfx::gui::GFXWindow * window = new gfx::gui::GFXWindow(glm::vec2(50, 50), glm::vec2(300, 300));
-	window->link(&gfx::gui::GFXWindow::onClose, gfx::gui::ACTION(onClosedWindow));
+	gfxManager.setColorStyle(gfxManager.createColorStyle(gfx::ORANGE_A, gfx::OFF_WHITE_A, gfx::OFF_BLACK_A));
+
+	gfx::gui::GFXWindow * window = gfxManager.create<gfx::gui::GFXWindow>(glm::vec2(50, 50), glm::vec2(300, 300));
+	window->link(gfx::gui::GFX_WINDOW_CLOSE, onClosedWindow);
 	gfxManager.addComponent(window);
-	gfx::gui::GFXButton * button = new gfx::gui::GFXButton(glm::vec2(25, 50), glm::vec2(300, 50), "Press Me");
+	gfx::gui::GFXButton * button = gfxManager.create<gfx::gui::GFXButton>(glm::vec2(25, 50), glm::vec2(300, 50), "Press Me");
 	window->addComponent(button);
-	gfx::gui::GFXSpinner * spinner = new gfx::gui::GFXSpinner(glm::vec2(25, 150), glm::vec2(100, 25), 0, 0.33f);
+	gfx::gui::GFXSpinner * spinner = gfxManager.create<gfx::gui::GFXSpinner>(glm::vec2(25, 150), glm::vec2(100, 25), 0, 0.33f);
 	window->addComponent(spinner);
 
-	window = new gfx::gui::GFXWindow(glm::vec2(50, 50), glm::vec2(300, 300));
-	window->link(&gfx::gui::GFXWindow::onClose, gfx::gui::ACTION(onClosedWindow));
+	window = gfxManager.create<gfx::gui::GFXWindow>(glm::vec2(50, 50), glm::vec2(300, 300));
+	window->link(gfx::gui::GFX_WINDOW_CLOSE, onClosedWindow);
 	gfxManager.addComponent(window);
-	spinner = new gfx::gui::GFXSpinner(glm::vec2(25, 50), glm::vec2(100, 25), 0, 0.33f);
+	spinner = gfxManager.create<gfx::gui::GFXSpinner>(glm::vec2(25, 50), glm::vec2(100, 25), 0, 0.33f);
 	window->addComponent(spinner);
-	spinner = new gfx::gui::GFXSpinner(glm::vec2(100, 150), glm::vec2(100, 50), 0, 0.33f);
+	spinner = gfxManager.create<gfx::gui::GFXSpinner>(glm::vec2(100, 150), glm::vec2(100, 50), 0, 0.33f);
 	window->addComponent(spinner);
-	spinner = new gfx::gui::GFXSpinner(glm::vec2(200, 250), glm::vec2(200, 100), 0, 0.33f);
+	spinner = gfxManager.create<gfx::gui::GFXSpinner>(glm::vec2(200, 250), glm::vec2(200, 100), 0, 0.33f);
 	window->addComponent(spinner);
 
-	window = new gfx::gui::GFXWindow(glm::vec2(50, 50), glm::vec2(300, 300));
-	window->link(&gfx::gui::GFXWindow::onClose, gfx::gui::ACTION(onClosedWindow));
+	window = gfxManager.create<gfx::gui::GFXWindow>(glm::vec2(50, 50), glm::vec2(300, 300));
+	window->link(gfx::gui::GFX_WINDOW_CLOSE, onClosedWindow);
 	gfxManager.addComponent(window);
-	gfx::gui::GFXTextEdit * textEdit = new gfx::gui::GFXTextEdit("hello world!", GFX_GUI_DEFAULT_FONT_SIZE, glm::vec2(25, 150), glm::vec2(300,100));
+	gfx::gui::GFXTextEdit * textEdit = gfxManager.create<gfx::gui::GFXTextEdit>("hello world!", GFX_GUI_DEFAULT_FONT_SIZE, glm::vec2(25, 150), glm::vec2(300,100));
 	textEdit->setColor(gfx::RED_A);
 	textEdit->setMultiline(true);
 	window->addComponent(textEdit);
-	gfx::gui::GFXScrollBar * vScrollBar = new gfx::gui::GFXScrollBar(glm::vec2(200, 25), glm::vec2(25, 200), 0,0.2f, true);
+	gfx::gui::GFXScrollBar * vScrollBar = gfxManager.create<gfx::gui::GFXScrollBar>(glm::vec2(200, 25), glm::vec2(25, 200), 0,0.2f, true);
 	window->addComponent(vScrollBar);
 
 	gfxManager.init();
 	gfxManager.validate();
 }
 
+// Frees the GUI's and the atlas's GPU objects while the context they were made in is still current
+void release()
+{
+	gfxManager.release();
+	gui_atlas.release();
+}
+
 void physics()
 {
 	sphere.m_theta += 0.001f;
@@ -145,19 +166,38 @@ void draw_loop()
 
 	gfx::engine::FBO::unbind();
 
-	gfx::engine::MeshHandle_T meshHandle;
-
 	content.clearAll();
 	content.loadPseudoIsometric();
-	program_manager.loadProgram(RENDER_PROGRAM);
-	meshHandle = program_manager.getCurrentProgram()->getMeshHandle();
-	sphere.draw(0, meshHandle);
+
+	gfx::engine::Mesh * scene[] = { &sphere };
+	frustum_culler.clear();
+	for (gfx::engine::Mesh * m : scene)
+		frustum_culler.add(m->get_world_bounds());
+	visible_meshes.clear();
+	frustum_culler.cull(content.getFrustum(), &visible_meshes);
+
+	// occluders are queued between begin and render, anything left in view behind them is dropped
+	occlusion_culler.begin(*content.getProjMat() * *content.getViewMat());
+	occlusion_culler.render();
+	occlusion_candidates.clear();
+	for (int i : visible_meshes)
+		occlusion_candidates.push_back(scene[i]->get_world_bounds().box);
+	unoccluded_meshes.clear();
+	occlusion_culler.test(&occlusion_candidates, &unoccluded_meshes);
+
+	render_queue.clear();
+	for (int j : unoccluded_meshes)
+	{
+		int i = visible_meshes[j];
+		lod_selector.select(scene[i], content.getViewMat(), content.getProjMat());
+		render_queue.add(scene[i], RENDER_PROGRAM, RENDER_PASS_OPAQUE, glm::length(scene[i]->m_pos - *content.getEyePos()));
+	}
+	render_queue.sort();
+	render_queue.submit(&program_manager);
 
 	content.clearDepthBuffer();
 	content.loadExternalOrtho();
-	program_manager.loadProgram(GUI_PROGRAM);
-	meshHandle = program_manager.getCurrentProgram()->getMeshHandle();
-	gfxManager.draw(glm::mat4(1.0f), meshHandle);
+	gfxManager.draw(&content);
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
@@ -201,6 +241,6 @@ static void	key_callback(GLFWwindow* window, int key, int scancode, int action,
 int main()
 {
 	content.setClearColor(gfx::GREY);
-	content.run(draw_loop, init, key_callback, mouse_button_callback);
+	content.run(draw_loop, init, key_callback, mouse_button_callback, release);
 	return 0;
 }
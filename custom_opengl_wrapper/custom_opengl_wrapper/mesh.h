@@ -5,12 +5,22 @@
 #include "ImageLoader.h"
 #include "VarHandle.h"
 #include "Types.h"
+#include "VertexLayout.h"
+#include "InstanceSet.h"
+#include "Bounds.h"
 #include <vector>
 
 namespace gfx
 {
 	namespace engine
 	{
+		// A level of detail, a range of the mesh's IBO
+		struct MeshLOD_T
+		{
+			int first;
+			int count;
+		};
+
 		// This is a struct for a Mesh.
 		// Holds VBO, texture and entity properties.
 		class Mesh
@@ -19,6 +29,27 @@ namespace gfx
 			// Buffers Vertex data into the VBO
 			void init(std::vector<gfx::Vertex_T> * d);
 
+			// Buffers Vertex data into the VBO and indices into the IBO
+			void init(std::vector<gfx::Vertex_T> * d, std::vector<GLuint> * indices);
+
+			// Buffers Vertex data into the VBO packed with the given layout
+			void init(std::vector<gfx::Vertex_T> * d, VertexLayout layout);
+
+			// Buffers Vertex data into the VBO packed with the given layout and indices into the IBO
+			void init(std::vector<gfx::Vertex_T> * d, std::vector<GLuint> * indices, VertexLayout layout);
+
+			// Buffers Vertex data into the VBO and each LOD's indices one after another into the IBO, finest first
+			void init(std::vector<gfx::Vertex_T> * d, std::vector<std::vector<GLuint>> * lods);
+
+			// Sets which LOD is drawn, clamped to the LODs there are
+			void set_lod(int lod);
+
+			// Gets which LOD is drawn
+			int get_lod();
+
+			// Gets the number of LODs, 1 for a mesh without any
+			int get_lod_count();
+
 			// Loads image file into a texture
 			void load_textures(const char *texfilename);
 
@@ -28,14 +59,31 @@ namespace gfx
 			// Draws just the VBO and activating the texture
 			void draw_array(int wire_frame, VarHandle *texture_handle);
 
+			// Issues just the draw call, the VAO and texture must already be bound
+			void draw_call(int wire_frame);
+
+			// Draws every instance in the set with one call, the model matrix is applied on top of each instance's
+			void draw_instanced(int wire_frame, InstanceSet * instances, gfx::engine::MeshHandle_T handles);
+
+			// Binds the texture to its unit and loads the texture handle
+			void activate_texture(VarHandle * texture_handle);
+
 			// Override the texture handle seperately
 			void load_texture_handle(VarHandle * handle);
 
 			// Sets the texture
 			void set_tex(GLuint tex);
+			// Sets the texture and what it's bound as, GL_TEXTURE_2D_ARRAY for an array TextureAtlas
+			void set_tex(GLuint tex, GLenum target);
+
+			// Loads the layout's dequantise scale and offset, the shader applies them to the positions before the model matrix
+			void load_dequantise(gfx::engine::MeshHandle_T handles);
 
 			// Get the model matrix
 			glm::mat4 get_model_mat();
+
+			// Get the bounds in world space at the current position, rotation and scale
+			Bounds_T get_world_bounds();
 			
 
 			Mesh();
@@ -52,12 +100,52 @@ namespace gfx
 				glm::vec3 _scale
 			);
 
+			// Texture filename, Vertex data pack, index list, world position, dynamic axis of rotation, and amount, static axis of rotation, and amount, scale vector. 
+			Mesh(
+				const char *texfilename,
+				std::vector<gfx::Vertex_T>	data,
+				std::vector<GLuint> indices,
+				glm::vec3 _pos,
+				glm::vec3 _rotation,
+				GLfloat _theta,
+				glm::vec3 _pre_rotation,
+				GLfloat _pre_theta,
+				glm::vec3 _scale
+			);
+
+			// Texture filename, Vertex data pack, index list per LOD (see MeshSimplifier::build_lods), world position, dynamic axis of rotation, and amount, static axis of rotation, and amount, scale vector. 
+			Mesh(
+				const char *texfilename,
+				std::vector<gfx::Vertex_T>	data,
+				std::vector<std::vector<GLuint>> lods,
+				glm::vec3 _pos,
+				glm::vec3 _rotation,
+				GLfloat _theta,
+				glm::vec3 _pre_rotation,
+				GLfloat _pre_theta,
+				glm::vec3 _scale
+			);
+
 			GLuint
 				m_vao,
 				m_buffer,
+				m_ibo = 0,
 				m_tex = GL_TEXTURE0;
 			int
-				m_data_size = 0;
+				m_data_size = 0,
+				m_index_count = 0;
+			GLenum
+				m_index_type = GL_UNSIGNED_INT,
+				m_tex_target = GL_TEXTURE_2D;
+
+			VertexLayout m_layout;
+
+			// index ranges of each LOD in the IBO, empty for a mesh drawn without indices
+			std::vector<MeshLOD_T> m_lods;
+			int m_lod = 0;
+
+			// bounds of the vertex positions, worked out by init
+			Bounds_T m_bounds = Bounds::from_box(glm::vec3(0.0f), glm::vec3(0.0f));
 
 			glm::vec3
 				m_rotation = glm::vec3(0, 1, 0),
@@ -67,6 +155,10 @@ namespace gfx
 			GLfloat
 				m_theta,
 				m_pre_theta;
+
+		private:
+			// Gets the byte offset of the drawn LOD in the IBO
+			const GLvoid * get_lod_offset();
 		};
 	}
 }
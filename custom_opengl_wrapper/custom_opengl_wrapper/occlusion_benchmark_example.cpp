@@ -0,0 +1,161 @@
+// Times OcclusionCuller on a city block: building boxes as occluders and many small objects
+// scattered between and behind them. Every object reported occluded is checked by casting rays
+// from the eye to points on its box against the occluder triangles.
+// CPU only, so it runs on machines without a GPU. Build it on its own with
+// OcclusionCuller.cpp and Bounds.cpp in place of main.cpp.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <float.h>
+
+#include "OcclusionCuller.h"
+
+#define BENCH_BUILDINGS_ACROSS 12
+#define BENCH_BLOCK_SIZE 20.0f
+#define BENCH_OBJECTS 20000
+#define BENCH_FRAMES 200
+
+using gfx::engine::AABB_T;
+using gfx::engine::OcclusionCuller;
+
+std::vector<glm::vec3> cube_positions;
+std::vector<GLuint> cube_indices;
+std::vector<glm::mat4> buildings;
+std::vector<AABB_T> objects;
+
+inline float randf()
+{
+	return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+}
+
+double now_ms()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+// a unit cube from 0 to 1, scaled into each building
+void build_cube()
+{
+	for (int i = 0; i < 8; ++i)
+		cube_positions.push_back(glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+	GLuint faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+	for (auto & f : faces)
+	{
+		GLuint tri[6] = { f[0], f[1], f[2], f[2], f[3], f[0] };
+		cube_indices.insert(cube_indices.end(), tri, tri + 6);
+	}
+}
+
+// Moller-Trumbore, the distance along the ray or FLT_MAX
+float ray_triangle(glm::vec3 origin, glm::vec3 dir, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	glm::vec3 e1 = b - a, e2 = c - a, p = glm::cross(dir, e2);
+	float det = glm::dot(e1, p);
+	if (glm::abs(det) < 1e-8f)
+		return FLT_MAX;
+	float inv = 1.0f / det;
+	glm::vec3 s = origin - a;
+	float u = glm::dot(s, p) * inv;
+	if (u < 0.0f || u > 1.0f)
+		return FLT_MAX;
+	glm::vec3 q = glm::cross(s, e1);
+	float v = glm::dot(dir, q) * inv;
+	if (v < 0.0f || u + v > 1.0f)
+		return FLT_MAX;
+	float t = glm::dot(e2, q) * inv;
+	return t > 0.0f ? t : FLT_MAX;
+}
+
+// whether the segment from the eye to a point passes through any building
+bool blocked(glm::vec3 eye, glm::vec3 point)
+{
+	glm::vec3 dir = point - eye;
+	for (glm::mat4 & model : buildings)
+		for (size_t i = 0; i < cube_indices.size(); i += 3)
+		{
+			glm::vec3
+				a = glm::vec3(model * glm::vec4(cube_positions[cube_indices[i]], 1.0f)),
+				b = glm::vec3(model * glm::vec4(cube_positions[cube_indices[i + 1]], 1.0f)),
+				c = glm::vec3(model * glm::vec4(cube_positions[cube_indices[i + 2]], 1.0f));
+			if (ray_triangle(eye, dir, a, b, c) < 1.0f)
+				return true;
+		}
+	return false;
+}
+
+int main()
+{
+	srand(1);
+	build_cube();
+
+	// a grid of buildings with streets between them
+	float street = BENCH_BLOCK_SIZE * 0.3f;
+	for (int z = 0; z < BENCH_BUILDINGS_ACROSS; ++z)
+		for (int x = 0; x < BENCH_BUILDINGS_ACROSS; ++x)
+		{
+			glm::vec3 corner = glm::vec3(x - BENCH_BUILDINGS_ACROSS / 2, 0, -z - 1) * BENCH_BLOCK_SIZE;
+			glm::vec3 size = glm::vec3(BENCH_BLOCK_SIZE - street, 10.0f + randf() * 40.0f, BENCH_BLOCK_SIZE - street);
+			buildings.push_back(glm::scale(glm::translate(glm::mat4(1.0f), corner), size));
+		}
+
+	// small objects anywhere in the city, some in the streets and some inside the blocks
+	float extent = BENCH_BUILDINGS_ACROSS * BENCH_BLOCK_SIZE;
+	for (int i = 0; i < BENCH_OBJECTS; ++i)
+	{
+		glm::vec3 center = glm::vec3((randf() - 0.5f) * extent, randf() * 8.0f, -randf() * extent);
+		glm::vec3 half = glm::vec3(0.5f + randf());
+		objects.push_back({ center - half, center + half });
+	}
+
+	glm::vec3 eye = glm::vec3(street * 0.5f - BENCH_BLOCK_SIZE * 0.5f, 2.0f, 5.0f);
+	glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.1f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+	int threads[] = { 1, 2, 4 };
+	std::vector<int> visible;
+	for (int t : threads)
+	{
+		OcclusionCuller culler(OCCLUSION_DEFAULT_WIDTH, OCCLUSION_DEFAULT_HEIGHT, t);
+		double render_ms = 0.0, test_ms = 0.0;
+		for (int frame = 0; frame < BENCH_FRAMES; ++frame)
+		{
+			culler.begin(proj * view);
+			for (glm::mat4 & model : buildings)
+				culler.add_occluder(&cube_positions, &cube_indices, model);
+			double start = now_ms();
+			culler.render();
+			render_ms += now_ms() - start;
+
+			visible.clear();
+			start = now_ms();
+			culler.test(&objects, &visible);
+			test_ms += now_ms() - start;
+		}
+		gfx::engine::OcclusionStats_T stats = culler.get_stats();
+		printf("%d thread%s  render %7.4f ms (%d/%d triangles)   test %7.4f ms (%.1f ns/box)   %d of %d occluded\n",
+			t, t > 1 ? "s" : " ", render_ms / BENCH_FRAMES, stats.triangles_rasterised, stats.triangles,
+			test_ms / BENCH_FRAMES, test_ms / BENCH_FRAMES / BENCH_OBJECTS * 1e6, stats.occluded, stats.tested);
+	}
+
+	// check the culled objects really are hidden: rays to the corners and center of each box
+	std::vector<bool> shown(objects.size(), false);
+	for (int i : visible)
+		shown[i] = true;
+	int checked = 0, wrong = 0;
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		if (shown[i])
+			continue;
+		AABB_T & box = objects[i];
+		bool hidden = blocked(eye, (box.min + box.max) * 0.5f);
+		for (int c = 0; c < 8 && hidden; ++c)
+			hidden = blocked(eye, glm::vec3(c & 1 ? box.max.x : box.min.x, c & 2 ? box.max.y : box.min.y, c & 4 ? box.max.z : box.min.z));
+		checked++;
+		if (!hidden)
+			wrong++;
+	}
+	printf("\n%d occluded objects checked by ray cast, %d had a point in view\n", checked, wrong);
+	return 0;
+}
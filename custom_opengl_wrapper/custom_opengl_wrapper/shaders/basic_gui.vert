@@ -10,8 +10,12 @@ layout(location = 3) in vec2 i_uv;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
 // outs
 out vec3 o_color;
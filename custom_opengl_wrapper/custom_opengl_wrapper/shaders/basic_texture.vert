@@ -10,8 +10,15 @@ layout(location = 3) in vec2 i_uv;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
+// maps VF_UNORM16 positions back to model space, the defaults leave float positions alone
+uniform vec3 u_dequant_scale = vec3(1.0f);
+uniform vec3 u_dequant_offset = vec3(0.0f);
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
 // outs
 out vec3 o_color;
@@ -21,7 +28,7 @@ out vec2 o_uv;
 void main()
 {
 // calculate world position of vertex
-	vec4 world_pos = u_m * vec4(i_vert, 1.0f);
+	vec4 world_pos = u_m * vec4(i_vert * u_dequant_scale + u_dequant_offset, 1.0f);
 
 // color of vertex
 	o_color        = i_color;
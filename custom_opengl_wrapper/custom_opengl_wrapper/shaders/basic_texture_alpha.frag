@@ -8,8 +8,12 @@ in vec2 o_uv;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
 uniform sampler2D u_tex;
 
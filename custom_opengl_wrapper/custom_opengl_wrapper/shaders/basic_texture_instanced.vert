@@ -0,0 +1,46 @@
+#version 400 core
+
+
+
+// ins
+layout(location = 0) in vec3 i_vert;
+layout(location = 1) in vec3 i_color;
+layout(location = 2) in vec3 i_norm;
+layout(location = 3) in vec2 i_uv;
+
+// per instance ins (InstanceSet)
+layout(location = 5) in mat4 i_model;
+layout(location = 9) in vec4 i_instance_color;
+
+// uniforms
+// shared by every instance, applied on top of i_model
+uniform mat4 u_m;
+// maps VF_UNORM16 positions back to model space before any transform, the defaults leave float positions alone
+uniform vec3 u_dequant_scale = vec3(1.0f);
+uniform vec3 u_dequant_offset = vec3(0.0f);
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
+
+// outs
+out vec3 o_color;
+out vec2 o_uv;
+
+
+void main()
+{
+// calculate world position of vertex
+	vec4 world_pos = u_m * i_model * vec4(i_vert * u_dequant_scale + u_dequant_offset, 1.0f);
+
+// color of vertex
+	o_color        = i_color * i_instance_color.rgb;
+
+// uv tex coord
+	o_uv		   = i_uv;
+
+// set projected point
+	gl_Position    = u_p * u_v * world_pos;	
+}
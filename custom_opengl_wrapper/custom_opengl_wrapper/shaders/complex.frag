@@ -13,17 +13,25 @@ in vec2 o_uv;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
-
-uniform vec3 u_light_pos;
-uniform vec3 u_eye_pos;
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
+
+layout(std140) uniform Lighting
+{
+	vec3 u_light_pos;
+	vec3 u_light_color;
+	vec3 u_light_properties;
+	vec3 u_ambient_color;
+};
 
 uniform float u_specular_scale;
 uniform float u_shininess;
 uniform float u_brightness;
 
-uniform vec3 u_ambient_color;
 uniform vec3 u_diffuse_color;
 
 uniform sampler2D u_tex;
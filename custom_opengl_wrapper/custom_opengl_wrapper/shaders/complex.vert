@@ -11,11 +11,23 @@ layout(location = 4) in vec3 i_tang;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
+// maps VF_UNORM16 positions back to model space, the defaults leave float positions alone
+uniform vec3 u_dequant_scale = vec3(1.0f);
+uniform vec3 u_dequant_offset = vec3(0.0f);
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
-uniform vec3 u_light_pos;
-uniform vec3 u_eye_pos;
+layout(std140) uniform Lighting
+{
+	vec3 u_light_pos;
+	vec3 u_light_color;
+	vec3 u_light_properties;
+	vec3 u_ambient_color;
+};
 
 // outs
 out vec3 o_color;
@@ -30,7 +42,7 @@ out vec2 o_uv;
 void main()
 {
 // calculate world position of vertex
-	vec4 world_pos = u_m * vec4(i_vert, 1.0f);
+	vec4 world_pos = u_m * vec4(i_vert * u_dequant_scale + u_dequant_offset, 1.0f);
 
 // normal in world space
 	vec4 new_norm  = u_m * vec4(i_norm,1);
@@ -0,0 +1,28 @@
+#version 400 core
+
+
+
+// ins
+in vec4 o_color;
+in vec2 o_uv;
+flat in int o_mode;
+
+// uniforms
+uniform sampler2D u_tex;
+
+
+
+out vec4 out_color;
+
+void main() 
+{		
+	vec4 texture_color = texture2D(u_tex, o_uv);
+	vec4 font_color = o_color;
+	font_color *= texture_color;
+	font_color.a = texture_color.r;
+	// layers hold premultiplied colour, undo it for the usual alpha blend
+	vec4 layer_color = vec4(texture_color.rgb / max(texture_color.a, 0.0001f), texture_color.a);
+
+// apply fragment color
+	out_color = o_mode == 1 ? font_color : (o_mode == 2 ? texture_color : (o_mode == 3 ? layer_color : o_color));
+}
\ No newline at end of file
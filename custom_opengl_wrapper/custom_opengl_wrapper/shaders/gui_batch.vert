@@ -0,0 +1,38 @@
+#version 400 core
+
+
+
+// ins
+layout(location = 0) in vec2 i_vert;
+layout(location = 1) in vec4 i_color;
+layout(location = 2) in float i_mode;
+layout(location = 3) in vec2 i_uv;
+
+// uniforms
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
+
+// outs
+out vec4 o_color;
+out vec2 o_uv;
+flat out int o_mode;
+
+
+void main()
+{
+// color of vertex
+	o_color        = i_color;
+
+// uv tex coord
+	o_uv		   = i_uv;
+
+// shading mode, see GFX_GUI_SHADER_*
+	o_mode         = int(i_mode + 0.5f);
+
+// vertices are already in window space
+	gl_Position    = u_p * u_v * vec4(i_vert, 0.0f, 1.0f);
+}
\ No newline at end of file
@@ -8,8 +8,15 @@ layout(location = 1) in vec3 i_color;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
+// maps VF_UNORM16 positions back to model space, the defaults leave float positions alone
+uniform vec3 u_dequant_scale = vec3(1.0f);
+uniform vec3 u_dequant_offset = vec3(0.0f);
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
 // outs
 out vec3 o_color;
@@ -24,5 +31,5 @@ void main()
 	o_pos          = i_vert;
 
 // set projected point
-	gl_Position    = u_p * u_v * u_m * vec4(i_vert, 1.0f);	
+	gl_Position    = u_p * u_v * u_m * vec4(i_vert * u_dequant_scale + u_dequant_offset, 1.0f);	
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#version 400 core
+precision highp float;
+
+
+// ins
+layout(location = 0) in vec3 i_vert;
+layout(location = 1) in vec3 i_color;
+layout(location = 2) in vec3 i_norm;
+
+// per instance ins (InstanceSet)
+layout(location = 5) in mat4 i_model;
+layout(location = 9) in vec4 i_instance_color;
+
+// uniforms
+// shared by every instance, applied on top of i_model
+uniform mat4 u_m;
+// maps VF_UNORM16 positions back to model space before any transform, the defaults leave float positions alone
+uniform vec3 u_dequant_scale = vec3(1.0f);
+uniform vec3 u_dequant_offset = vec3(0.0f);
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
+
+// outs
+out vec3 o_color;
+out vec3 o_v_pos;
+out vec3 o_norm;
+
+void main()
+{
+	mat4 v_m        = u_v * u_m * i_model;
+	mat3 n          = mat3(transpose(inverse(v_m)));
+
+	vec4 m_pos		= v_m * vec4(i_vert * u_dequant_scale + u_dequant_offset, 1.0f);
+
+// color of vertex
+	o_color			= i_color * i_instance_color.rgb;
+
+// normal in world space
+	o_norm          = n * i_norm;
+
+// view position	
+	o_v_pos         = m_pos.xyz;
+
+// set projected point
+	gl_Position		= u_p * m_pos;	
+}
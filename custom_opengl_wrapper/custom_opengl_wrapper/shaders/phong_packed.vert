@@ -0,0 +1,56 @@
+#version 400 core
+precision highp float;
+
+
+// ins
+layout(location = 0) in vec3 i_vert;
+layout(location = 1) in vec3 i_color;
+// octahedral encoded normal (VertexLayout VF_OCT16)
+layout(location = 2) in vec2 i_norm;
+
+// uniforms
+uniform mat4 u_m;
+// maps VF_UNORM16 positions back to model space, the defaults leave float positions alone
+uniform vec3 u_dequant_scale = vec3(1.0f);
+uniform vec3 u_dequant_offset = vec3(0.0f);
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
+
+// outs
+out vec3 o_color;
+out vec3 o_v_pos;
+out vec3 o_norm;
+
+// unfolds an octahedral encoded unit vector
+vec3 oct_decode(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+	if (v.z < 0.0f)
+		v.xy = (1.0f - abs(v.yx)) * vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+	return normalize(v);
+}
+
+void main()
+{
+	mat4 n4          = transpose(inverse(u_v*u_m));
+	mat3 n = mat3(n4);
+
+	mat4 v_m        = u_v * u_m;
+	vec4 m_pos		= v_m * vec4(i_vert * u_dequant_scale + u_dequant_offset, 1.0f);
+
+// color of vertex
+	o_color			= i_color;
+
+// normal in world space
+	o_norm          = n * oct_decode(i_norm);
+
+// view position	
+	o_v_pos         = m_pos.xyz;
+
+// set projected point
+	gl_Position		= u_p * m_pos;	
+}
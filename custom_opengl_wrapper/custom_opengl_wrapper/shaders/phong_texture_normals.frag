@@ -13,15 +13,20 @@ varying  vec3 o_binorm;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
-
-uniform vec3 u_light_pos;
-uniform vec3 u_eye_pos;
-uniform vec3 u_light_properties;
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
-uniform vec3 u_ambient_color;
-uniform vec3 u_light_color;
+layout(std140) uniform Lighting
+{
+	vec3 u_light_pos;
+	vec3 u_light_color;
+	vec3 u_light_properties;
+	vec3 u_ambient_color;
+};
 
 uniform sampler2D u_tex;
 uniform sampler2D u_norm;
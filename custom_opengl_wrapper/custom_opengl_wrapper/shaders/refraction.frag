@@ -10,10 +10,12 @@ in vec3 o_v_pos;
 
 // uniforms
 uniform mat4 u_m;
-uniform mat4 u_v;
-uniform mat4 u_p;
-
-uniform vec3 u_eye_pos;
+layout(std140) uniform Camera
+{
+	mat4 u_v;
+	mat4 u_p;
+	vec3 u_eye_pos;
+};
 
 uniform sampler2D u_tex;
 
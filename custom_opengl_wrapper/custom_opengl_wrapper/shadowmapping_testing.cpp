@@ -185,11 +185,8 @@ void draw_loop()
 	content.loadPerspective();
 	program_manager.load_program(PHONG_TEXTURE_PROGRAM);
 	model_mat_handle = program_manager.get_current_program()->get_model_mat4_handle();
-	view_mat_handle = program_manager.get_current_program()->get_view_mat4_handle();
-	proj_mat_handle = program_manager.get_current_program()->get_proj_mat4_handle();
 	texture_handle = program_manager.get_current_program()->get_tex_handle();	
-	shadow_map1.load_mats(view_mat_handle, proj_mat_handle);
-	shadow_map1.render_shadowmap(model_mat_handle, texture_handle);
+	shadow_map1.render_shadowmap(&content, model_mat_handle, texture_handle);
 
 	content.clearAll();
 	content.loadPerspective();
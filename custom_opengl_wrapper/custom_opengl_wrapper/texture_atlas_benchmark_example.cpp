@@ -0,0 +1,107 @@
+// Packs GUI sized images and the files in textures/ with TexturePacker and TextureAtlas, checks no two
+// images overlap (padding included) and reports pages, occupancy and time.
+// CPU only, GL calls can be stubbed out. Build it on its own with TexturePacker.cpp, TextureAtlas.cpp,
+// ImageLoader.cpp and GLStateCache.cpp in place of main.cpp, and run it from the project directory.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "TexturePacker.h"
+#include "TextureAtlas.h"
+
+#define BENCH_ICONS 2000
+#define BENCH_PAGE_SIZE 1024
+#define BENCH_PADDING 2
+
+using gfx::PackedRect_T;
+using gfx::TexturePacker;
+using gfx::engine::TextureAtlas;
+
+inline float randf()
+{
+	return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+}
+
+double now_ms()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+// rects overlapping each other once grown by the padding, or running off their page
+int count_overlaps(std::vector<PackedRect_T> * rects, glm::ivec2 page_size, int padding)
+{
+	int bad = 0;
+	for (size_t i = 0; i < rects->size(); ++i)
+	{
+		PackedRect_T & a = (*rects)[i];
+		if (a.x < 0 || a.y < 0 || a.x + a.w > page_size.x || a.y + a.h > page_size.y)
+			bad++;
+		for (size_t j = i + 1; j < rects->size(); ++j)
+		{
+			PackedRect_T & b = (*rects)[j];
+			if (a.page == b.page &&
+				a.x < b.x + b.w + padding && b.x < a.x + a.w + padding &&
+				a.y < b.y + b.h + padding && b.y < a.y + a.h + padding)
+				bad++;
+		}
+	}
+	return bad;
+}
+
+void report(const char * name, std::vector<glm::ivec2> * sizes, glm::ivec2 page_size)
+{
+	std::vector<PackedRect_T> rects;
+	double start = now_ms();
+	int pages = TexturePacker::pack(sizes, page_size, BENCH_PADDING, &rects);
+	double ms = now_ms() - start;
+	printf("%-22s %5d images  %2d pages of %dx%d  occupancy %5.1f%%  %7.2f ms  %d overlaps\n",
+		name, (int)sizes->size(), pages, page_size.x, page_size.y,
+		TexturePacker::get_occupancy(&rects, page_size, pages) * 100.0f, ms, count_overlaps(&rects, page_size, BENCH_PADDING));
+}
+
+int main()
+{
+	srand(1);
+	std::vector<glm::ivec2> sizes;
+
+	// icons and widget skins, mostly small and square-ish
+	for (int i = 0; i < BENCH_ICONS; ++i)
+		sizes.push_back(glm::ivec2(16 + rand() % 48, 16 + rand() % 48));
+	report("small icons", &sizes, glm::ivec2(BENCH_PAGE_SIZE));
+
+	// a power of two mix, which skyline packs nearly perfectly
+	sizes.clear();
+	for (int i = 0; i < BENCH_ICONS; ++i)
+		sizes.push_back(glm::ivec2(16 << (rand() % 3)));
+	report("power of two squares", &sizes, glm::ivec2(BENCH_PAGE_SIZE));
+
+	// long thin strips like button borders and scroll bars
+	sizes.clear();
+	for (int i = 0; i < BENCH_ICONS; ++i)
+		sizes.push_back(randf() < 0.5f ? glm::ivec2(8 + rand() % 8, 64 + rand() % 192) : glm::ivec2(64 + rand() % 192, 8 + rand() % 8));
+	report("strips", &sizes, glm::ivec2(BENCH_PAGE_SIZE));
+
+	// the textures shipped in textures/, stars.jpg is too big for a page and is left out
+	printf("\n");
+	const char * files[] = {
+		"textures/151.jpg", "textures/158.jpg", "textures/165.jpg", "textures/197.bmp",
+		"textures/gfx_default.png", "textures/Malgun_Gothic.png", "textures/mars.jpg", "textures/stars.jpg" };
+	GLenum targets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY };
+	for (GLenum target : targets)
+	{
+		TextureAtlas atlas;
+		int added = 0;
+		for (const char * file : files)
+			if (atlas.add(file) >= 0)
+				added++;
+		double start = now_ms();
+		atlas.build(target);
+		double ms = now_ms() - start;
+		printf("textures/ as %-20s %d of %d files on %d pages, occupancy %.1f%%, build %.1f ms\n",
+			target == GL_TEXTURE_2D ? "GL_TEXTURE_2D" : "GL_TEXTURE_2D_ARRAY",
+			added, (int)(sizeof(files) / sizeof(files[0])), atlas.get_page_count(), atlas.get_occupancy() * 100.0f, ms);
+	}
+	return 0;
+}
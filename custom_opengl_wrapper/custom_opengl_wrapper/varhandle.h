@@ -13,11 +13,15 @@ namespace gfx
 	{
 		typedef GLuint VarHandleID;
 
+		// Location given to uniforms that don't exist in the program
+		const VarHandleID NULL_VAR_HANDLE_ID = (VarHandleID)-1;
+
 		class VarHandle
 		{
 		public:
 			void init(GLuint program);
 
+			// Uploads the bound data, every load skips the upload if the value matches the last one sent
 			void load();
 			void load(glm::mat4 data);
 			void load(glm::vec3 data);
@@ -32,6 +36,9 @@ namespace gfx
 
 			VarHandleID get_handle_id();
 
+			// Forgets the last uploaded value so the next load always reaches GL
+			void invalidate();
+
 			const char * get_handle_name();
 
 			VarHandle();
@@ -53,6 +60,11 @@ namespace gfx
 			GLuint * m_data_i;
 			int * m_data_ii;
 			int m_handle_type;
+
+			// the last value sent to this uniform
+			bool changed(const void * data, size_t size);
+			GLfloat m_shadow[16];
+			bool m_shadow_valid = false;
 		};
 
 		struct MeshHandle_T
@@ -63,6 +75,8 @@ namespace gfx
 			VarHandle * modelMatHandle;
 			VarHandle * viewMatHandle;
 			VarHandle * projMatHandle;
+			VarHandle * dequantScaleHandle;
+			VarHandle * dequantOffsetHandle;
 		};
 	}
 }